@@ -0,0 +1,53 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "Functions.hpp"
+#include "Bench.hpp"
+
+int main(int argc, char* argv[]) {
+    // Opciones: --escala <factor>, --repeticiones <n>, --semilla <n>, --esquema <nombre> (repetible), --etiqueta <texto>, --salida <archivo>
+    bench_options options;
+    string output_path;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--escala" && has_value && atof(argv[i + 1]) > 0) {
+            options.scale = atof(argv[++i]);
+        } else if (option == "--repeticiones" && has_value && is_integer(argv[i + 1])) {
+            options.repetitions = stoi(argv[++i]);
+        } else if (option == "--semilla" && has_value && is_integer(argv[i + 1])) {
+            options.seed = (unsigned) stoll(argv[++i]);
+        } else if (option == "--esquema" && has_value) {
+            options.schemas.push_back(argv[++i]);
+        } else if (option == "--etiqueta" && has_value) {
+            options.label = argv[++i];
+        } else if (option == "--salida" && has_value) {
+            output_path = argv[++i];
+        } else {
+            cout << "Usage: Bench [--escala <factor>] [--repeticiones <n>] [--semilla <n>] [--esquema <wide|deep|diamond|union|mixed>] "
+                    "[--etiqueta <texto>] [--salida <archivo>]" << '\n';
+            return 1;
+        }
+    }
+
+    // Los resultados se agregan al archivo para poder comparar corridas de distintos commits
+    ofstream file;
+    if (!output_path.empty()) {
+        file.open(output_path, ios::app);
+        if (!file) {
+            cout << "Error: Couldn't open '" << output_path << "'." << '\n';
+            return 1;
+        }
+    }
+
+    try {
+        run_bench(options, [&](const string& line) {
+            cout << line << '\n' << flush;
+            if (file.is_open()) file << line << '\n' << flush;
+        });
+    } catch (exception& e) {
+        cout << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,384 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <random>
+#include <chrono>
+#include <cmath>
+#include "Functions.hpp"
+#include "Output.hpp"
+#include "Pipeline.hpp"
+#include "Export.hpp"
+#include "Transaction.hpp"
+#include "Interpreter.hpp"
+
+/**
+ * Options of a benchmark run.
+ *
+ * scale multiplies the size of every schema (1 gives wide structs of 1e5 fields, 1e4 levels of nesting, unions of 1e5
+ * alternatives, diamond DAGs of about 1e5 leaves and mixed schemas of 2e4 types). Each operation is run repetitions
+ * times on a fresh table. Only the schemas named in schemas are run (all of them if empty). label is copied to every
+ * result, so the results of several commits can be kept in one file and told apart.
+ */
+struct bench_options {
+    double scale = 1;
+    int repetitions = 1;
+    unsigned seed = 1;
+    vector<string> schemas = {};
+    string label = "";
+};
+
+/**
+ * Synthetic schema: its definitions in an order in which each one only refers to the previous ones, and root, the struct
+ * the DESCRIBIR strategies are measured on.
+ */
+struct bench_schema {
+    string name;
+    vector<type_definition> definitions;
+    string root;
+};
+
+/**
+ * Atomic types shared by every schema, with the sizes and alignments of a 64-bit target.
+ */
+const vector<type_definition> BENCH_ATOMICS = {
+    {ATOMIC, "b_char", 1, 1},
+    {ATOMIC, "b_short", 2, 2},
+    {ATOMIC, "b_int", 4, 4},
+    {ATOMIC, "b_long", 8, 8},
+    {ATOMIC, "b_double", 8, 8},
+    {ATOMIC, "b_vec", 16, 16},
+};
+
+/**
+ * Scales a size of a schema, keeping it at least minimum.
+ *
+ * @param base Size at scale 1.
+ * @param scale Scale of the run.
+ * @param minimum Smallest size.
+ * @return the scaled size.
+ */
+long long bench_size(long long base, double scale, long long minimum = 1) {
+    return max(minimum, (long long) llround(base * scale));
+}
+
+/**
+ * Struct with fields atomic fields of random types, as a wide struct of a generated header.
+ *
+ * @param fields Number of fields.
+ * @param seed Seed of the generator.
+ * @return the schema.
+ */
+bench_schema generate_wide_schema(long long fields, unsigned seed) {
+    mt19937_64 random(seed);
+    bench_schema schema{"wide", BENCH_ATOMICS, "wide"};
+    type_definition wide{STRUCT, "wide"};
+    wide.fields.reserve(fields);
+    for (long long i = 0; i < fields; i++) {
+        wide.fields.push_back(BENCH_ATOMICS[random() % BENCH_ATOMICS.size()].name);
+    }
+    schema.definitions.push_back(move(wide));
+    return schema;
+}
+
+/**
+ * Chain of levels structs, each one nested in the next between two atomic fields.
+ *
+ * @param levels Depth of the nesting.
+ * @return the schema.
+ */
+bench_schema generate_deep_schema(long long levels) {
+    bench_schema schema{"deep", BENCH_ATOMICS, ""};
+    schema.definitions.push_back(type_definition{STRUCT, "deep_0", 0, 0, 0, "", "", {"b_int", "b_char"}});
+    for (long long level = 1; level < levels; level++) {
+        string inner = "deep_" + to_string(level - 1);
+        schema.definitions.push_back(type_definition{STRUCT, "deep_" + to_string(level), 0, 0, 0, "", "", {"b_char", inner, "b_short"}});
+    }
+    schema.root = schema.definitions.back().name;
+    return schema;
+}
+
+/**
+ * Layers of width structs where each struct embeds two random structs of the layer below, so every layer shares the
+ * types of the previous one (diamonds) and the number of leaves doubles with each layer.
+ *
+ * @param layers Number of layers.
+ * @param width Structs per layer.
+ * @param seed Seed of the generator.
+ * @return the schema.
+ */
+bench_schema generate_diamond_schema(int layers, long long width, unsigned seed) {
+    mt19937_64 random(seed);
+    bench_schema schema{"diamond", BENCH_ATOMICS, ""};
+    auto name_of = [](int layer, long long i) { return "dag_" + to_string(layer) + "_" + to_string(i); };
+    for (int layer = 0; layer < layers; layer++) {
+        for (long long i = 0; i < width; i++) {
+            type_definition def{STRUCT, name_of(layer, i)};
+            for (int f = 0; f < 2; f++) {
+                def.fields.push_back(layer == 0 ? BENCH_ATOMICS[random() % BENCH_ATOMICS.size()].name : name_of(layer - 1, random() % width));
+            }
+            schema.definitions.push_back(move(def));
+        }
+    }
+    schema.root = name_of(layers - 1, 0);
+    return schema;
+}
+
+/**
+ * Union of alternatives types, atomic or small structs, nested in a struct between two atomic fields.
+ *
+ * @param alternatives Number of alternatives.
+ * @param seed Seed of the generator.
+ * @return the schema.
+ */
+bench_schema generate_union_schema(long long alternatives, unsigned seed) {
+    mt19937_64 random(seed);
+    bench_schema schema{"union", BENCH_ATOMICS, "holder"};
+    const int num_structs = 64;
+    for (int i = 0; i < num_structs; i++) {
+        schema.definitions.push_back(type_definition{STRUCT, "alt_" + to_string(i), 0, 0, 0, "", "",
+            {BENCH_ATOMICS[random() % BENCH_ATOMICS.size()].name, BENCH_ATOMICS[random() % BENCH_ATOMICS.size()].name}});
+    }
+    type_definition huge{UNION, "huge"};
+    huge.fields.reserve(alternatives);
+    for (long long i = 0; i < alternatives; i++) {
+        huge.fields.push_back(random() % 2 ? "alt_" + to_string(random() % num_structs) : BENCH_ATOMICS[random() % BENCH_ATOMICS.size()].name);
+    }
+    schema.definitions.push_back(move(huge));
+    schema.definitions.push_back(type_definition{STRUCT, "holder", 0, 0, 0, "", "", {"b_char", "huge", "b_int"}});
+    return schema;
+}
+
+/**
+ * Schema like the ones of real headers: bitfields, small unions and structs of 2 to 12 fields that mostly embed atomic
+ * types and sometimes the structs and unions defined shortly before them. Only types of up to 256 leaves are embedded,
+ * so the flattened size of each type stays bounded as in real code. The root embeds the last structs.
+ *
+ * @param types Number of types besides the atomic ones.
+ * @param seed Seed of the generator.
+ * @return the schema.
+ */
+bench_schema generate_mixed_schema(long long types, unsigned seed) {
+    mt19937_64 random(seed);
+    auto pick = [&random](long long low, long long high) {
+        return uniform_int_distribution<long long>(low, high)(random);
+    };
+    bench_schema schema{"mixed", BENCH_ATOMICS, "mixed_root"};
+    vector<pair<string, long long>> aggregates; // (nombre, hojas) de los structs y uniones que se pueden anidar
+    vector<string> structs;
+
+    auto field = [&](long long& leaves) {
+        if (!aggregates.empty() && pick(0, 3) == 0) {
+            const auto& [name, count] = aggregates[max(0LL, (long long) aggregates.size() - 1 - pick(0, 63))];
+            if (count <= 256) {
+                leaves += count;
+                return name;
+            }
+        }
+        leaves++;
+        return BENCH_ATOMICS[pick(0, BENCH_ATOMICS.size() - 1)].name;
+    };
+
+    for (long long i = 0; i < types; i++) {
+        long long leaves = 0;
+        long long roll = pick(0, 9);
+        if (roll == 0) {
+            schema.definitions.push_back(type_definition{BITFIELD, "mix_bits_" + to_string(i), 0, 0, (int) pick(1, 31), "b_int"});
+        } else if (roll == 1) {
+            type_definition def{UNION, "mix_union_" + to_string(i)};
+            for (long long f = pick(2, 4); f > 0; f--) def.fields.push_back(field(leaves));
+            aggregates.push_back({def.name, 1});
+            schema.definitions.push_back(move(def));
+        } else {
+            type_definition def{STRUCT, "mix_struct_" + to_string(i)};
+            for (long long f = pick(2, 12); f > 0; f--) def.fields.push_back(field(leaves));
+            aggregates.push_back({def.name, leaves});
+            structs.push_back(def.name);
+            schema.definitions.push_back(move(def));
+        }
+    }
+
+    type_definition root{STRUCT, "mixed_root"};
+    for (size_t i = structs.size() > 64 ? structs.size() - 64 : 0; i < structs.size(); i++) root.fields.push_back(structs[i]);
+    if (root.fields.empty()) root.fields.push_back("b_char");
+    schema.definitions.push_back(move(root));
+    return schema;
+}
+
+/**
+ * Generates the schemas of a run.
+ *
+ * @param options Options of the run.
+ * @return the schemas in the order they're measured.
+ */
+vector<bench_schema> generate_bench_schemas(const bench_options& options) {
+    // El arbol de diamantes duplica sus hojas por capa, asi que la escala quita o agrega capas
+    int layers = (int) max(2.0, round(16 + log2(options.scale)));
+    vector<bench_schema> schemas = {
+        generate_wide_schema(bench_size(100000, options.scale), options.seed),
+        generate_deep_schema(bench_size(10000, options.scale, 2)),
+        generate_diamond_schema(layers, bench_size(64, options.scale, 2), options.seed),
+        generate_union_schema(bench_size(100000, options.scale), options.seed),
+        generate_mixed_schema(bench_size(20000, options.scale), options.seed),
+    };
+    if (options.schemas.empty()) return schemas;
+
+    vector<bench_schema> selected;
+    for (auto& schema : schemas) {
+        if (find(options.schemas.begin(), options.schemas.end(), schema.name) != options.schemas.end()) selected.push_back(move(schema));
+    }
+    return selected;
+}
+
+/**
+ * Writes a definition as the interpreter command that defines it.
+ *
+ * @param def Type definition.
+ * @return the command line.
+ */
+string definition_command(const type_definition& def) {
+    string line;
+    switch (def.kind) {
+        case ATOMIC: line = "ATOMICO " + def.name + " " + to_string(def.size) + " " + to_string(def.align); break;
+        case STRUCT: line = "STRUCT " + def.name; break;
+        case UNION: line = "UNION " + def.name; break;
+        case BITFIELD: line = "BITFIELD " + def.name + " " + to_string(def.bits) + " " + def.unit; break;
+        case VARIANT: line = "VARIANTE " + def.name + " " + def.tag; break;
+    }
+    for (const auto& field : def.fields) line += " " + field;
+    return line;
+}
+
+/**
+ * Times of one operation on one schema, in milliseconds.
+ */
+struct bench_result {
+    string schema;
+    string operation;
+    long long types = 0;
+    long long fields = 0;
+    vector<double> times_ms;
+};
+
+/**
+ * Writes a result as one line of JSON.
+ *
+ * The line has the label of the run, the schema, its number of types and fields, the operation and the minimum, median
+ * and maximum of its times.
+ *
+ * @param result Result of an operation.
+ * @param label Label of the run.
+ * @return the line, without the line break.
+ */
+string bench_result_json(const bench_result& result, const string& label) {
+    vector<double> times = result.times_ms;
+    sort(times.begin(), times.end());
+    auto number = [](double value) {
+        ostringstream text;
+        text << fixed << setprecision(3) << value;
+        return text.str();
+    };
+
+    string line = "{\"label\":";
+    append_json_string(line, label);
+    line += ",\"schema\":";
+    append_json_string(line, result.schema);
+    line += ",\"types\":" + to_string(result.types) + ",\"fields\":" + to_string(result.fields) + ",\"operation\":";
+    append_json_string(line, result.operation);
+    line += ",\"repetitions\":" + to_string(times.size());
+    line += ",\"min_ms\":" + number(times.empty() ? 0 : times.front());
+    line += ",\"median_ms\":" + number(times.empty() ? 0 : times[times.size() / 2]);
+    line += ",\"max_ms\":" + number(times.empty() ? 0 : times.back()) + "}";
+    return line;
+}
+
+/**
+ * Measures every operation on a schema.
+ *
+ * The operations are registering its definitions in an empty table (register), computing the size and alignment of its
+ * structs and unions with calc_* (calc), the three DESCRIBIR strategies on its root (describe_unpacked, describe_packed
+ * and describe_heuristic), print_types on the whole table (print_types) and defining it and describing its root through
+ * the interpreter, from parsing the command lines on (repl). The output of the printers goes to a null_sink.
+ *
+ * @param schema Schema.
+ * @param repetitions Times each operation is run.
+ * @return one result per operation.
+ */
+vector<bench_result> run_bench_schema(const bench_schema& schema, int repetitions) {
+    long long fields = 0;
+    for (const auto& def : schema.definitions) fields += def.fields.size();
+    vector<string> lines;
+    for (const auto& def : schema.definitions) lines.push_back(definition_command(def));
+    lines.push_back("DESCRIBIR " + schema.root + " RESUMEN");
+
+    null_sink sink;
+    ostream null_out(&sink);
+    auto time = [](const function<void()>& operation) {
+        auto start = chrono::steady_clock::now();
+        operation();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+    auto register_schema = [&schema]() {
+        types_arr.clear();
+        for (const auto& def : schema.definitions) apply_definition(types_arr, def);
+    };
+
+    const vector<string> operations = {"register", "calc", "describe_unpacked", "describe_packed", "describe_heuristic", "print_types", "repl"};
+    vector<bench_result> results;
+    for (const auto& operation : operations) {
+        results.push_back(bench_result{schema.name, operation, (long long) schema.definitions.size(), fields, {}});
+    }
+
+    for (int r = 0; r < repetitions; r++) {
+        results[0].times_ms.push_back(time(register_schema));
+        const atomic_struct& root = get<atomic_struct>(lookup_type(types_arr, schema.root).at);
+
+        results[1].times_ms.push_back(time([]() {
+            for (const auto& [name, type] : types_arr) {
+                if (type.kind == STRUCT) {
+                    calc_size_struct(get<atomic_struct>(type.at));
+                    calc_align_struct(get<atomic_struct>(type.at));
+                } else if (type.kind == UNION) {
+                    calc_size_union(get<atomic_union>(type.at));
+                    calc_align_union(get<atomic_union>(type.at));
+                }
+            }
+        }));
+        results[2].times_ms.push_back(time([&]() { print_struct_wt_packing(root, 8, 0, 0, LLONG_MAX, null_out); }));
+        results[3].times_ms.push_back(time([&]() { print_struct_w_packing(root, 8, 0, 0, LLONG_MAX, null_out); }));
+        results[4].times_ms.push_back(time([&]() { print_struct_heuristics(root, 8, 0, 0, LLONG_MAX, null_out); }));
+        results[5].times_ms.push_back(time([&]() { print_types(null_out); }));
+
+        types_arr.clear();
+        results[6].times_ms.push_back(time([&]() {
+            session s;
+            for (const auto& line : lines) execute_command(parse_command(line, AVAILABLE_COMMANDS), s, null_out);
+        }));
+    }
+    return results;
+}
+
+/**
+ * Runs the benchmark. The type table is left as it was.
+ *
+ * @param options Options of the run.
+ * @param on_result Called with the line of JSON of each result as soon as its schema is measured.
+ * @return the results of every schema.
+ */
+vector<bench_result> run_bench(const bench_options& options, const function<void(const string&)>& on_result = nullptr) {
+    map<string, atomic_type> saved = move(types_arr);
+    vector<bench_result> all;
+    try {
+        for (const auto& schema : generate_bench_schemas(options)) {
+            for (auto& result : run_bench_schema(schema, max(options.repetitions, 1))) {
+                if (on_result) on_result(bench_result_json(result, options.label));
+                all.push_back(move(result));
+            }
+        }
+    } catch (...) {
+        types_arr = move(saved);
+        throw;
+    }
+    types_arr = move(saved);
+    return all;
+}
+#endif
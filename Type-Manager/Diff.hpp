@@ -0,0 +1,288 @@
+#ifndef DIFF_HPP
+#define DIFF_HPP
+
+#include <unordered_map>
+#include "Functions.hpp"
+#include "Export.hpp"
+
+/**
+ * Kind of change of a field between two offset tables.
+ */
+enum DiffOp { FIELD_ADDED, FIELD_REMOVED, FIELD_MOVED, FIELD_RESIZED };
+
+/**
+ * Change of a field between two offset tables.
+ *
+ * Offsets and sizes of the side where the field doesn't exist are -1. A field that moved and changed size is
+ * FIELD_RESIZED.
+ */
+struct layout_edit {
+    DiffOp op;
+    string name;
+    long long old_id = -1;
+    long long new_id = -1;
+    long long old_offset = -1;
+    long long new_offset = -1;
+    long long old_size = -1;
+    long long new_size = -1;
+};
+
+/**
+ * Differences between two offset tables: the totals of each one and the fields that changed.
+ */
+struct layout_diff {
+    vector<layout_edit> edits;
+    long long old_size = 0;
+    long long new_size = 0;
+    long long old_lost = 0;
+    long long new_lost = 0;
+    long long old_stride = 0;
+    long long new_stride = 0;
+};
+
+/**
+ * Slots of an offset table in declaration order.
+ *
+ * The slots are bucketed by id, so it takes linear time. If the ids aren't a permutation of the positions of the slots the
+ * table order is kept.
+ *
+ * @param layout Offset table.
+ * @return pointers to the slots of the table.
+ */
+vector<const field_slot*> slots_by_id(const struct_layout& layout) {
+    size_t n = layout.slots.size();
+    vector<const field_slot*> ordered(n, nullptr);
+
+    for (const auto& slot : layout.slots) {
+        if (slot.id < 0 || slot.id >= (long long) n || ordered[slot.id] != nullptr) {
+            for (size_t i = 0; i < n; i++) ordered[i] = &layout.slots[i];
+            return ordered;
+        }
+        ordered[slot.id] = &slot;
+    }
+    return ordered;
+}
+
+/**
+ * Compares two offset tables, of two strategies for a type or of a type in two versions of the type table.
+ *
+ * The k-th field of a type in one table is matched with the k-th field of the same type in the other, so comparing two
+ * strategies matches each field with itself and a field added or removed doesn't shift the rest. Only the fields that
+ * changed are listed: first the ones of the new table in declaration order and then the removed ones. Takes linear time
+ * over the fields.
+ *
+ * @param before Old offset table.
+ * @param after New offset table.
+ * @return totals of both tables and the list of changes.
+ */
+layout_diff diff_layouts(const struct_layout& before, const struct_layout& after) {
+    layout_diff diff;
+    diff.old_size = before.size;
+    diff.new_size = after.size;
+    diff.old_lost = before.lost;
+    diff.new_lost = after.lost;
+    diff.old_stride = before.stride;
+    diff.new_stride = after.stride;
+
+    vector<const field_slot*> old_slots = slots_by_id(before);
+    vector<const field_slot*> new_slots = slots_by_id(after);
+
+    // Por cada tipo de campo, sus apariciones en la tabla vieja y cuantas ya se emparejaron
+    unordered_map<string, pair<vector<size_t>, size_t>> occurrences;
+    occurrences.reserve(old_slots.size());
+    for (size_t i = 0; i < old_slots.size(); i++) {
+        occurrences[old_slots[i]->name].first.push_back(i);
+    }
+
+    vector<bool> matched(old_slots.size(), false);
+    for (const field_slot* slot : new_slots) {
+        layout_edit edit{FIELD_ADDED, slot->name};
+        edit.new_id = slot->id;
+        edit.new_offset = slot->bits > 0 ? slot->bit_offset : slot->offset;
+        edit.new_size = slot->bits > 0 ? slot->bits : slot->size;
+
+        auto found = occurrences.find(slot->name);
+        if (found != occurrences.end() && found->second.second < found->second.first.size()) {
+            size_t i = found->second.first[found->second.second++];
+            const field_slot* old_slot = old_slots[i];
+            matched[i] = true;
+            edit.old_id = old_slot->id;
+            edit.old_offset = old_slot->bits > 0 ? old_slot->bit_offset : old_slot->offset;
+            edit.old_size = old_slot->bits > 0 ? old_slot->bits : old_slot->size;
+
+            if (edit.old_size != edit.new_size) {
+                edit.op = FIELD_RESIZED;
+            } else if (edit.old_offset != edit.new_offset) {
+                edit.op = FIELD_MOVED;
+            } else {
+                continue;
+            }
+        }
+        diff.edits.push_back(edit);
+    }
+
+    for (size_t i = 0; i < old_slots.size(); i++) {
+        if (matched[i]) continue;
+        layout_edit edit{FIELD_REMOVED, old_slots[i]->name};
+        edit.old_id = old_slots[i]->id;
+        edit.old_offset = old_slots[i]->bits > 0 ? old_slots[i]->bit_offset : old_slots[i]->offset;
+        edit.old_size = old_slots[i]->bits > 0 ? old_slots[i]->bits : old_slots[i]->size;
+        diff.edits.push_back(edit);
+    }
+
+    return diff;
+}
+
+/**
+ * Checks if two offset tables are different.
+ *
+ * @param diff Differences between the tables.
+ * @return true if any field or total changed.
+ */
+bool has_changes(const layout_diff& diff) {
+    return !diff.edits.empty() || diff.old_size != diff.new_size || diff.old_lost != diff.new_lost
+        || diff.old_stride != diff.new_stride;
+}
+
+/**
+ * Change of a struct between two versions of the type table.
+ *
+ * A struct only in the new table is added (is_added) and one only in the old table removed (is_removed).
+ */
+struct type_diff {
+    string name;
+    bool is_added = false;
+    bool is_removed = false;
+    layout_diff layout;
+};
+
+/**
+ * Offset tables of every struct of a type table.
+ *
+ * The fields are looked up in the given table, which is only read: the global one isn't touched.
+ *
+ * @param table Type table.
+ * @param strategy Layout strategy.
+ * @return offset table of each struct, by name.
+ */
+map<string, struct_layout> table_layouts(const map<string, atomic_type>& table, LayoutStrategy strategy) {
+    map<string, struct_layout> layouts;
+    for (const auto& [name, type] : table) {
+        if (type.kind == STRUCT) {
+            layouts[name] = compute_struct_layout(get<atomic_struct>(type.at), strategy, true, table);
+        }
+    }
+    return layouts;
+}
+
+/**
+ * Compares the structs of two versions of the type table.
+ *
+ * Both tables are walked together in name order, so matching the structs takes linear time.
+ *
+ * @param before Old type table.
+ * @param after New type table.
+ * @param strategy Layout strategy used in both tables.
+ * @return the structs added, removed or whose layout changed, in name order.
+ */
+vector<type_diff> diff_type_tables(const map<string, atomic_type>& before, const map<string, atomic_type>& after, LayoutStrategy strategy) {
+    map<string, struct_layout> old_layouts = table_layouts(before, strategy);
+    map<string, struct_layout> new_layouts = table_layouts(after, strategy);
+
+    vector<type_diff> diffs;
+    auto old_it = old_layouts.begin();
+    auto new_it = new_layouts.begin();
+
+    while (old_it != old_layouts.end() || new_it != new_layouts.end()) {
+        type_diff diff;
+        if (new_it == new_layouts.end() || (old_it != old_layouts.end() && old_it->first < new_it->first)) {
+            diff.name = old_it->first;
+            diff.is_removed = true;
+            diff.layout = diff_layouts(old_it->second, struct_layout{});
+            ++old_it;
+        } else if (old_it == old_layouts.end() || new_it->first < old_it->first) {
+            diff.name = new_it->first;
+            diff.is_added = true;
+            diff.layout = diff_layouts(struct_layout{}, new_it->second);
+            ++new_it;
+        } else {
+            diff.name = new_it->first;
+            diff.layout = diff_layouts(old_it->second, new_it->second);
+            ++old_it;
+            ++new_it;
+            if (!has_changes(diff.layout)) continue;
+        }
+        diffs.push_back(diff);
+    }
+
+    return diffs;
+}
+
+/**
+ * Finds a layout strategy by the name it has in the exported output.
+ *
+ * @param name Name of the strategy.
+ * @return the strategy.
+ */
+LayoutStrategy parse_strategy(const string& name) {
+    for (const auto& [strategy_name, strategy] : EXPORTED_STRATEGIES) {
+        if (strategy_name == name) return strategy;
+    }
+    throw runtime_error("Error: Unknown strategy '" + name + "'. Available strategies: unpacked, packed, heuristic, opaque, tail_reuse.");
+}
+
+/**
+ * Prints the differences between two offset tables.
+ *
+ * Offsets and sizes of bitfields are in bits.
+ *
+ * @param name Name of the type.
+ * @param diff Differences between the tables.
+ * @param out Stream where the output is written.
+ */
+void print_layout_diff(const string& name, const layout_diff& diff, ostream& out = cout) {
+    out << "Struct Type: " << name << ", Size: " << diff.old_size << " -> " << diff.new_size
+         << " bytes (" << showpos << diff.new_size - diff.old_size << noshowpos << "), Lost: " << diff.old_lost << " -> "
+         << diff.new_lost << " bytes (" << showpos << diff.new_lost - diff.old_lost << noshowpos << "), Stride: "
+         << diff.old_stride << " -> " << diff.new_stride << " bytes" << '\n';
+
+    for (const auto& edit : diff.edits) {
+        switch (edit.op) {
+            case FIELD_ADDED:
+                out << "  added #" << edit.new_id << " " << edit.name << " at offset " << edit.new_offset
+                     << ", size " << edit.new_size << '\n';
+                break;
+            case FIELD_REMOVED:
+                out << "  removed #" << edit.old_id << " " << edit.name << " at offset " << edit.old_offset
+                     << ", size " << edit.old_size << '\n';
+                break;
+            case FIELD_MOVED:
+                out << "  moved #" << edit.new_id << " " << edit.name << ": offset " << edit.old_offset << " -> "
+                     << edit.new_offset << '\n';
+                break;
+            case FIELD_RESIZED:
+                out << "  resized #" << edit.new_id << " " << edit.name << ": size " << edit.old_size << " -> "
+                     << edit.new_size << ", offset " << edit.old_offset << " -> " << edit.new_offset << '\n';
+                break;
+        }
+    }
+}
+
+/**
+ * Prints the structs that changed between two versions of the type table.
+ *
+ * @param diffs Changes returned by diff_type_tables.
+ * @param out Stream where the output is written.
+ */
+void print_type_diffs(const vector<type_diff>& diffs, ostream& out = cout) {
+    if (diffs.empty()) {
+        out << "No struct layout changed." << '\n';
+        return;
+    }
+    for (const auto& diff : diffs) {
+        if (diff.is_added) out << "Added: ";
+        if (diff.is_removed) out << "Removed: ";
+        print_layout_diff(diff.name, diff.layout, out);
+    }
+}
+#endif
@@ -0,0 +1,284 @@
+#ifndef EXPORT_HPP
+#define EXPORT_HPP
+
+#include <fstream>
+#include <cstdint>
+#include "Functions.hpp"
+
+/**
+ * Strategies whose offset tables are exported for each struct, with the name used in the output.
+ */
+const vector<pair<string, LayoutStrategy>> EXPORTED_STRATEGIES = {
+    {"unpacked", UNPACKED},
+    {"packed", PACKED},
+    {"heuristic", HEURISTIC},
+    {"opaque", OPAQUE},
+    {"tail_reuse", TAIL_REUSE},
+};
+
+/**
+ * Name of a kind of type in the exported output.
+ *
+ * @param kind Kind of type.
+ * @return lowercase name of the kind.
+ */
+string kind_name(AtomicKind kind) {
+    switch (kind) {
+        case ATOMIC: return "atomic";
+        case STRUCT: return "struct";
+        case UNION: return "union";
+        case BITFIELD: return "bitfield";
+        case VARIANT: return "variant";
+    }
+    return "unknown";
+}
+
+/**
+ * Appends a string to a buffer as a JSON string literal.
+ *
+ * @param out Buffer.
+ * @param text String to escape.
+ */
+void append_json_string(string& out, const string& text) {
+    out.push_back('"');
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if ((unsigned char) c < 0x20) {
+            const char* hex = "0123456789abcdef";
+            out.append("\\u00");
+            out.push_back(hex[(c >> 4) & 0xf]);
+            out.push_back(hex[c & 0xf]);
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+/**
+ * Appends a list of type names to a buffer as a JSON array.
+ *
+ * @param out Buffer.
+ * @param names Type names.
+ */
+void append_json_names(string& out, const vector<string>& names) {
+    out.push_back('[');
+    for (size_t i = 0; i < names.size(); i++) {
+        if (i > 0) out.push_back(',');
+        append_json_string(out, names[i]);
+    }
+    out.push_back(']');
+}
+
+/**
+ * Appends a type to a buffer as one line of JSON.
+ *
+ * Every type has its name, kind, size and alignment. Structs also have the offset table of each exported strategy, unions
+ * and variants their alternatives and bitfields their width and storage unit.
+ *
+ * @param out Buffer.
+ * @param name Type name.
+ * @param type Type.
+ */
+void append_type_json(string& out, const string& name, const atomic_type& type) {
+    auto [size, align] = type_size_align(name);
+
+    out.append("{\"name\":");
+    append_json_string(out, name);
+    out.append(",\"kind\":\"");
+    out.append(kind_name(type.kind));
+    out.append("\",\"size\":");
+    append_padded(out, size, 0);
+    out.append(",\"align\":");
+    append_padded(out, align, 0);
+
+    if (type.kind == STRUCT) {
+        const atomic_struct& s = get<atomic_struct>(type.at);
+        out.append(",\"fields\":");
+        append_json_names(out, s.fields);
+        out.append(",\"strategies\":{");
+
+        for (size_t k = 0; k < EXPORTED_STRATEGIES.size(); k++) {
+            struct_layout layout = compute_struct_layout(s, EXPORTED_STRATEGIES[k].second);
+            if (k > 0) out.push_back(',');
+            append_json_string(out, EXPORTED_STRATEGIES[k].first);
+            out.append(":{\"size\":");
+            append_padded(out, layout.size, 0);
+            out.append(",\"align\":");
+            append_padded(out, layout.align, 0);
+            out.append(",\"stride\":");
+            append_padded(out, layout.stride, 0);
+            out.append(",\"lost\":");
+            append_padded(out, layout.lost, 0);
+            out.append(",\"slots\":[");
+
+            for (size_t i = 0; i < layout.slots.size(); i++) {
+                const field_slot& slot = layout.slots[i];
+                if (i > 0) out.push_back(',');
+                out.append("{\"id\":");
+                append_padded(out, slot.id, 0);
+                out.append(",\"type\":");
+                append_json_string(out, slot.name);
+                out.append(",\"offset\":");
+                append_padded(out, slot.offset, 0);
+                out.append(",\"size\":");
+                append_padded(out, slot.size, 0);
+                if (slot.bits > 0) {
+                    out.append(",\"bit_offset\":");
+                    append_padded(out, slot.bit_offset, 0);
+                    out.append(",\"bits\":");
+                    append_padded(out, slot.bits, 0);
+                }
+                out.push_back('}');
+            }
+            out.append("]}");
+        }
+        out.push_back('}');
+    } else if (type.kind == UNION) {
+        out.append(",\"fields\":");
+        append_json_names(out, get<atomic_union>(type.at).fields);
+    } else if (type.kind == VARIANT) {
+        const atomic_variant& v = get<atomic_variant>(type.at);
+        out.append(",\"tag\":");
+        append_json_string(out, v.tag);
+        out.append(",\"fields\":");
+        append_json_names(out, v.fields);
+    } else if (type.kind == BITFIELD) {
+        const atomic_bitfield& b = get<atomic_bitfield>(type.at);
+        out.append(",\"bits\":");
+        append_padded(out, b.bits, 0);
+        out.append(",\"unit\":");
+        append_json_string(out, b.unit);
+    }
+
+    out.append("}\n");
+}
+
+/**
+ * Exports every type of the type table as JSON Lines, one type per line in name order.
+ *
+ * @return the whole output, to be written at once.
+ */
+string export_types_json() {
+    string out;
+    out.reserve(types_arr.size() * 128);
+    for (const auto& [name, type] : types_arr) {
+        append_type_json(out, name, type);
+    }
+    return out;
+}
+
+/**
+ * Appends an integer to a buffer in little endian.
+ *
+ * @param out Buffer.
+ * @param value Integer to append.
+ * @param num_bytes Number of bytes written.
+ */
+void append_le(string& out, uint64_t value, int num_bytes) {
+    for (int i = 0; i < num_bytes; i++) {
+        out.push_back((char) ((value >> (8 * i)) & 0xff));
+    }
+}
+
+/**
+ * Appends a string to a buffer as its length (4 bytes) followed by its characters.
+ *
+ * @param out Buffer.
+ * @param text String to append.
+ */
+void append_binary_string(string& out, const string& text) {
+    append_le(out, text.size(), 4);
+    out.append(text);
+}
+
+/**
+ * Magic number at the start of the binary output.
+ */
+const string BINARY_MAGIC = "TMGR";
+
+/**
+ * Version of the binary output format.
+ */
+const int BINARY_VERSION = 1;
+
+/**
+ * Exports every type of the type table in a compact binary form.
+ *
+ * Integers are little endian. The output is the magic "TMGR", the version (4 bytes) and the number of types (4 bytes),
+ * followed by each type in name order: kind (1 byte), name, size (8 bytes), alignment (4 bytes), the number of fields
+ * (4 bytes) and their type names, and the number of offset tables (1 byte). Each offset table has its strategy (1 byte,
+ * the LayoutStrategy value), size (8), alignment (4), stride (8), number of slots (4) and for each slot its id (4), size
+ * (8), offset in bits (8) and width in bits (4, 0 for fields that aren't bitfields). Strings are their length (4 bytes)
+ * followed by their characters. Only structs have offset tables.
+ *
+ * @return the whole output, to be written at once.
+ */
+string export_types_binary() {
+    string out;
+    out.reserve(12 + types_arr.size() * 64);
+    out.append(BINARY_MAGIC);
+    append_le(out, BINARY_VERSION, 4);
+    append_le(out, types_arr.size(), 4);
+
+    for (const auto& [name, type] : types_arr) {
+        auto [size, align] = type_size_align(name);
+        append_le(out, type.kind, 1);
+        append_binary_string(out, name);
+        append_le(out, size, 8);
+        append_le(out, align, 4);
+
+        vector<string> fields;
+        if (type.kind == STRUCT) fields = get<atomic_struct>(type.at).fields;
+        if (type.kind == UNION) fields = get<atomic_union>(type.at).fields;
+        if (type.kind == VARIANT) fields = get<atomic_variant>(type.at).fields;
+        append_le(out, fields.size(), 4);
+        for (const auto& field_name : fields) {
+            append_binary_string(out, field_name);
+        }
+
+        if (type.kind != STRUCT) {
+            append_le(out, 0, 1);
+            continue;
+        }
+
+        const atomic_struct& s = get<atomic_struct>(type.at);
+        append_le(out, EXPORTED_STRATEGIES.size(), 1);
+        for (const auto& [strategy_name, strategy] : EXPORTED_STRATEGIES) {
+            struct_layout layout = compute_struct_layout(s, strategy);
+            append_le(out, strategy, 1);
+            append_le(out, layout.size, 8);
+            append_le(out, layout.align, 4);
+            append_le(out, layout.stride, 8);
+            append_le(out, layout.slots.size(), 4);
+            for (const auto& slot : layout.slots) {
+                append_le(out, slot.id, 4);
+                append_le(out, slot.size, 8);
+                append_le(out, slot.bit_offset, 8);
+                append_le(out, slot.bits, 4);
+            }
+        }
+    }
+
+    return out;
+}
+
+/**
+ * Writes a buffer to a file with a single write.
+ *
+ * @param path Path of the file. It's overwritten if it exists.
+ * @param data Bytes to write.
+ */
+void write_buffer(const string& path, const string& data) {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file) {
+        throw runtime_error("Error: Can't open file '" + path + "' for writing.");
+    }
+    file.write(data.data(), data.size());
+    if (!file) {
+        throw runtime_error("Error: Can't write file '" + path + "'.");
+    }
+}
+#endif
@@ -1,754 +1,2138 @@
-#ifndef FUNCTIONS_HPP
-#define FUNCTIONS_HPP
-
-#include <iostream>
-#include <string>
-#include <vector>
-#include <map>
-#include <tuple>
-#include <algorithm>
-#include <variant>
-#include <sstream>
-#include <cmath>
-#include <numeric>
-
-using namespace std;
-
-/**
- * Structs for modelling atomic types, structs and unions.
- * 
- * The special type "atomic_type" is a variant type for creating a dict that can contains all three types in a single structures
- * such that declarations using the same identifier overlap one another and to ease accesability for other functions and procedures
- * that consults the dictionary as a map. It contains a discriminant field "kind" that identifies if it's an atomic type, a struct
- * or a union. This kind is of type enum AtomicKind that lists the types ATOMIC, STRUCT, UNION and maps each type with integers 0, 1
- * and 2. 
- */
-
-struct aatomic {
-    string name;
-    int size;
-    int align;
-};
-
-struct atomic_struct{
-    string name;
-    vector<string> fields;
-    int size = 0;
-    int align = 0;
-};
-
-struct atomic_union{
-    string name;
-    vector<string> fields;
-    int size = 0;
-    int align = 0;
-};
-
-enum AtomicKind { ATOMIC, STRUCT, UNION };
-
-struct atomic_type {
-    AtomicKind kind;
-    variant<aatomic, atomic_struct, atomic_union> at;
-};
-
-map<string, atomic_type> types_arr = {};
-
-// map<string, atomic_type> types_arr = {
-//     { "char",   { ATOMIC, aatomic{"char",   1, 1} }},
-//     { "short",  { ATOMIC, aatomic{"short",  2, 2} }},
-//     { "int",    { ATOMIC, aatomic{"int",    4, 4} }},
-//     { "long",   { ATOMIC, aatomic{"long",   8, 8} }},
-//     { "float",  { ATOMIC, aatomic{"float",  4, 4} }},
-//     { "double", { ATOMIC, aatomic{"double", 8, 8} }},
-//     { "bool",   { ATOMIC, aatomic{"bool",   1, 2} }},
-//     {"MyStruct1", {STRUCT, atomic_struct{"MyStruct1", {"int", "char", "char", "int", "double", "bool"}, 19, 4}}},
-//     {"MyStruct2", {STRUCT, atomic_struct{"MyStruct2", {"short", "float", "char", "long"}, 15, 2}}},
-//     {"Union1", {UNION, atomic_union{"MyUnion1", {"double", "bool", "int"}, 8, 8}}},
-//     {"Union2", {UNION, atomic_union{"MyUnion2", {"Union1", "MyStruct2"}, 15, 8}}}
-// };
-
-//DECLARACIONES
-int calc_size_union (const atomic_union& at_union);
-int calc_size_struct (const atomic_struct& at_struct);
-int calc_align_union (const atomic_union& at_union);
-int calc_align_struct (const atomic_struct& at_struct);
-//DECLARACIONES
-
-/**
- * Prints type layout in memory.
- * 
- * @param mem_arr Contains either 1s or 0s. 1 stands for an active byte in memory occupied by the type.
- * @param word_size Defines the word size in the memory layout to visually check for type alignment.
- */
-void print_mem_layout_diagram(const vector<int>& mem_arr, int word_size = 4) {
-    
-    cout << " - - - - - - - - - - - -" << endl;
-    cout << " Memory Layout Diagram (each '1' represents a byte):";
-
-    for (long unsigned int i = 0; i < mem_arr.size(); i++) {
-
-        string idx = to_string(i);
-        while (idx.size() < 3) idx = " " + idx;
-
-        if (i % word_size == 0) {
-            cout << "\n" << " " << idx << " | " << mem_arr[i] << " ";
-        }
-        else if ((i + 1) % word_size == 0) {
-            cout << mem_arr[i] << " |";
-        }
-        else {
-            cout << mem_arr[i] << " ";
-        }
-    }
-
-    cout << endl;
-    cout << " - - - - - - - - - - - -" << endl;
-}
-
-/**
- * Collects recursively the fields in a struct.
- * 
- * @param at_struct Struct type.
- * @param accumulator Contains the atomic fields collected so far during execution.
- */
-void collect_struct_fields(const atomic_struct& at_struct, vector<string>& accumulator){
-    for (const auto& field_name : at_struct.fields) {
-
-        auto& t = types_arr[field_name];
-
-        if (t.kind == STRUCT) {
-            const auto& inner_struct = get<atomic_struct>(t.at);
-            collect_struct_fields(inner_struct, accumulator);
-        } else if (t.kind == ATOMIC || t.kind == UNION) {
-            accumulator.push_back(field_name);
-        }
-    }
-}
-
-/**
- * Sorts a list of types in function of their alignment.
- * 
- * This is an auxiliary function for the heuristics to optimize the memory layout of a type
- * 
- * @param at_struct Struct type.
- * @param fields Contains the atomic fields of the struct.
- * @return vector of atomic fields sorted by alignment.
- */
-vector<string> sort_struct_fields_by_alignment(const atomic_struct& at_struct, vector<string>& fields) {
-    vector<string> all_fields;
-
-    collect_struct_fields(at_struct, all_fields);
-
-    sort(all_fields.begin(), all_fields.end(),
-        [](const string& a, const string& b) {
-            int align_a = 0;
-            int align_b = 0;
-
-            auto& ta = types_arr[a];
-            auto& tb = types_arr[b];
-
-            if (ta.kind == ATOMIC)
-                align_a = get<aatomic>(ta.at).align;
-            else if (ta.kind == STRUCT)
-                align_a = get<atomic_struct>(ta.at).align;
-            else if (ta.kind == UNION)
-                align_a = get<atomic_union>(ta.at).align;
-
-            if (tb.kind == ATOMIC)
-                align_b = get<aatomic>(tb.at).align;
-            else if (tb.kind == STRUCT)
-                align_b = get<atomic_struct>(tb.at).align;
-            else if (tb.kind == UNION)
-                align_b = get<atomic_union>(tb.at).align;
-
-            return align_a > align_b;
-        });
-
-    fields = all_fields;
-    return fields;
-}
-
-/**
- * Auxiliary function to print_struct_heuristics.
- * 
- * Determines whether n bytes can be allocated from mem_index_ptr in array of memory.
- * 
- * @param n num of bytes to allocate.
- * @param mem_index_ptr pointer of memory position.
- * @param mem_arr array of memory.
- * @return true if n bytes can be allocated from mem_index_ptr. Return false otherwise
- */
-bool can_allocate_n_bytes (int n, long unsigned int mem_index_ptr, vector<int>& mem_arr) {
-
-    if (mem_arr.size() == 0){
-        return true;
-    }
-
-    int i = n;
-
-    while (mem_arr[mem_index_ptr] != 1 && i > 0 && mem_index_ptr < mem_arr.size()){
-        mem_index_ptr++;
-        i--;
-    }
-
-    if (mem_arr[mem_index_ptr] == 1 && i > 0){
-        return false;
-    } else if (mem_index_ptr >= mem_arr.size()){
-
-        return true;
-    }
-
-    return true;
-}
-
-/**
- * Auxiliary function to print_struct_heuristics.
- * 
- * Builds the mem_arr for memory layout using the heuristic and keeps the number of bytes allocated
- * 
- * @param at_struct Struct type.
- * @param fields Contains the atomic fields of the struct.
- * @return vector of integers. bytes[0] contains the num of active bytes, bytes[1] contains the num of wasted bytes to alignment, bytes[2] contains the total number of bytes occupied
- */
-vector<int> print_struct_heuristics_aux(vector<string> fields, vector<int>& mem_arr, long unsigned int& mem_index_ptr, vector<int>& bytes) {
-
-    for (const auto& field_name : fields) {
-        bool is_allocated = false;
-        if (types_arr[field_name].kind == ATOMIC){
-            aatomic type = get<aatomic>(types_arr[field_name].at);
-
-            while (!is_allocated){
-                if (mem_index_ptr % type.align == 0 && can_allocate_n_bytes(type.size, mem_index_ptr, mem_arr)) {
-                    int i = 0;
-                    while (i < type.size){
-                        if (mem_index_ptr < mem_arr.size()){
-                            mem_arr[mem_index_ptr] = 1;
-                        } else {
-                            mem_arr.push_back(1);
-                        }
-                        bytes[0]++;
-                        mem_index_ptr++;
-                        i++;
-                    }
-                    is_allocated = true;
-                    mem_index_ptr = 0;
-                }
-
-                if (mem_index_ptr < mem_arr.size()){
-                    mem_index_ptr++;
-                } else {
-                    mem_arr.push_back(0);
-                }
-            }
-        } else if (types_arr[field_name].kind == UNION) {
-            atomic_union type = get<atomic_union>(types_arr[field_name].at);
-
-            while (!is_allocated){
-                if (mem_index_ptr % type.align == 0 && can_allocate_n_bytes(type.size, mem_index_ptr, mem_arr)) {
-                    int i = 0;
-                    while (i < type.size){
-                        if (mem_index_ptr < mem_arr.size()){
-                            mem_arr[mem_index_ptr] = 1;
-                        } else {
-                            mem_arr.push_back(1);
-                        }
-                        bytes[0]++;
-                        mem_index_ptr++;
-                        i++;
-                    }
-                    is_allocated = true;
-                    mem_index_ptr = 0;
-                }
-
-                if (mem_index_ptr < mem_arr.size()){
-                    mem_index_ptr++;
-                } else {
-                    mem_arr.push_back(0);
-                }
-            }
-        }
-    }
-
-    for (const auto& cell : mem_arr) {
-        if (cell == 0){
-            bytes[1]++;
-        }
-    }
-
-    bytes[2] = bytes[0] + bytes[1];
-
-    return bytes;
-}
-/**
- * Applies heuristic to set up the memory layout for a type maximizing space and time.
- * 
- * The heuristic goes as follows: for each type, lay in memory those with greater alignment first. This heuristic assume that the greater the alignment of the type, the most likely it is
- * to waste bytes. So it lays them in memory first taking advantage of mem address 0 and the fact that greater alignments are less likely to have valid mem addresses to align with within the size
- * of the structure. For example, consider types A and B with alignment 4 and 8 in a struct of size 16. There are more multiples of 4 in 16 than there are multiples of 8, so we lay first
- * B in memory and move on to A. 
- * 
- * @param at_struct Struct type.
- * @param word_size Sets the size of a word for printing memory layout.
- */
-void print_struct_heuristics(const atomic_struct& at_struct, int word_size = 4) {
-    vector<string> init = {};
-    vector<string> fields = sort_struct_fields_by_alignment(at_struct, init);
-
-    vector<int> mem_arr = {};
-    long unsigned int mem_index_ptr = 0;
-    vector<int> bytes_init = {0, 0, 0};
-    vector<int> bytes = print_struct_heuristics_aux(fields, mem_arr, mem_index_ptr, bytes_init);
-
-    cout << "Struct Type: " << at_struct.name << ", Bytes allocated: " << bytes[2] << " bytes, Bytes lost: " << bytes[1] <<endl;
-
-    print_mem_layout_diagram(mem_arr, word_size);
-}
-
-/**
- * Calculates the alignment for an union type
- * 
- * @param at_union Union type.
- * @return the lcm of the alignments of the fields defined in the union tyoe.
- */
-int calc_align_union (const atomic_union& at_union){
-    int align_accumulated = 1;
-    for (const auto& field_name : at_union.fields) {
-        if (types_arr[field_name].kind == ATOMIC){
-            align_accumulated = lcm(align_accumulated, get<aatomic>(types_arr[field_name].at).align);
-        } else if (types_arr[field_name].kind == STRUCT) {
-            align_accumulated = lcm(align_accumulated, get<atomic_struct>(types_arr[field_name].at).align);
-        } else if (types_arr[field_name].kind == UNION) {
-            align_accumulated = lcm(align_accumulated, get<atomic_union>(types_arr[field_name].at).align);
-        }
-    }
-    return align_accumulated;
-}
-
-/**
- * Calculates the alignment for a struct type.
- * 
- * It takes the alignment of the first atomic field to set the alignment for the rest of the structure. If the firs field is an struct, calculated the alignment recursively
- * 
- * @param at_struct Struct type.
- * @return the alignment of the first atomic field of the struct.
- */
-int calc_align_struct (const atomic_struct& at_struct){
-    int align_accumulated = 0;
-    auto first_field_type = types_arr[at_struct.fields[0]];
-    if (first_field_type.kind == ATOMIC){
-        align_accumulated = get<aatomic>(first_field_type.at).align;
-    } else if (first_field_type.kind == STRUCT) {
-        align_accumulated = get<atomic_struct>(first_field_type.at).align;
-    } else if (first_field_type.kind == UNION) {
-        align_accumulated = get<atomic_union>(first_field_type.at).align;
-    }
-    return align_accumulated;
-}
-
-/**
- * Calculates the size of an union type.
- * 
- * It takes the field with greater size to define the size of the union type.
- * 
- * @param at_union Union type.
- * @return the size of the greatest field of the union.
- */
-int calc_size_union (const atomic_union& at_union) {
-    int size_accumulated = 0;
-    for (const auto& field_name : at_union.fields) {
-        if (types_arr[field_name].kind == ATOMIC){
-            size_accumulated = max(size_accumulated, get<aatomic>(types_arr[field_name].at).size);
-        } else if (types_arr[field_name].kind == STRUCT) {
-            size_accumulated = max(size_accumulated, get<atomic_struct>(types_arr[field_name].at).size);
-        } else if (types_arr[field_name].kind == UNION) {
-            size_accumulated = max(size_accumulated, get<atomic_union>(types_arr[field_name].at).size);
-        }
-    }
-    return size_accumulated;
-}
-/**
- * Calculates the size of a struct type.
- * 
- * It takes the sum of all the fields of the struct.
- * 
- * @param at_union Union type.
- * @return the sum of all the fields of the struct.
- */
-int calc_size_struct (const atomic_struct& at_struct) {
-    int size_accumulated = 0;
-    for (const auto& field_name : at_struct.fields) {
-        if (types_arr[field_name].kind == ATOMIC){
-            size_accumulated += get<aatomic>(types_arr[field_name].at).size;
-        } else if (types_arr[field_name].kind == STRUCT) {
-            size_accumulated += get<atomic_struct>(types_arr[field_name].at).size;
-        } else if (types_arr[field_name].kind == UNION) {
-            size_accumulated += get<atomic_union>(types_arr[field_name].at).size;
-        }
-    }
-    return size_accumulated;
-}
-
-/**
- * Auxiliary function to printing the memory layout of a struct using a non-packing strategy.
- * 
- * Builds the mem_arr for memory layout using the strategy and keeps the number of bytes allocated
- * 
- * @param at_struct Struct type.
- * @param mem_arr Memory layout of the type.
- * @param mem_index_ptr Mem index to the last byte placed in memory.
- * @param bytes Union type.
- * @return vector of integers. bytes[0] contains the num of active bytes, bytes[1] contains the num of wasted bytes to alignment, bytes[2] contains the total number of bytes occupied
- */
-vector<int> print_struct_wt_packing_aux(const atomic_struct& at_struct, vector<int>& mem_arr, int& mem_index_ptr, vector<int>& bytes) {
-
-    for (const auto& field_name : at_struct.fields) {
-        if (types_arr[field_name].kind == ATOMIC){
-            aatomic type = get<aatomic>(types_arr[field_name].at);
-
-            if (mem_index_ptr % type.align == 0) {
-                int i = 0;
-                while (i < type.size){
-                    mem_arr.push_back(1);
-                    bytes[0]++;
-                    mem_index_ptr++;
-                    i++;
-                }
-            } else {
-                int i = 0;
-                while (mem_index_ptr % type.align != 0){
-                    mem_arr.push_back(0);
-                    bytes[1]++;
-                    mem_index_ptr++;
-                }
-                i = 0;
-                while (i < type.size){
-                    mem_arr.push_back(1);
-                    bytes[0]++;
-                    mem_index_ptr++;
-                    i++;
-                }
-            }
-        } 
-        else if (types_arr[field_name].kind == STRUCT) {
-            atomic_struct type = get<atomic_struct>(types_arr[field_name].at);
-            bytes = print_struct_wt_packing_aux(type, mem_arr, mem_index_ptr, bytes);
-        } else if (types_arr[field_name].kind == UNION) {
-            atomic_union type = get<atomic_union>(types_arr[field_name].at);
-            if (mem_index_ptr % type.align == 0) {
-                int i = 0;
-                while (i < type.size){
-                    mem_arr.push_back(1);
-                    bytes[0]++;
-                    mem_index_ptr++;
-                    i++;
-                }
-            } else {
-                int i = 0;
-                while (mem_index_ptr % type.align != 0){
-                    mem_arr.push_back(0);
-                    bytes[1]++;
-                    mem_index_ptr++;
-                }
-                i = 0;
-                while (i < type.size){
-                    mem_arr.push_back(1);
-                    bytes[0]++;
-                    mem_index_ptr++;
-                    i++;
-                }
-            }
-        }
-    }
-    bytes[2] = bytes[0] + bytes[1];
-
-    return bytes;
-}
-
-/**
- * Auxiliary function to printing the memory layout of a struct using a packing strategy.
- * 
- * Builds the mem_arr for memory layout using the strategy and keeps the number of bytes allocated
- * 
- * @param at_struct Struct type.
- * @param mem_arr Memory layout of the type.
- * @param mem_index_ptr Mem index to the last byte placed in memory.
- * @param bytes Union type.
- * @return vector of integers. bytes[0] contains the num of active bytes, bytes[1] contains the num of wasted bytes to alignment, bytes[2] contains the total number of bytes occupied
- */
-vector<int> print_struct_w_packing_aux(const atomic_struct& at_struct, vector<int>& mem_arr, int& mem_index_ptr, vector<int>& bytes) {
-
-    for (const auto& field_name : at_struct.fields) {
-        if (types_arr[field_name].kind == ATOMIC){
-            aatomic type = get<aatomic>(types_arr[field_name].at);
-            int i = 0;
-            while (i < type.size){
-                mem_arr.push_back(1);
-                bytes[0]++;
-                mem_index_ptr++;
-                i++;
-            }
-        } 
-        else if (types_arr[field_name].kind == STRUCT) {
-            atomic_struct type = get<atomic_struct>(types_arr[field_name].at);
-            bytes = print_struct_w_packing_aux(type, mem_arr, mem_index_ptr, bytes);
-        } else if (types_arr[field_name].kind == UNION) {
-            atomic_union type = get<atomic_union>(types_arr[field_name].at);
-            int i = 0;
-            while (i < type.size){
-                mem_arr.push_back(1);
-                bytes[0]++;
-                mem_index_ptr++;
-                i++;
-            }
-        }
-    }
-    bytes[2] = bytes[0] + bytes[1];
-
-    return bytes;
-}
-
-/**
- * Prints the memory layout of a struct using a packing strategy.
- * 
- * @param at_struct Struct type.
- * @param word_size Defines the word size to check for type alignment in memory layout
- */
-void print_struct_w_packing(const atomic_struct& at_struct, int word_size = 4){
-    vector<int> mem_arr = {};
-    int mem_index_ptr = 0;
-    vector<int> bytes_init = {0, 0, 0};
-    vector<int> bytes = print_struct_w_packing_aux(at_struct, mem_arr, mem_index_ptr, bytes_init);
-
-    cout << "Struct Type: " << at_struct.name << ", Bytes allocated: " << bytes[2] << " bytes, Bytes lost: " << bytes[1] <<endl;
-
-    print_mem_layout_diagram(mem_arr, word_size);
-}
-
-/**
- * Prints the memory layout of a struct using a non-packing strategy.
- * 
- * @param at_struct Struct type.
- * @param word_size Defines the word size to check for type alignment in memory layout
- */
-void print_struct_wt_packing(const atomic_struct& at_struct, int word_size = 4){
-    vector<int> mem_arr = {};
-    int mem_index_ptr = 0;
-    vector<int> bytes_init = {0, 0, 0};
-    vector<int> bytes = print_struct_wt_packing_aux(at_struct, mem_arr, mem_index_ptr, bytes_init);
-
-    cout << "Struct Type: " << at_struct.name << ", Bytes allocated: " << bytes[2] << " bytes, Bytes lost: " << bytes[1] <<endl;
-
-    print_mem_layout_diagram(mem_arr, word_size);
-}
-
-/**
- * Prints the memory layout of a union type.
- * 
- * @param at_struct Struct type.
- * @param word_size Defines the word size to check for type alignment in memory layout
- */
-void print_union (const atomic_union& at, int word_size = 4){
-    int num_of_cells = ceil((double)at.size / word_size) * word_size;
-    if (num_of_cells == 0){
-        num_of_cells = word_size;
-    }
-    vector<int> mem_arr(num_of_cells, 0);
-
-    for (int i = 0; i < at.size; i++) {
-        mem_arr[i] = 1;
-    }
-
-    print_mem_layout_diagram(mem_arr, word_size);
-
-    cout << "Union Type: " << at.name << "\nSize: " << at.size << " bytes\nAlignment: " << at.align << " bytes"<<endl;
-
-}
-
-/**
- * Prints the memory layout of an atomic type.
- * 
- * @param at Atomic type.
- * @param word_size Defines the word size to check for type alignment in memory layout
- */
-void print_atomic(const aatomic& at, int word_size = 4) {
-    int num_of_cells = ceil((double) at.size / word_size) * word_size;
-
-    if (num_of_cells == 0){
-        num_of_cells = word_size;
-    }
-
-    vector<int> mem_arr(num_of_cells, 0);
-
-    for (int i = 0; i < at.size; i++) {
-        mem_arr[i] = 1;
-    }
-
-    print_mem_layout_diagram(mem_arr, word_size);
-
-    cout << "Atomic Type: " << at.name << "\nSize: " << at.size << " bytes\nAlignment: " << at.align << " bytes"<<endl;
-
-}
-
-/**
- * Stores pair (key, value) in global map to keep list of atomic types during execution.
- * 
- * Creates an atomic type.
- * 
- * @param arr Map of types.
- * @param name Sets the name of the atomic type
- * @param size Set the size of atomic type.
- * @param align Sets the alignment of atomic type.
- */
-void push_atomic(map<string, atomic_type>& arr, const string& name, int size, int align){
-    if (size <= 0 || align <= 0) {
-        throw runtime_error("Error: Size and alignment must be positive integers.");
-    }
-
-    atomic_type at;
-    at.kind = ATOMIC;
-    at.at = aatomic{name, size, align};
-    arr[name] = at;
-}
-
-/**
- * Stores pair (key, value) in global map to keep list of atomic types during execution.
- * 
- * Creates a struct type.
- * 
- * @param arr Map of types.
- * @param name Sets the name of the struct type
- * @param fields Arr of strings containing the identifiers of types existing in the type map. They are the fields of the struct type.
- */
-void push_struct(map<string, atomic_type>& arr, const string& name, vector<string> fields){
-
-    for (const auto& f : fields) {
-        if (f == name) {
-            throw runtime_error("Error: Recursive declaration of type '" + name + "'");
-        }
-    }
-
-    atomic_type at;
-    at.kind = STRUCT;
-    at.at = atomic_struct{name, fields};
-    atomic_struct* at_struct = &(get<atomic_struct>(at.at));
-    int size = calc_size_struct(get<atomic_struct>(at.at));
-    int align = calc_align_struct(get<atomic_struct>(at.at));
-    at_struct->size = size;
-    at_struct->align = align;
-    arr[name] = at;
-}
-
-/**
- * Stores pair (key, value) in global map to keep list of atomic types during execution.
- * 
- * Creates a union type.
- * 
- * @param arr Map of types.
- * @param name Sets the name of the union type
- * @param fields Arr of strings containing the identifiers of types existing in the type map. They are the fields of the union type.
- */
-
-void push_union(map<string, atomic_type>& arr, const string& name, vector<string> fields){
-    for (const auto& f : fields) {
-        if (f == name) {
-            throw runtime_error("Error: Recursive declaration of type '" + name + "'");
-        }
-    }
-    atomic_type at;
-    at.kind = UNION;
-    at.at = atomic_union{name, fields};
-    atomic_union * at_union = &(get<atomic_union>(at.at));
-    int size = calc_size_union(get<atomic_union>(at.at));
-    int align = calc_align_union(get<atomic_union>(at.at));
-    at_union->size = size;
-    at_union->align = align;
-    arr[name] = at;
-}
-
-/**
- * Parses the input of the user in tokens.
- * 
- * @param line Input string given by user.
- * @return Arr of tokens collected in a line separed by whitespaces.
- */
-vector<string> split(const string& line) {
-    vector<string> tokens;
-    string token;
-    istringstream iss(line);
-
-    while (iss >> token)
-        tokens.push_back(token);
-
-    return tokens;
-}
-
-/**
- * Checks if a token is an integer.
- * 
- * @param s Token.
- * @return True if token is integer. False otherwise.
- */
-bool is_integer(const string& s) {
-    size_t pos;
-    try {
-        stoi(s, &pos);
-        return pos == s.size(); // si consumió todo el string, es válido
-    } catch (...) {
-        return false;
-    }
-}
-
-/**
- * Auxiliary function that lists the types defined so far during execution of the program.
- * 
- * @param types Map of types.
- */
-void print_types() {
-    for (const auto& [key, type] : types_arr) {
-        cout << "Type name: " << key << endl;
-
-        switch (type.kind) {
-            case ATOMIC: {
-                const aatomic& a = get<aatomic>(type.at);
-                cout << "  Kind: ATOMIC\n";
-                cout << "  Size: " << a.size << ", Align: " << a.align << "\n";
-                break;
-            }
-
-            case STRUCT: {
-                const atomic_struct& s = get<atomic_struct>(type.at);
-                cout << "  Kind: STRUCT\n";
-                cout << "  Fields: ";
-                for (const auto& f : s.fields) {
-                    cout << f << " ";
-                }
-
-                vector<string> fields_init = {};
-                vector<string> fields = sort_struct_fields_by_alignment(s, fields_init);
-                cout << "\n  Size: " << s.size << " bytes" << endl;
-                cout << "  Align: " << s.align << " bytes" << endl;
-                cout << "  Fields: " << endl;
-                for (const auto& f : fields) {
-                    cout << "  " << f << " ";
-                }
-                cout << endl;
-                break;
-            }
-
-            case UNION: {
-                const atomic_union& u = get<atomic_union>(type.at);
-                cout << "  Kind: UNION\n";
-                cout << "  Fields: ";
-                for (const auto& f : u.fields) {
-                    cout << f << " ";
-                }
-                cout << "\n  Size: " << u.size << " bytes" << endl;
-                cout << "  Align: " << u.align << " bytes" << endl;
-                break;
-            }
-        }
-
-        cout << "-----------------------------\n";
-    }
-}
+#ifndef FUNCTIONS_HPP
+#define FUNCTIONS_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <variant>
+#include <sstream>
+#include <cmath>
+#include <numeric>
+#include <climits>
+#include <stdexcept>
+#include <charconv>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+
+using namespace std;
+
+/**
+ * Structs for modelling atomic types, structs and unions.
+ * 
+ * The special type "atomic_type" is a variant type for creating a dict that can contains all three types in a single structures
+ * such that declarations using the same identifier overlap one another and to ease accesability for other functions and procedures
+ * that consults the dictionary as a map. It contains a discriminant field "kind" that identifies if it's an atomic type, a struct
+ * or a union. This kind is of type enum AtomicKind that lists the types ATOMIC, STRUCT, UNION and maps each type with integers 0, 1
+ * and 2. 
+ * 
+ * BITFIELD (3) models a struct member with a declared width in bits stored in an atomic unit. Its size and alignment are the
+ * ones of the unit, but the layout strategies place it at bit granularity.
+ * 
+ * VARIANT (4) models a variant record: a tag of an atomic type plus a union of alternatives. Its declared size and
+ * alignment are the ones of the tag placed before the union, as a C struct would do; compute_variant_placements searches
+ * better places for the tag.
+ */
+
+struct aatomic {
+    string name;
+    long long size;
+    int align;
+};
+
+struct atomic_struct{
+    string name;
+    vector<string> fields;
+    long long size = 0;
+    int align = 0;
+    int max_align = 0; // Tope de la alineacion puesto por #pragma pack, 0 si no tiene
+};
+
+struct atomic_union{
+    string name;
+    vector<string> fields;
+    long long size = 0;
+    int align = 0;
+    int max_align = 0;
+};
+
+struct atomic_bitfield{
+    string name;
+    int bits = 0;
+    string unit;
+    long long size = 0;
+    int align = 0;
+};
+
+struct atomic_variant{
+    string name;
+    string tag;
+    vector<string> fields;
+    long long size = 0;
+    int align = 0;
+};
+
+enum AtomicKind { ATOMIC, STRUCT, UNION, BITFIELD, VARIANT };
+
+struct atomic_type {
+    AtomicKind kind;
+    variant<aatomic, atomic_struct, atomic_union, atomic_bitfield, atomic_variant> at;
+};
+
+/**
+ * Work done by the commands run in a thread: type table lookups and bytes of the layouts computed. The allocations are
+ * counted apart, by the replacement of operator new (see Stats.cpp).
+ *
+ * The counters are only updated while command_counters_enabled is set, so when the statistics are off each counted
+ * operation costs the check of a flag. A command reads them before and after running to get its own share.
+ */
+struct command_counters {
+    long long lookups = 0;
+    long long layout_bytes = 0;
+};
+
+atomic<bool> command_counters_enabled{false};
+thread_local command_counters current_counters;
+
+map<string, atomic_type> types_arr = {};
+
+/**
+ * Looks up a type by name in a table, counting the lookup in current_counters while the statistics are on.
+ *
+ * The functions that look up the fields of a type go through it, since the work of a command grows with those lookups.
+ *
+ * @param table Type table.
+ * @param name Type name. It must be in the table.
+ * @return the type.
+ */
+const atomic_type& lookup_type(const map<string, atomic_type>& table, const string& name) {
+    if (command_counters_enabled.load(memory_order_relaxed)) current_counters.lookups++;
+    return table.at(name);
+}
+
+/**
+ * Looks up a type that may not exist by name in a table, counting the lookup like lookup_type.
+ *
+ * @param table Type table.
+ * @param name Type name.
+ * @return the type, or nullptr if it isn't in the table.
+ */
+const atomic_type* find_type(const map<string, atomic_type>& table, const string& name) {
+    if (command_counters_enabled.load(memory_order_relaxed)) current_counters.lookups++;
+    auto found = table.find(name);
+    return found == table.end() ? nullptr : &found->second;
+}
+
+/**
+ * Names of the types of types_arr defined or redefined since the indexes of the table were last brought up to date.
+ *
+ * The indexes read it to update only those types instead of the whole table.
+ */
+unordered_set<string> changed_types = {};
+
+/**
+ * Records that a type of a table was defined or redefined. Only changes to types_arr are recorded.
+ *
+ * @param arr Map of types.
+ * @param name Type name.
+ */
+void note_type_change(const map<string, atomic_type>& arr, const string& name) {
+    if (&arr == &types_arr) {
+        changed_types.insert(name);
+    }
+}
+
+// map<string, atomic_type> types_arr = {
+//     { "char",   { ATOMIC, aatomic{"char",   1, 1} }},
+//     { "short",  { ATOMIC, aatomic{"short",  2, 2} }},
+//     { "int",    { ATOMIC, aatomic{"int",    4, 4} }},
+//     { "long",   { ATOMIC, aatomic{"long",   8, 8} }},
+//     { "float",  { ATOMIC, aatomic{"float",  4, 4} }},
+//     { "double", { ATOMIC, aatomic{"double", 8, 8} }},
+//     { "bool",   { ATOMIC, aatomic{"bool",   1, 2} }},
+//     {"MyStruct1", {STRUCT, atomic_struct{"MyStruct1", {"int", "char", "char", "int", "double", "bool"}, 19, 4}}},
+//     {"MyStruct2", {STRUCT, atomic_struct{"MyStruct2", {"short", "float", "char", "long"}, 15, 2}}},
+//     {"Union1", {UNION, atomic_union{"MyUnion1", {"double", "bool", "int"}, 8, 8}}},
+//     {"Union2", {UNION, atomic_union{"MyUnion2", {"Union1", "MyStruct2"}, 15, 8}}}
+// };
+
+//DECLARACIONES
+long long calc_size_union (const atomic_union& at_union);
+long long calc_size_struct (const atomic_struct& at_struct);
+int calc_align_union (const atomic_union& at_union);
+int calc_align_struct (const atomic_struct& at_struct);
+//DECLARACIONES
+
+/**
+ * Adds two sizes checking for overflow.
+ * 
+ * @param a First size.
+ * @param b Second size.
+ * @return a + b. Throws overflow_error if the result doesn't fit in 64 bits.
+ */
+long long checked_add(long long a, long long b) {
+    long long result;
+    if (__builtin_add_overflow(a, b, &result)) {
+        throw overflow_error("Error: Size overflow adding " + to_string(a) + " and " + to_string(b) + " bytes.");
+    }
+    return result;
+}
+
+/**
+ * Multiplies two sizes checking for overflow.
+ * 
+ * @param a First size.
+ * @param b Second size.
+ * @return a * b. Throws overflow_error if the result doesn't fit in 64 bits.
+ */
+long long checked_mul(long long a, long long b) {
+    long long result;
+    if (__builtin_mul_overflow(a, b, &result)) {
+        throw overflow_error("Error: Size overflow multiplying " + to_string(a) + " by " + to_string(b) + ".");
+    }
+    return result;
+}
+
+/**
+ * Entry of an offset table. Describes where a field is placed inside the layout of a type.
+ * 
+ * bits is the declared width of a bitfield (0 for the rest of the fields, which take size whole bytes). bit_offset is the
+ * position of the field in bits and offset the byte that contains its first bit. id is the position of the field in the
+ * flattened declaration of its struct, or -1 when unknown.
+ */
+struct field_slot {
+    string name;
+    long long offset = 0;
+    long long size = 0;
+    int align = 1;
+    int bits = 0;
+    long long bit_offset = 0;
+    long long id = -1;
+};
+
+/**
+ * Offset table of a type for a given strategy, sorted by placement order.
+ * 
+ * size is the number of bytes allocated, used the number of bytes occupied by fields and lost the bytes wasted to alignment
+ * between them. align is the alignment the layout needs (the greatest alignment of its fields, 1 when packing), tail the
+ * padding added after the last field so the next element of an array stays aligned and stride the distance between two
+ * consecutive elements of an array.
+ * 
+ * The strategies work at bit granularity: size_bits, used_bits and lost_bits hold the same statistics in bits. When the
+ * type has bitfields (has_bits) the byte counters count the bytes touched by at least one field.
+ */
+struct struct_layout {
+    vector<field_slot> slots;
+    long long size = 0;
+    long long used = 0;
+    long long lost = 0;
+    int align = 1;
+    long long tail = 0;
+    long long stride = 0;
+    bool has_bits = false;
+    long long size_bits = 0;
+    long long used_bits = 0;
+    long long lost_bits = 0;
+};
+
+/**
+ * Layout strategies.
+ * 
+ * UNPACKED, PACKED and HEURISTIC expand nested structs inline. OPAQUE lays each nested struct as an aligned block that
+ * includes its trailing padding, and TAIL_REUSE lays it as a block without that padding, so the next fields of the outer
+ * struct can reuse it (as [[no_unique_address]] and the Itanium rules for non-POD types allow). Both apply to the fields
+ * given to compute_layout the same way UNPACKED does.
+ */
+enum LayoutStrategy { UNPACKED, PACKED, HEURISTIC, OPAQUE, TAIL_REUSE };
+
+/**
+ * Rounds offset up to the next multiple of align.
+ * 
+ * @param offset Memory position.
+ * @param align Alignment to satisfy.
+ * @return the smallest multiple of align greater or equal than offset.
+ */
+long long align_up(long long offset, long long align) {
+    if (align <= 1) {
+        return offset;
+    }
+    return checked_add(offset, align - 1) / align * align;
+}
+
+/**
+ * Limits the alignment of an aggregate to the cap of its definition, as #pragma pack does.
+ * 
+ * Only the alignment changes: the aggregate keeps the layout and sizeof it has without the cap.
+ * 
+ * @param align Natural alignment of the aggregate.
+ * @param max_align Cap of the alignment, 0 for none.
+ * @return the alignment the aggregate has as a field.
+ */
+int capped_align(int align, int max_align) {
+    return max_align > 0 ? min(align, max_align) : align;
+}
+
+/**
+ * Counts the bytes touched by a list of bit ranges.
+ * 
+ * @param ranges Pairs (first bit, width in bits).
+ * @return number of bytes that contain at least one bit of a range.
+ */
+long long touched_bytes(vector<pair<long long, long long>> ranges) {
+    sort(ranges.begin(), ranges.end());
+    long long touched = 0;
+    long long cursor = 0;
+    for (const auto& [start, width] : ranges) {
+        if (width <= 0) continue;
+        long long first = max(start / 8, cursor);
+        long long last = (start + width + 7) / 8;
+        if (last > first) {
+            touched += last - first;
+            cursor = last;
+        }
+    }
+    return touched;
+}
+
+/**
+ * Finds the first bit, from pos onwards, where a field can be placed with the given strategy.
+ * 
+ * PACKED places bitfields right after the previous field and the rest of the fields on the next byte. Otherwise a field
+ * is aligned to its alignment and a bitfield stays at pos unless it would cross the boundary of its storage unit, in
+ * which case it starts the next unit.
+ * 
+ * @param slot Field to place.
+ * @param pos Candidate position in bits.
+ * @param strategy Layout strategy.
+ * @return position in bits where the field starts.
+ */
+long long place_field_bits(const field_slot& slot, long long pos, LayoutStrategy strategy) {
+    if (slot.bits > 0) {
+        if (strategy == PACKED) {
+            return pos;
+        }
+        long long unit_align = 8LL * slot.align;
+        long long unit_start = pos / unit_align * unit_align;
+        if (pos + slot.bits <= unit_start + 8 * slot.size) {
+            return pos;
+        }
+        return align_up(pos, unit_align);
+    }
+    return align_up(pos, strategy == PACKED ? 8 : 8LL * slot.align);
+}
+
+/**
+ * Builds the offset table of a list of leaf fields using the given strategy.
+ * 
+ * UNPACKED lays the fields in declaration order respecting their alignment, PACKED lays them one after another ignoring
+ * alignment and HEURISTIC sorts them by alignment (greater first) and places each one in the first aligned hole big enough
+ * to hold it, the same way print_struct_heuristics does. Holes are kept as a list of gaps so the cost depends on the
+ * number of fields and not on the number of bytes. Positions are computed in bits so bitfields can share bytes.
+ * 
+ * @param leaves Atomic fields of the type with their size and alignment set.
+ * @param strategy Layout strategy.
+ * @param keep_slots If false only the totals are computed and the offset table is left empty.
+ * @return the offset table of the type.
+ */
+struct_layout compute_layout(vector<field_slot> leaves, LayoutStrategy strategy, bool keep_slots = true) {
+    struct_layout layout;
+    bool any_bits = any_of(leaves.begin(), leaves.end(), [](const field_slot& slot) { return slot.bits > 0; });
+
+    if (strategy == HEURISTIC) {
+        stable_sort(leaves.begin(), leaves.end(),
+            [](const field_slot& a, const field_slot& b) { return a.align > b.align; });
+    }
+
+    vector<pair<long long, long long>> gaps; // (start, length) in bits of the holes left before the end of the layout
+    vector<pair<long long, long long>> ranges;
+    long long end = 0;
+
+    for (auto& slot : leaves) {
+        bool is_allocated = false;
+        long long width = slot.bits > 0 ? slot.bits : checked_mul(slot.size, 8);
+        long long start = 0;
+
+        if (strategy == HEURISTIC) {
+            for (size_t g = 0; g < gaps.size(); g++) {
+                long long gap_start = gaps[g].first;
+                long long gap_end = gaps[g].first + gaps[g].second;
+                start = place_field_bits(slot, gap_start, strategy);
+
+                if (start < gap_end && width <= gap_end - start) {
+                    vector<pair<long long, long long>> pieces;
+                    if (start > gap_start) pieces.push_back({gap_start, start - gap_start});
+                    if (start + width < gap_end) pieces.push_back({start + width, gap_end - start - width});
+                    gaps.erase(gaps.begin() + g);
+                    gaps.insert(gaps.begin() + g, pieces.begin(), pieces.end());
+                    is_allocated = true;
+                    break;
+                }
+            }
+        }
+
+        if (!is_allocated) {
+            start = place_field_bits(slot, end, strategy);
+            if (start > end) {
+                gaps.push_back({end, start - end});
+            }
+            end = checked_add(start, width);
+        }
+
+        slot.bit_offset = start;
+        slot.offset = start / 8;
+        layout.has_bits = layout.has_bits || slot.bits > 0;
+        if (any_bits) {
+            ranges.push_back({start, width});
+        }
+        if (strategy != PACKED) {
+            layout.align = max(layout.align, slot.align);
+        }
+        layout.used_bits = checked_add(layout.used_bits, width);
+        layout.used = checked_add(layout.used, slot.size);
+        if (keep_slots) {
+            layout.slots.push_back(slot);
+        }
+    }
+
+    layout.size_bits = end;
+    layout.lost_bits = end - layout.used_bits;
+    layout.size = (end + 7) / 8;
+
+    if (layout.has_bits) {
+        layout.used = touched_bytes(ranges);
+    }
+
+    layout.lost = layout.size - layout.used;
+    layout.stride = align_up(layout.size, layout.align);
+    layout.tail = layout.stride - layout.size;
+    if (command_counters_enabled.load(memory_order_relaxed)) current_counters.layout_bytes += layout.size;
+    return layout;
+}
+
+/**
+ * Prints the size, trailing padding and stride of a layout.
+ * 
+ * @param layout Offset table of a type.
+ * @param instances If positive, also prints the memory needed by an array with that number of elements.
+ * @param out Stream where the output is written.
+ */
+void print_layout_totals(const struct_layout& layout, long long instances = 0, ostream& out = cout) {
+    if (layout.has_bits) {
+        out << "Bits allocated: " << layout.size_bits << " bits, Bits lost: " << layout.lost_bits << " bits" << '\n';
+    }
+    out << "Size: " << layout.size << " bytes, Tail padding: " << layout.tail << " bytes, Stride: " << layout.stride << " bytes" << '\n';
+    if (instances > 0) {
+        out << "Per instance: " << layout.stride << " bytes, " << instances << " instances: "
+             << checked_mul(layout.stride, instances) << " bytes" << '\n';
+    }
+}
+
+/**
+ * Run of consecutive bytes with the same state in a memory layout.
+ * 
+ * value is 1 for bytes occupied by fields and 0 for bytes lost to alignment. A list of runs is the sparse counterpart of
+ * mem_arr: it takes memory proportional to the number of fields instead of the number of bytes.
+ */
+struct mem_run {
+    long long start;
+    long long length;
+    int value;
+};
+
+/**
+ * Builds the sparse representation of an offset table, or of a window of it.
+ * 
+ * The first field of the window is found by binary search over the offset table (sorted by offset first if the strategy
+ * placed the fields out of order), so the fields before the window are skipped and the ones after it are never visited.
+ * 
+ * @param layout Offset table of a type.
+ * @param in_bits If true the runs are measured in bits, otherwise a byte is occupied when any of its bits is.
+ * @param from First position of the window, in the unit of the runs.
+ * @param to Position past the end of the window. It's cut at the size of the layout.
+ * @return runs sorted by position, covering the window. Adjacent runs with the same value are merged.
+ */
+vector<mem_run> layout_runs(const struct_layout& layout, bool in_bits = false, long long from = 0, long long to = LLONG_MAX) {
+    auto by_offset = [](const field_slot& a, const field_slot& b) { return a.bit_offset < b.bit_offset; };
+
+    vector<field_slot> sorted;
+    const vector<field_slot>* slots = &layout.slots;
+    if (!is_sorted(layout.slots.begin(), layout.slots.end(), by_offset)) {
+        sorted = layout.slots;
+        sort(sorted.begin(), sorted.end(), by_offset);
+        slots = &sorted;
+    }
+
+    auto slot_first = [in_bits](const field_slot& slot) { return in_bits ? slot.bit_offset : slot.offset; };
+    auto slot_last = [in_bits](const field_slot& slot) {
+        long long bit_end = slot.bit_offset + (slot.bits > 0 ? slot.bits : 8 * slot.size);
+        return in_bits ? bit_end : (bit_end + 7) / 8;
+    };
+
+    vector<mem_run> runs;
+    from = max(from, 0LL);
+    to = min(to, in_bits ? layout.size_bits : layout.size);
+    if (from >= to) return runs;
+
+    long long cursor = from;
+
+    auto push_run = [&runs](long long start, long long length, int value) {
+        if (length <= 0) return;
+        if (!runs.empty() && runs.back().value == value && runs.back().start + runs.back().length == start) {
+            runs.back().length += length;
+        } else {
+            runs.push_back(mem_run{start, length, value});
+        }
+    };
+
+    // Los campos no se solapan, asi que ordenados por inicio tambien quedan ordenados por fin
+    auto it = partition_point(slots->begin(), slots->end(),
+        [&](const field_slot& slot) { return slot_last(slot) <= from; });
+
+    for (; it != slots->end() && slot_first(*it) < to; ++it) {
+        long long first = max(slot_first(*it), cursor);
+        long long last = min(slot_last(*it), to);
+        push_run(cursor, first - cursor, 0);
+        push_run(first, last - first, 1);
+        cursor = max(cursor, last);
+    }
+    push_run(cursor, to - cursor, 0);
+
+    return runs;
+}
+
+/**
+ * Appends a number to a buffer, right aligned to a width.
+ * 
+ * @param out Buffer.
+ * @param value Number to append.
+ * @param width Minimum number of characters, completed with spaces on the left.
+ */
+void append_padded(string& out, long long value, int width) {
+    char digits[24];
+    char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    for (long long pad = width - (end - digits); pad > 0; pad--) out.push_back(' ');
+    out.append(digits, end);
+}
+
+/**
+ * Renders a memory layout given as a list of runs.
+ * 
+ * Each row holds a word. Consecutive rows inside the same run are collapsed into a single "rows N..M: all 1s" line, so at
+ * most a couple of rows per run are rendered cell by cell and the time doesn't depend on the size of the layout. The
+ * output is built in a single buffer reserved up front. The runs may start past 0, as for a window of a layout, in which
+ * case the cells before the first run are left blank.
+ * 
+ * @param runs Sparse memory layout of the type.
+ * @param word_size Defines the word size in the memory layout to visually check for type alignment.
+ * @param in_bits If true the runs are measured in bits and bits are grouped by byte.
+ * @return the rendered diagram.
+ */
+string render_runs_diagram(const vector<mem_run>& runs, int word_size = 4, bool in_bits = false) {
+    long long total = runs.empty() ? 0 : runs.back().start + runs.back().length;
+    long long row_cells = in_bits ? 8LL * word_size : word_size;
+    long long cells_per_byte = in_bits ? 8 : 1;
+
+    string out;
+    out.reserve(128 + (2 * runs.size() + 1) * (2 * row_cells + 64));
+    out.append(" - - - - - - - - - - - -\n Memory Layout Diagram (each '1' represents a ");
+    out.append(in_bits ? "bit):" : "byte):");
+
+    size_t r = 0;
+    long long pos = runs.empty() ? 0 : runs.front().start;
+    while (pos < total) {
+        while (runs[r].start + runs[r].length <= pos) r++;
+
+        long long full_rows = pos % row_cells == 0 ? (runs[r].start + runs[r].length - pos) / row_cells : 0;
+        if (full_rows >= 2) {
+            long long end = pos + full_rows * row_cells;
+            out.append("\n rows ");
+            append_padded(out, pos / row_cells, 0);
+            out.append("..");
+            append_padded(out, end / row_cells - 1, 0);
+            out.append(runs[r].value ? ": all 1s (bytes " : ": all 0s (bytes ");
+            append_padded(out, pos / cells_per_byte, 0);
+            out.append("..");
+            append_padded(out, end / cells_per_byte - 1, 0);
+            out.push_back(')');
+            pos = end;
+            continue;
+        }
+
+        long long row_start = pos - pos % row_cells;
+        long long row_end = min(row_start + row_cells, total);
+        out.append("\n ");
+        append_padded(out, row_start / cells_per_byte, 3);
+        out.append(" | ");
+        for (long long i = row_start; i < row_end; i++) {
+            if (i < pos) {
+                out.push_back(' ');
+            } else {
+                while (runs[r].start + runs[r].length <= i) r++;
+                out.push_back(runs[r].value ? '1' : '0');
+            }
+            if ((i + 1) % row_cells == 0) {
+                out.append(" |");
+            } else if (!in_bits || (i + 1) % 8 == 0) {
+                out.push_back(' ');
+            }
+        }
+        pos = row_end;
+    }
+
+    out.append("\n - - - - - - - - - - - -\n");
+    return out;
+}
+
+/**
+ * Prints type layout in memory.
+ * 
+ * @param mem_arr Contains either 1s or 0s. 1 stands for an active byte in memory occupied by the type.
+ * @param word_size Defines the word size in the memory layout to visually check for type alignment.
+ * @param out Stream where the output is written.
+ */
+void print_mem_layout_diagram(const vector<int>& mem_arr, int word_size = 4, ostream& out = cout) {
+    vector<mem_run> runs;
+    for (long unsigned int i = 0; i < mem_arr.size(); i++) {
+        if (!runs.empty() && runs.back().value == mem_arr[i]) {
+            runs.back().length++;
+        } else {
+            runs.push_back(mem_run{(long long) i, 1, mem_arr[i]});
+        }
+    }
+    out << render_runs_diagram(runs, word_size);
+}
+
+/**
+ * Prints type layout in memory given as a list of runs.
+ * 
+ * @param runs Sparse memory layout of the type.
+ * @param word_size Defines the word size in the memory layout to visually check for type alignment.
+ * @param out Stream where the output is written.
+ */
+void print_mem_runs_diagram(const vector<mem_run>& runs, int word_size = 4, ostream& out = cout) {
+    out << render_runs_diagram(runs, word_size);
+}
+
+/**
+ * Prints type layout in memory at bit granularity, for types with bitfields.
+ * 
+ * @param bit_runs Sparse memory layout of the type measured in bits.
+ * @param word_size Defines the word size in the memory layout to visually check for type alignment.
+ * @param out Stream where the output is written.
+ */
+void print_bit_layout_diagram(const vector<mem_run>& bit_runs, int word_size = 4, ostream& out = cout) {
+    out << render_runs_diagram(bit_runs, word_size, true);
+}
+
+/**
+ * Prints the memory layout of an offset table, at bit granularity when it has bitfields.
+ * 
+ * @param layout Offset table of a type.
+ * @param word_size Defines the word size in the memory layout to visually check for type alignment.
+ * @param from First byte printed.
+ * @param to Byte past the last one printed.
+ * @param out Stream where the output is written.
+ */
+void print_layout_diagram(const struct_layout& layout, int word_size = 4, long long from = 0, long long to = LLONG_MAX, ostream& out = cout) {
+    if (layout.has_bits) {
+        // Pasado el final del tipo no hay bytes que mostrar; el recorte evita desbordar al pasar a bits
+        long long bit_from = checked_mul(min(from, layout.stride), 8);
+        long long bit_to = to > LLONG_MAX / 8 ? LLONG_MAX : 8 * to;
+        print_bit_layout_diagram(layout_runs(layout, true, bit_from, bit_to), word_size, out);
+    } else {
+        print_mem_runs_diagram(layout_runs(layout, false, from, to), word_size, out);
+    }
+}
+
+/**
+ * Renders the offset table of a type one run per line, each run labeled with the field that occupies it.
+ * 
+ * Fields are labeled "#<id> <type>", where id is the position of the field in the declaration (after flattening nested
+ * structs). Each padding run is labeled with the field it precedes and the padding after the last field up to the stride
+ * as tail padding. The map is built from the slots, so it takes one line per field whatever the size of the type. Layouts
+ * with bitfields are measured in bits.
+ * 
+ * @param layout Offset table of a type.
+ * @return the rendered field map.
+ */
+string render_field_map(const struct_layout& layout) {
+    vector<field_slot> slots = layout.slots;
+    sort(slots.begin(), slots.end(),
+        [](const field_slot& a, const field_slot& b) { return a.bit_offset < b.bit_offset; });
+
+    bool in_bits = layout.has_bits;
+    const char* unit = in_bits ? " bits" : " bytes";
+
+    string out;
+    out.reserve(64 + slots.size() * (48 + (slots.empty() ? 0 : slots[0].name.size())));
+    out.append(" - - - - - - - - - - - -\n Field Map (");
+    out.append(in_bits ? "bits" : "bytes");
+    out.append("):\n");
+
+    auto append_range = [&out](long long first, long long last) {
+        out.push_back(' ');
+        append_padded(out, first, 5);
+        out.append("..");
+        size_t mark = out.size();
+        append_padded(out, last, 0);
+        for (size_t w = out.size() - mark; w < 6; w++) out.push_back(' ');
+        out.append(" | ");
+    };
+
+    auto append_label = [&out](const field_slot& slot) {
+        if (slot.id >= 0) {
+            out.push_back('#');
+            append_padded(out, slot.id, 0);
+            out.push_back(' ');
+        }
+        out.append(slot.name);
+    };
+
+    long long cursor = 0;
+    for (const auto& slot : slots) {
+        long long bit_end = slot.bit_offset + (slot.bits > 0 ? slot.bits : 8 * slot.size);
+        long long first = in_bits ? slot.bit_offset : slot.offset;
+        long long last = in_bits ? bit_end : (bit_end + 7) / 8;
+
+        if (first > cursor) {
+            append_range(cursor, first - 1);
+            out.append("padding before ");
+            append_label(slot);
+            out.append(" (");
+            append_padded(out, first - cursor, 0);
+            out.append(unit);
+            out.append(")\n");
+        }
+        if (last > first) {
+            append_range(first, last - 1);
+            append_label(slot);
+            out.push_back('\n');
+        }
+        cursor = max(cursor, last);
+    }
+
+    long long total = in_bits ? 8 * layout.stride : layout.stride;
+    if (total > cursor) {
+        append_range(cursor, total - 1);
+        out.append("tail padding (");
+        append_padded(out, total - cursor, 0);
+        out.append(unit);
+        out.append(")\n");
+    }
+
+    out.append(" - - - - - - - - - - - -\n");
+    return out;
+}
+
+/**
+ * Builds the runs of a single block of memory, as printed for atomic types and unions.
+ * 
+ * @param size Size of the block.
+ * @param word_size The block is completed with 0s up to a multiple of the word size.
+ * @param from First byte of the window returned.
+ * @param to Byte past the end of the window returned.
+ * @return runs of the block inside the window.
+ */
+vector<mem_run> block_runs(long long size, int word_size = 4, long long from = 0, long long to = LLONG_MAX) {
+    long long num_of_cells = max(align_up(size, word_size), (long long) word_size);
+    long long end = min(num_of_cells, to);
+    long long used_end = min(size, end);
+    long long free_start = max(size, from);
+    from = max(from, 0LL);
+
+    vector<mem_run> runs;
+    if (used_end > from) runs.push_back(mem_run{from, used_end - from, 1});
+    if (end > free_start) runs.push_back(mem_run{free_start, end - free_start, 0});
+    return runs;
+}
+
+/**
+ * Collects recursively the fields in a struct.
+ * 
+ * @param at_struct Struct type.
+ * @param accumulator Contains the atomic fields collected so far during execution.
+ * @param table Type table where the fields are looked up.
+ */
+void collect_struct_fields(const atomic_struct& at_struct, vector<string>& accumulator, const map<string, atomic_type>& table = types_arr){
+    for (const auto& field_name : at_struct.fields) {
+
+        const auto& t = lookup_type(table, field_name);
+
+        if (t.kind == STRUCT) {
+            const auto& inner_struct = get<atomic_struct>(t.at);
+            collect_struct_fields(inner_struct, accumulator, table);
+        } else if (t.kind == ATOMIC || t.kind == UNION || t.kind == BITFIELD || t.kind == VARIANT) {
+            accumulator.push_back(field_name);
+        }
+    }
+}
+
+/**
+ * Sorts a list of types in function of their alignment.
+ * 
+ * This is an auxiliary function for the heuristics to optimize the memory layout of a type
+ * 
+ * @param at_struct Struct type.
+ * @param fields Contains the atomic fields of the struct.
+ * @return vector of atomic fields sorted by alignment.
+ */
+vector<string> sort_struct_fields_by_alignment(const atomic_struct& at_struct, vector<string>& fields) {
+    vector<string> all_fields;
+
+    collect_struct_fields(at_struct, all_fields);
+
+    sort(all_fields.begin(), all_fields.end(),
+        [](const string& a, const string& b) {
+            int align_a = 0;
+            int align_b = 0;
+
+            const atomic_type& ta = lookup_type(types_arr, a);
+            const atomic_type& tb = lookup_type(types_arr, b);
+
+            if (ta.kind == ATOMIC)
+                align_a = get<aatomic>(ta.at).align;
+            else if (ta.kind == STRUCT)
+                align_a = get<atomic_struct>(ta.at).align;
+            else if (ta.kind == UNION)
+                align_a = get<atomic_union>(ta.at).align;
+            else if (ta.kind == BITFIELD)
+                align_a = get<atomic_bitfield>(ta.at).align;
+            else if (ta.kind == VARIANT)
+                align_a = get<atomic_variant>(ta.at).align;
+
+            if (tb.kind == ATOMIC)
+                align_b = get<aatomic>(tb.at).align;
+            else if (tb.kind == STRUCT)
+                align_b = get<atomic_struct>(tb.at).align;
+            else if (tb.kind == UNION)
+                align_b = get<atomic_union>(tb.at).align;
+            else if (tb.kind == BITFIELD)
+                align_b = get<atomic_bitfield>(tb.at).align;
+            else if (tb.kind == VARIANT)
+                align_b = get<atomic_variant>(tb.at).align;
+
+            return align_a > align_b;
+        });
+
+    fields = all_fields;
+    return fields;
+}
+
+/**
+ * Gets the size and alignment of a type.
+ * 
+ * @param t Type.
+ * @return pair (size, align) of the type.
+ */
+pair<long long, int> type_size_align(const atomic_type& t) {
+    if (t.kind == STRUCT) {
+        const atomic_struct& s = get<atomic_struct>(t.at);
+        return {s.size, s.align};
+    } else if (t.kind == UNION) {
+        const atomic_union& u = get<atomic_union>(t.at);
+        return {u.size, u.align};
+    } else if (t.kind == BITFIELD) {
+        const atomic_bitfield& b = get<atomic_bitfield>(t.at);
+        return {b.size, b.align};
+    } else if (t.kind == VARIANT) {
+        const atomic_variant& v = get<atomic_variant>(t.at);
+        return {v.size, v.align};
+    }
+    const aatomic& a = get<aatomic>(t.at);
+    return {a.size, a.align};
+}
+
+/**
+ * Gets the cap #pragma pack set to the alignment of a type.
+ * 
+ * @param t Type.
+ * @return the cap of a struct or union, 0 if it has none or is of another kind.
+ */
+int type_max_align(const atomic_type& t) {
+    if (t.kind == STRUCT) return get<atomic_struct>(t.at).max_align;
+    if (t.kind == UNION) return get<atomic_union>(t.at).max_align;
+    return 0;
+}
+
+/**
+ * Gets the size and alignment of a type of the table.
+ * 
+ * @param name Type name.
+ * @param table Type table where the type is looked up.
+ * @return pair (size, align) of the type.
+ */
+pair<long long, int> type_size_align(const string& name, const map<string, atomic_type>& table = types_arr) {
+    return type_size_align(lookup_type(table, name));
+}
+
+/**
+ * Builds the entry of the offset table of a non-struct field, still unplaced.
+ * 
+ * @param name Type name of the field.
+ * @param table Type table where the field is looked up.
+ * @return slot with the size, alignment and width in bits of the field.
+ */
+field_slot leaf_slot(const string& name, const map<string, atomic_type>& table = types_arr) {
+    const atomic_type& t = lookup_type(table, name);
+    auto [size, align] = type_size_align(t);
+    int bits = t.kind == BITFIELD ? get<atomic_bitfield>(t.at).bits : 0;
+    return field_slot{name, 0, size, align, bits};
+}
+
+/**
+ * Builds the offset table of a struct laying its nested structs as opaque blocks.
+ * 
+ * Each nested struct is laid out first (with the same strategy) and placed as a block aligned to the alignment of its
+ * layout. With OPAQUE the block takes the stride of the nested struct and with TAIL_REUSE only up to its last field.
+ * The returned slots are the atomic fields with their absolute offsets, so the padding inside the blocks is accounted as lost.
+ * Their ids are the positions of the fields in the flattened declaration, as in the other strategies.
+ * 
+ * @param at_struct Struct type.
+ * @param strategy OPAQUE or TAIL_REUSE.
+ * @param memo Layouts of the nested structs already computed.
+ * @param table Type table where the fields are looked up.
+ * @return the offset table of the struct.
+ */
+struct_layout compute_nested_layout(const atomic_struct& at_struct, LayoutStrategy strategy, map<string, struct_layout>& memo,
+                                    const map<string, atomic_type>& table = types_arr) {
+    auto found = memo.find(at_struct.name);
+    if (found != memo.end()) {
+        return found->second;
+    }
+
+    vector<field_slot> blocks;
+    vector<const struct_layout*> inner_layouts;
+
+    for (const auto& field_name : at_struct.fields) {
+        const atomic_type& field = lookup_type(table, field_name);
+        if (field.kind == STRUCT) {
+            compute_nested_layout(get<atomic_struct>(field.at), strategy, memo, table);
+            const struct_layout& inner = memo[field_name];
+            blocks.push_back(field_slot{field_name, 0, strategy == OPAQUE ? inner.stride : inner.size, inner.align});
+            inner_layouts.push_back(&inner);
+        } else {
+            blocks.push_back(leaf_slot(field_name, table));
+            inner_layouts.push_back(nullptr);
+        }
+    }
+
+    struct_layout outer = compute_layout(blocks, strategy);
+    struct_layout layout = outer;
+    layout.slots.clear();
+    layout.used = 0;
+    layout.used_bits = 0;
+
+    vector<pair<long long, long long>> ranges;
+    long long first_id = 0;
+    for (size_t i = 0; i < outer.slots.size(); i++) {
+        vector<field_slot> inner_slots = inner_layouts[i] ? inner_layouts[i]->slots : vector<field_slot>{outer.slots[i]};
+        for (auto slot : inner_slots) {
+            if (inner_layouts[i]) {
+                slot.offset += outer.slots[i].offset;
+                slot.bit_offset += outer.slots[i].bit_offset;
+                slot.id += first_id;
+            } else {
+                slot.id = first_id;
+            }
+            long long width = slot.bits > 0 ? slot.bits : 8 * slot.size;
+            layout.has_bits = layout.has_bits || slot.bits > 0;
+            layout.used = checked_add(layout.used, slot.size);
+            layout.used_bits = checked_add(layout.used_bits, width);
+            ranges.push_back({slot.bit_offset, width});
+            layout.slots.push_back(slot);
+        }
+        first_id += inner_slots.size();
+    }
+
+    if (layout.has_bits) {
+        layout.used = touched_bytes(ranges);
+    }
+    layout.lost = layout.size - layout.used;
+    layout.lost_bits = layout.size_bits - layout.used_bits;
+    layout.align = capped_align(layout.align, at_struct.max_align);
+
+    return memo[at_struct.name] = layout;
+}
+
+/**
+ * Builds the unplaced leaf fields of a struct in flattened declaration order, with their ids set.
+ * 
+ * Each distinct field type is looked up once in the type table.
+ * 
+ * @param at_struct Struct type.
+ * @param with_names If false the slots are left without name, which makes them cheaper to copy when only totals are needed.
+ * @param table Type table where the fields are looked up.
+ * @return leaf fields of the struct.
+ */
+vector<field_slot> struct_leaves(const atomic_struct& at_struct, bool with_names = true, const map<string, atomic_type>& table = types_arr) {
+    vector<string> fields;
+    collect_struct_fields(at_struct, fields, table);
+
+    unordered_map<string, field_slot> resolved;
+    vector<field_slot> leaves;
+    leaves.reserve(fields.size());
+    for (size_t i = 0; i < fields.size(); i++) {
+        auto found = resolved.find(fields[i]);
+        if (found == resolved.end()) {
+            found = resolved.emplace(fields[i], leaf_slot(fields[i], table)).first;
+            if (!with_names) found->second.name.clear();
+        }
+        leaves.push_back(found->second);
+        leaves.back().id = i;
+    }
+    return leaves;
+}
+
+/**
+ * Builds the offset table of a struct for a given strategy without materializing its bytes.
+ * 
+ * @param at_struct Struct type.
+ * @param strategy Layout strategy.
+ * @param keep_slots If false only the totals are computed (except for nested strategies, which need the inner tables).
+ * @param table Type table where the fields are looked up.
+ * @return the offset table of the struct. Its memory is proportional to the number of atomic fields.
+ */
+struct_layout compute_struct_layout(const atomic_struct& at_struct, LayoutStrategy strategy, bool keep_slots = true,
+                                    const map<string, atomic_type>& table = types_arr) {
+    if (strategy == OPAQUE || strategy == TAIL_REUSE) {
+        map<string, struct_layout> memo;
+        return compute_nested_layout(at_struct, strategy, memo, table);
+    }
+
+    return compute_layout(struct_leaves(at_struct, keep_slots, table), strategy, keep_slots);
+}
+
+/**
+ * Layout of a struct under #pragma pack(N).
+ * 
+ * misaligned is the number of fields placed at an offset that isn't a multiple of their natural alignment (for
+ * bitfields, the ones that cross a naturally aligned storage unit), each of which costs a misaligned access.
+ */
+struct pack_result {
+    int pack;
+    struct_layout layout;
+    long long misaligned = 0;
+};
+
+/**
+ * Lays out a struct capping the alignment of every field at each of the given values, as #pragma pack(N) does.
+ * 
+ * The fields are collected once and reused for every cap.
+ * 
+ * @param at_struct Struct type.
+ * @param caps Values of N to evaluate.
+ * @return one result per cap, in the same order.
+ */
+vector<pack_result> compute_pack_table(const atomic_struct& at_struct, const vector<int>& caps = {1, 2, 4, 8, 16}) {
+    vector<string> fields;
+    collect_struct_fields(at_struct, fields);
+
+    vector<field_slot> leaves;
+    leaves.reserve(fields.size());
+    for (const auto& field_name : fields) {
+        leaves.push_back(leaf_slot(field_name));
+    }
+
+    vector<pack_result> table;
+    for (int cap : caps) {
+        if (cap <= 0) {
+            throw runtime_error("Error: Pack value must be a positive integer.");
+        }
+
+        vector<field_slot> capped = leaves;
+        for (auto& slot : capped) {
+            slot.align = min(slot.align, cap);
+        }
+
+        pack_result result{cap, compute_layout(capped, UNPACKED)};
+        for (size_t i = 0; i < leaves.size(); i++) {
+            const field_slot& placed = result.layout.slots[i];
+            long long natural = 8LL * leaves[i].align;
+            bool is_misaligned = placed.bits > 0
+                ? placed.bit_offset / natural != (placed.bit_offset + placed.bits - 1) / natural
+                : placed.bit_offset % natural != 0;
+            if (is_misaligned) {
+                result.misaligned++;
+            }
+        }
+        table.push_back(result);
+    }
+
+    return table;
+}
+
+/**
+ * Prints the size of a struct against its misaligned accesses for each value of #pragma pack(N).
+ * 
+ * @param at_struct Struct type.
+ * @param caps Values of N to evaluate.
+ * @param out Stream where the output is written.
+ */
+void print_pack_table(const atomic_struct& at_struct, const vector<int>& caps = {1, 2, 4, 8, 16}, ostream& out = cout) {
+    out << "Struct Type: " << at_struct.name << '\n';
+    out << "  pack(N) | Size | Stride | Bytes lost | Misaligned fields" << '\n';
+    for (const auto& result : compute_pack_table(at_struct, caps)) {
+        out << "  pack(" << result.pack << ") | " << result.layout.size << " | " << result.layout.stride
+             << " | " << result.layout.lost << " | " << result.misaligned << '\n';
+    }
+}
+
+/**
+ * Applies heuristic to set up the memory layout for a type maximizing space and time.
+ * 
+ * The heuristic goes as follows: for each type, lay in memory those with greater alignment first. This heuristic assume that the greater the alignment of the type, the most likely it is
+ * to waste bytes. So it lays them in memory first taking advantage of mem address 0 and the fact that greater alignments are less likely to have valid mem addresses to align with within the size
+ * of the structure. For example, consider types A and B with alignment 4 and 8 in a struct of size 16. There are more multiples of 4 in 16 than there are multiples of 8, so we lay first
+ * B in memory and move on to A. 
+ * 
+ * @param at_struct Struct type.
+ * @param word_size Sets the size of a word for printing memory layout.
+ * @param instances If positive, also prints the memory needed by that number of instances.
+ * @param from First byte of the diagram.
+ * @param to Byte past the end of the diagram.
+ * @param out Stream where the output is written.
+ */
+void print_struct_heuristics(const atomic_struct& at_struct, int word_size = 4, long long instances = 0, long long from = 0, long long to = LLONG_MAX, ostream& out = cout) {
+    struct_layout layout = compute_struct_layout(at_struct, HEURISTIC);
+
+    out << "Struct Type: " << at_struct.name << ", Bytes allocated: " << layout.size << " bytes, Bytes lost: " << layout.lost <<'\n';
+    print_layout_totals(layout, instances, out);
+
+    print_layout_diagram(layout, word_size, from, to, out);
+}
+
+/**
+ * Calculates the alignment for an union type
+ * 
+ * @param at_union Union type.
+ * @return the lcm of the alignments of the fields defined in the union tyoe.
+ */
+int calc_align_union (const atomic_union& at_union){
+    int align_accumulated = 1;
+    for (const auto& field_name : at_union.fields) {
+        align_accumulated = lcm(align_accumulated, type_size_align(field_name).second);
+    }
+    return align_accumulated;
+}
+
+/**
+ * Lays out a struct with the C rules from the sizes and alignments its fields have in the type table.
+ * 
+ * Each field is placed as a block, nested structs and unions included, as the opaque strategy does. The nested types
+ * aren't laid out again: the table already has their C size and alignment.
+ * 
+ * @param at_struct Struct type.
+ * @return the totals of the layout, without its slots.
+ */
+struct_layout struct_block_layout(const atomic_struct& at_struct) {
+    vector<field_slot> blocks;
+    blocks.reserve(at_struct.fields.size());
+    for (const auto& field_name : at_struct.fields) {
+        blocks.push_back(leaf_slot(field_name));
+    }
+    return compute_layout(blocks, UNPACKED, false);
+}
+
+/**
+ * Calculates the alignment for a struct type.
+ * 
+ * As in C, it's the greatest alignment of its fields.
+ * 
+ * @param at_struct Struct type.
+ * @return the alignment of the struct.
+ */
+int calc_align_struct (const atomic_struct& at_struct){
+    return struct_block_layout(at_struct).align;
+}
+
+/**
+ * Calculates the size of an union type.
+ * 
+ * It takes the field with greater size, rounded up to the alignment of the union as sizeof does in C.
+ * 
+ * @param at_union Union type.
+ * @return the size of the greatest field of the union, with its tail padding.
+ */
+long long calc_size_union (const atomic_union& at_union) {
+    long long size_accumulated = 0;
+    for (const auto& field_name : at_union.fields) {
+        size_accumulated = max(size_accumulated, type_size_align(field_name).first);
+    }
+    return align_up(size_accumulated, calc_align_union(at_union));
+}
+/**
+ * Calculates the size of a struct type.
+ * 
+ * It's the size of the struct in C (what sizeof gives): its fields in declaration order, each one aligned, plus the
+ * padding up to a multiple of its alignment. Throws overflow_error if it doesn't fit in 64 bits.
+ * 
+ * @param at_struct Struct type.
+ * @return the size of the struct, with its tail padding.
+ */
+long long calc_size_struct (const atomic_struct& at_struct) {
+    return struct_block_layout(at_struct).stride;
+}
+
+/**
+ * Prints the memory layout of a struct using a packing strategy.
+ * 
+ * @param at_struct Struct type.
+ * @param word_size Defines the word size to check for type alignment in memory layout
+ * @param instances If positive, also prints the memory needed by that number of instances.
+ * @param from First byte of the diagram.
+ * @param to Byte past the end of the diagram.
+ * @param out Stream where the output is written.
+ */
+void print_struct_w_packing(const atomic_struct& at_struct, int word_size = 4, long long instances = 0, long long from = 0, long long to = LLONG_MAX, ostream& out = cout){
+    struct_layout layout = compute_struct_layout(at_struct, PACKED);
+
+    out << "Struct Type: " << at_struct.name << ", Bytes allocated: " << layout.size << " bytes, Bytes lost: " << layout.lost <<'\n';
+    print_layout_totals(layout, instances, out);
+
+    print_layout_diagram(layout, word_size, from, to, out);
+}
+
+/**
+ * Prints the memory layout of a struct using a non-packing strategy.
+ * 
+ * @param at_struct Struct type.
+ * @param word_size Defines the word size to check for type alignment in memory layout
+ * @param instances If positive, also prints the memory needed by that number of instances.
+ * @param from First byte of the diagram.
+ * @param to Byte past the end of the diagram.
+ * @param out Stream where the output is written.
+ */
+void print_struct_wt_packing(const atomic_struct& at_struct, int word_size = 4, long long instances = 0, long long from = 0, long long to = LLONG_MAX, ostream& out = cout){
+    struct_layout layout = compute_struct_layout(at_struct, UNPACKED);
+
+    out << "Struct Type: " << at_struct.name << ", Bytes allocated: " << layout.size << " bytes, Bytes lost: " << layout.lost <<'\n';
+    print_layout_totals(layout, instances, out);
+
+    print_layout_diagram(layout, word_size, from, to, out);
+}
+
+/**
+ * Prints the memory layout of a struct laying its nested structs as opaque blocks.
+ * 
+ * Also prints the bytes saved compared with the inline expansion of print_struct_wt_packing (negative when the
+ * strategy needs more memory).
+ * 
+ * @param at_struct Struct type.
+ * @param strategy OPAQUE or TAIL_REUSE.
+ * @param word_size Defines the word size to check for type alignment in memory layout
+ * @param instances If positive, also prints the memory needed by that number of instances.
+ * @param from First byte of the diagram.
+ * @param to Byte past the end of the diagram.
+ * @param out Stream where the output is written.
+ */
+void print_struct_nested(const atomic_struct& at_struct, LayoutStrategy strategy, int word_size = 4, long long instances = 0, long long from = 0, long long to = LLONG_MAX, ostream& out = cout){
+    struct_layout layout = compute_struct_layout(at_struct, strategy);
+    struct_layout inline_layout = compute_struct_layout(at_struct, UNPACKED);
+
+    out << "Struct Type: " << at_struct.name << ", Bytes allocated: " << layout.size << " bytes, Bytes lost: " << layout.lost <<'\n';
+    print_layout_totals(layout, instances, out);
+    out << "Bytes saved vs inline expansion: " << inline_layout.size - layout.size
+         << " bytes, Stride saved: " << inline_layout.stride - layout.stride << " bytes" << '\n';
+
+    print_layout_diagram(layout, word_size, from, to, out);
+}
+
+/**
+ * Prints the field maps of a struct for the strategies without packing, with packing and with heuristics.
+ * 
+ * @param at_struct Struct type.
+ * @param out Stream where the output is written.
+ */
+void print_struct_field_maps(const atomic_struct& at_struct, ostream& out = cout) {
+    vector<pair<string, LayoutStrategy>> strategies = {
+        {"without packing", UNPACKED},
+        {"with packing", PACKED},
+        {"with heuristics respecting alignment", HEURISTIC},
+    };
+
+    for (const auto& [title, strategy] : strategies) {
+        out << "Field map " << title << ": " << '\n';
+        out << render_field_map(compute_struct_layout(at_struct, strategy));
+    }
+}
+
+/**
+ * Prints only the totals of a type: for structs, the ones of the strategies without packing, with packing and with
+ * heuristics.
+ * 
+ * The fields are flattened once for all the strategies, offset tables aren't kept and no diagram is built.
+ * 
+ * @param name Type name.
+ * @param instances If positive, also prints the memory needed by that number of instances.
+ * @param out Stream where the output is written.
+ */
+void print_type_summary(const string& name, long long instances = 0, ostream& out = cout) {
+    const atomic_type& type = lookup_type(types_arr, name);
+
+    if (type.kind != STRUCT) {
+        auto [size, align] = type_size_align(type);
+        long long stride = align_up(size, align);
+        out << "Type: " << name << ", Size: " << size << " bytes, Alignment: " << align << " bytes, Stride: " << stride << " bytes";
+        if (instances > 0) out << ", " << instances << " instances: " << checked_mul(stride, instances) << " bytes";
+        out << '\n';
+        return;
+    }
+
+    vector<pair<string, LayoutStrategy>> strategies = {
+        {"without packing", UNPACKED},
+        {"with packing", PACKED},
+        {"with heuristics respecting alignment", HEURISTIC},
+    };
+
+    vector<field_slot> leaves = struct_leaves(get<atomic_struct>(type.at), false);
+
+    for (const auto& [title, strategy] : strategies) {
+        struct_layout layout = compute_layout(leaves, strategy, false);
+        out << "Strategy " << title << ": Size: " << layout.size << " bytes, Bytes lost: " << layout.lost
+             << " bytes, Alignment: " << layout.align << " bytes, Stride: " << layout.stride << " bytes";
+        if (instances > 0) out << ", " << instances << " instances: " << checked_mul(layout.stride, instances) << " bytes";
+        out << '\n';
+    }
+}
+
+/**
+ * Prints the memory layout of a union type.
+ * 
+ * @param at_struct Struct type.
+ * @param word_size Defines the word size to check for type alignment in memory layout
+ * @param instances If positive, also prints the memory needed by that number of instances.
+ * @param from First byte of the diagram.
+ * @param to Byte past the end of the diagram.
+ * @param out Stream where the output is written.
+ */
+void print_union (const atomic_union& at, int word_size = 4, long long instances = 0, long long from = 0, long long to = LLONG_MAX, ostream& out = cout){
+    print_mem_runs_diagram(block_runs(at.size, word_size, from, to), word_size, out);
+
+    out << "Union Type: " << at.name << "\nSize: " << at.size << " bytes\nAlignment: " << at.align << " bytes"<<'\n';
+    print_layout_totals(compute_layout({field_slot{at.name, 0, at.size, at.align}}, UNPACKED), instances, out);
+
+}
+
+/**
+ * Layout of one alternative of a union inside the storage of the union.
+ * 
+ * wasted is the number of bytes of the union that hold no data while this alternative is active: its internal padding
+ * plus the bytes past its end up to the size of the union, driven by the largest alternative.
+ */
+struct union_member_layout {
+    string name;
+    struct_layout layout;
+    long long wasted = 0;
+};
+
+/**
+ * Layout of a union with the internal layout of every alternative.
+ * 
+ * overlap holds, for each run of bytes, how many alternatives use it.
+ */
+struct union_layout {
+    string name;
+    long long size = 0;
+    int align = 1;
+    vector<union_member_layout> members;
+    vector<mem_run> overlap;
+    long long max_wasted = 0;
+    long long total_wasted = 0;
+};
+
+/**
+ * Lays out every alternative of a union, nested structs with the given strategy.
+ * 
+ * @param at Union type.
+ * @param strategy Layout strategy for the alternatives that are structs.
+ * @return the layout of the union and its alternatives.
+ */
+union_layout compute_union_layout(const atomic_union& at, LayoutStrategy strategy = UNPACKED) {
+    union_layout result;
+    result.name = at.name;
+
+    for (const auto& field_name : at.fields) {
+        union_member_layout member;
+        member.name = field_name;
+        const atomic_type& field = lookup_type(types_arr, field_name);
+        if (field.kind == STRUCT) {
+            member.layout = compute_struct_layout(get<atomic_struct>(field.at), strategy);
+        } else {
+            member.layout = compute_layout({leaf_slot(field_name)}, UNPACKED);
+        }
+        result.size = max(result.size, member.layout.stride);
+        result.align = lcm(result.align, member.layout.align);
+        result.members.push_back(member);
+    }
+    // Como en C, la union ocupa un multiplo de su alineacion aunque ninguna alternativa lo haga
+    result.size = align_up(result.size, result.align);
+    result.align = capped_align(result.align, at.max_align);
+
+    // Barrido sobre los inicios y finales de las corridas ocupadas de cada alternativa
+    vector<pair<long long, int>> events;
+    for (auto& member : result.members) {
+        member.wasted = result.size - member.layout.used;
+        result.max_wasted = max(result.max_wasted, member.wasted);
+        result.total_wasted = checked_add(result.total_wasted, member.wasted);
+        for (const auto& run : layout_runs(member.layout)) {
+            if (run.value == 1) {
+                events.push_back({run.start, 1});
+                events.push_back({run.start + run.length, -1});
+            }
+        }
+    }
+    events.push_back({result.size, 0});
+    sort(events.begin(), events.end());
+
+    long long cursor = 0;
+    int active = 0;
+    for (const auto& [position, delta] : events) {
+        if (position > cursor) {
+            if (!result.overlap.empty() && result.overlap.back().value == active) {
+                result.overlap.back().length += position - cursor;
+            } else {
+                result.overlap.push_back(mem_run{cursor, position - cursor, active});
+            }
+            cursor = position;
+        }
+        active += delta;
+    }
+
+    return result;
+}
+
+/**
+ * Prints the layout of every alternative of a union and how they overlap.
+ * 
+ * @param at Union type.
+ * @param strategy Layout strategy for the alternatives that are structs.
+ * @param word_size Defines the word size to check for type alignment in memory layout
+ * @param from First byte of the diagrams.
+ * @param to Byte past the end of the diagrams.
+ * @param out Stream where the output is written.
+ */
+void print_union_members(const atomic_union& at, LayoutStrategy strategy = UNPACKED, int word_size = 4, long long from = 0, long long to = LLONG_MAX, ostream& out = cout) {
+    union_layout layout = compute_union_layout(at, strategy);
+
+    out << "Union Type: " << layout.name << ", Size: " << layout.size << " bytes, Alignment: " << layout.align << " bytes" << '\n';
+
+    for (const auto& member : layout.members) {
+        struct_layout padded = member.layout;
+        padded.size_bits = 8 * layout.size;
+        padded.size = layout.size;
+
+        out << "Member: " << member.name << ", Bytes used: " << member.layout.used
+             << " bytes, Bytes wasted: " << member.wasted << " bytes" << '\n';
+        print_layout_diagram(padded, word_size, from, to, out);
+    }
+
+    out << "Overlap (alternatives using each range):" << '\n';
+    for (const auto& run : layout.overlap) {
+        out << "  " << run.start << " - " << run.start + run.length - 1 << " | " << run.value << '\n';
+    }
+    out << "Bytes wasted on smaller alternatives: max " << layout.max_wasted << " bytes, total " << layout.total_wasted << " bytes" << '\n';
+}
+
+/**
+ * Candidate position for the tag of a variant record.
+ * 
+ * available is false when the placement isn't possible (there's no room for the tag in the padding it targets).
+ */
+struct variant_placement {
+    string placement;
+    bool available = false;
+    long long tag_offset = 0;
+    long long union_offset = 0;
+    long long size = 0;
+    long long stride = 0;
+};
+
+/**
+ * Searches where to place the tag of a variant record.
+ * 
+ * The alternatives are laid out as a union (see compute_union_layout) and the tag is tried before the union, after it,
+ * inside the trailing padding of the union (past the end of its largest alternative) and inside padding shared by every
+ * alternative (bytes that no alternative uses).
+ * 
+ * @param at Variant type.
+ * @param strategy Layout strategy for the alternatives that are structs.
+ * @return the four candidates, in that order.
+ */
+vector<variant_placement> compute_variant_placements(const atomic_variant& at, LayoutStrategy strategy = UNPACKED) {
+    union_layout alternatives = compute_union_layout(atomic_union{at.name, at.fields}, strategy);
+    field_slot tag = leaf_slot(at.tag);
+    field_slot block{at.name, 0, alternatives.size, alternatives.align};
+    int align = max(alternatives.align, tag.align);
+
+    long long data_end = 0;
+    for (const auto& member : alternatives.members) {
+        data_end = max(data_end, member.layout.size);
+    }
+
+    vector<variant_placement> result;
+
+    struct_layout before = compute_layout({tag, block}, UNPACKED);
+    result.push_back(variant_placement{"before", true, before.slots[0].offset, before.slots[1].offset, before.size, before.stride});
+
+    struct_layout after = compute_layout({block, tag}, UNPACKED);
+    result.push_back(variant_placement{"after", true, after.slots[1].offset, after.slots[0].offset, after.size, after.stride});
+
+    variant_placement tail{"union tail padding"};
+    tail.tag_offset = align_up(data_end, tag.align);
+    tail.available = tail.tag_offset + tag.size <= alternatives.size;
+    tail.size = alternatives.size;
+    tail.stride = align_up(alternatives.size, align);
+    result.push_back(tail);
+
+    variant_placement shared{"padding shared by all alternatives"};
+    for (const auto& run : alternatives.overlap) {
+        long long start = align_up(run.start, tag.align);
+        if (run.value == 0 && start + tag.size <= run.start + run.length && start + tag.size <= data_end) {
+            shared.available = true;
+            shared.tag_offset = start;
+            shared.size = alternatives.size;
+            shared.stride = align_up(alternatives.size, align);
+            break;
+        }
+    }
+    result.push_back(shared);
+
+    return result;
+}
+
+/**
+ * Prints the candidate positions for the tag of a variant record and the best of them.
+ * 
+ * @param at Variant type.
+ * @param strategy Layout strategy for the alternatives that are structs.
+ * @param out Stream where the output is written.
+ */
+void print_variant(const atomic_variant& at, LayoutStrategy strategy = UNPACKED, ostream& out = cout) {
+    out << "Variant Type: " << at.name << "\nTag: " << at.tag << "\nSize: " << at.size << " bytes\nAlignment: " << at.align << " bytes" << '\n';
+    out << "  Placement | Tag offset | Union offset | Size | Stride" << '\n';
+
+    const variant_placement* best = nullptr;
+    vector<variant_placement> placements = compute_variant_placements(at, strategy);
+    for (const auto& p : placements) {
+        if (!p.available) {
+            out << "  " << p.placement << " | not available" << '\n';
+            continue;
+        }
+        out << "  " << p.placement << " | " << p.tag_offset << " | " << p.union_offset << " | " << p.size << " | " << p.stride << '\n';
+        if (best == nullptr || p.stride < best->stride) {
+            best = &p;
+        }
+    }
+
+    out << "Best placement: " << best->placement << " (" << best->stride << " bytes)" << '\n';
+}
+
+/**
+ * Prints the memory layout of an atomic type.
+ * 
+ * @param at Atomic type.
+ * @param word_size Defines the word size to check for type alignment in memory layout
+ * @param instances If positive, also prints the memory needed by that number of instances.
+ * @param from First byte of the diagram.
+ * @param to Byte past the end of the diagram.
+ * @param out Stream where the output is written.
+ */
+void print_atomic(const aatomic& at, int word_size = 4, long long instances = 0, long long from = 0, long long to = LLONG_MAX, ostream& out = cout) {
+    print_mem_runs_diagram(block_runs(at.size, word_size, from, to), word_size, out);
+
+    out << "Atomic Type: " << at.name << "\nSize: " << at.size << " bytes\nAlignment: " << at.align << " bytes"<<'\n';
+    print_layout_totals(compute_layout({field_slot{at.name, 0, at.size, at.align}}, UNPACKED), instances, out);
+
+}
+
+/**
+ * Prints the memory layout of a bitfield inside its storage unit.
+ * 
+ * @param at Bitfield type.
+ * @param word_size Defines the word size to check for type alignment in memory layout
+ * @param out Stream where the output is written.
+ */
+void print_bitfield(const atomic_bitfield& at, int word_size = 4, ostream& out = cout) {
+    struct_layout layout = compute_layout({field_slot{at.name, 0, at.size, at.align, at.bits}}, UNPACKED);
+    layout.size_bits = 8 * at.size;
+    layout.lost_bits = layout.size_bits - at.bits;
+
+    print_bit_layout_diagram(layout_runs(layout, true), word_size, out);
+
+    out << "Bitfield Type: " << at.name << "\nWidth: " << at.bits << " bits\nUnit: " << at.unit << " (" << at.size << " bytes, alignment " << at.align << " bytes)" << '\n';
+}
+
+/**
+ * Stores pair (key, value) in global map to keep list of atomic types during execution.
+ * 
+ * Creates an atomic type.
+ * 
+ * @param arr Map of types.
+ * @param name Sets the name of the atomic type
+ * @param size Set the size of atomic type.
+ * @param align Sets the alignment of atomic type.
+ */
+void push_atomic(map<string, atomic_type>& arr, const string& name, long long size, int align){
+    if (size <= 0 || align <= 0) {
+        throw runtime_error("Error: Size and alignment must be positive integers.");
+    }
+
+    atomic_type at;
+    at.kind = ATOMIC;
+    at.at = aatomic{name, size, align};
+    arr[name] = at;
+    note_type_change(arr, name);
+}
+
+/**
+ * Stores pair (key, value) in global map to keep list of atomic types during execution.
+ * 
+ * Creates a struct type.
+ * 
+ * @param arr Map of types.
+ * @param name Sets the name of the struct type
+ * @param fields Arr of strings containing the identifiers of types existing in the type map. They are the fields of the struct type.
+ * @param max_align Cap of the alignment of the struct set by #pragma pack, 0 for none. Its size doesn't change.
+ */
+void push_struct(map<string, atomic_type>& arr, const string& name, vector<string> fields, int max_align = 0){
+
+    for (const auto& f : fields) {
+        if (f == name) {
+            throw runtime_error("Error: Recursive declaration of type '" + name + "'");
+        }
+    }
+
+    atomic_type at;
+    at.kind = STRUCT;
+    at.at = atomic_struct{name, fields};
+    atomic_struct* at_struct = &(get<atomic_struct>(at.at));
+    struct_layout layout = struct_block_layout(*at_struct);
+    at_struct->size = layout.stride;
+    at_struct->align = capped_align(layout.align, max_align);
+    at_struct->max_align = max_align;
+    arr[name] = at;
+    note_type_change(arr, name);
+}
+
+/**
+ * Stores pair (key, value) in global map to keep list of atomic types during execution.
+ * 
+ * Creates a union type.
+ * 
+ * @param arr Map of types.
+ * @param name Sets the name of the union type
+ * @param fields Arr of strings containing the identifiers of types existing in the type map. They are the fields of the union type.
+ * @param max_align Cap of the alignment of the union set by #pragma pack, 0 for none. Its size doesn't change.
+ */
+
+void push_union(map<string, atomic_type>& arr, const string& name, vector<string> fields, int max_align = 0){
+    for (const auto& f : fields) {
+        if (f == name) {
+            throw runtime_error("Error: Recursive declaration of type '" + name + "'");
+        }
+    }
+    atomic_type at;
+    at.kind = UNION;
+    at.at = atomic_union{name, fields};
+    atomic_union * at_union = &(get<atomic_union>(at.at));
+    long long size = calc_size_union(get<atomic_union>(at.at));
+    int align = calc_align_union(get<atomic_union>(at.at));
+    at_union->size = size;
+    at_union->align = capped_align(align, max_align);
+    at_union->max_align = max_align;
+    arr[name] = at;
+    note_type_change(arr, name);
+}
+
+/**
+ * Stores pair (key, value) in global map to keep list of atomic types during execution.
+ * 
+ * Creates a bitfield type.
+ * 
+ * @param arr Map of types.
+ * @param name Sets the name of the bitfield type
+ * @param bits Declared width in bits. Must fit in the storage unit.
+ * @param unit Identifier of the atomic type used as storage unit.
+ */
+void push_bitfield(map<string, atomic_type>& arr, const string& name, int bits, const string& unit){
+    const atomic_type* unit_type = find_type(arr, unit);
+    if (unit_type == nullptr || unit_type->kind != ATOMIC) {
+        throw runtime_error("Error: Atomic type '" + unit + "' not found in type table.");
+    }
+
+    const aatomic& storage = get<aatomic>(unit_type->at);
+
+    if (bits <= 0 || bits > 8 * storage.size) {
+        throw runtime_error("Error: Bitfield width must be between 1 and " + to_string(8 * storage.size) + " bits.");
+    }
+
+    atomic_type at;
+    at.kind = BITFIELD;
+    at.at = atomic_bitfield{name, bits, unit, storage.size, storage.align};
+    arr[name] = at;
+    note_type_change(arr, name);
+}
+
+/**
+ * Stores pair (key, value) in global map to keep list of atomic types during execution.
+ * 
+ * Creates a variant record type.
+ * 
+ * @param arr Map of types.
+ * @param name Sets the name of the variant type
+ * @param tag Identifier of the atomic type used as discriminant.
+ * @param fields Arr of strings containing the identifiers of types existing in the type map. They are the alternatives of the variant type.
+ */
+void push_variant(map<string, atomic_type>& arr, const string& name, const string& tag, vector<string> fields){
+    for (const auto& f : fields) {
+        if (f == name) {
+            throw runtime_error("Error: Recursive declaration of type '" + name + "'");
+        }
+    }
+
+    const atomic_type* tag_entry = find_type(arr, tag);
+    if (tag_entry == nullptr || tag_entry->kind != ATOMIC) {
+        throw runtime_error("Error: Atomic type '" + tag + "' not found in type table.");
+    }
+
+    // Se guarda la ubicacion "before" de compute_variant_placements: etiqueta, relleno hasta la union y la union
+    const aatomic& tag_type = get<aatomic>(tag_entry->at);
+    atomic_union alternatives{name, fields};
+    field_slot tag_slot{tag, 0, tag_type.size, tag_type.align};
+    field_slot block{name, 0, calc_size_union(alternatives), calc_align_union(alternatives)};
+    struct_layout layout = compute_layout({tag_slot, block}, UNPACKED, false);
+
+    atomic_type at;
+    at.kind = VARIANT;
+    at.at = atomic_variant{name, tag, fields, layout.stride, layout.align};
+    arr[name] = at;
+    note_type_change(arr, name);
+}
+
+/**
+ * Parses the input of the user in tokens.
+ * 
+ * @param line Input string given by user.
+ * @return Arr of tokens collected in a line separed by whitespaces.
+ */
+vector<string> split(const string& line) {
+    vector<string> tokens;
+    size_t i = 0;
+
+    while (i < line.size()) {
+        while (i < line.size() && isspace((unsigned char) line[i])) i++;
+        size_t start = i;
+        while (i < line.size() && !isspace((unsigned char) line[i])) i++;
+        if (i > start) tokens.emplace_back(line, start, i - start);
+    }
+
+    return tokens;
+}
+
+/**
+ * Checks if a token is an integer.
+ * 
+ * @param s Token.
+ * @return True if token is integer. False otherwise.
+ */
+bool is_integer(const string& s) {
+    size_t pos;
+    try {
+        stoll(s, &pos);
+        return pos == s.size(); // si consumió todo el string, es válido
+    } catch (...) {
+        return false;
+    }
+}
+
+/**
+ * Auxiliary function that lists the types defined so far during execution of the program.
+ * 
+ * @param types Map of types.
+ * @param out Stream where the output is written.
+ */
+void print_types(ostream& out = cout) {
+    for (const auto& [key, type] : types_arr) {
+        out << "Type name: " << key << '\n';
+
+        switch (type.kind) {
+            case ATOMIC: {
+                const aatomic& a = get<aatomic>(type.at);
+                out << "  Kind: ATOMIC\n";
+                out << "  Size: " << a.size << ", Align: " << a.align << "\n";
+                break;
+            }
+
+            case STRUCT: {
+                const atomic_struct& s = get<atomic_struct>(type.at);
+                out << "  Kind: STRUCT\n";
+                out << "  Fields: ";
+                for (const auto& f : s.fields) {
+                    out << f << " ";
+                }
+
+                vector<string> fields_init = {};
+                vector<string> fields = sort_struct_fields_by_alignment(s, fields_init);
+                out << "\n  Size: " << s.size << " bytes" << '\n';
+                out << "  Align: " << s.align << " bytes" << '\n';
+                out << "  Fields: " << '\n';
+                for (const auto& f : fields) {
+                    out << "  " << f << " ";
+                }
+                out << '\n';
+                break;
+            }
+
+            case UNION: {
+                const atomic_union& u = get<atomic_union>(type.at);
+                out << "  Kind: UNION\n";
+                out << "  Fields: ";
+                for (const auto& f : u.fields) {
+                    out << f << " ";
+                }
+                out << "\n  Size: " << u.size << " bytes" << '\n';
+                out << "  Align: " << u.align << " bytes" << '\n';
+                break;
+            }
+
+            case BITFIELD: {
+                const atomic_bitfield& b = get<atomic_bitfield>(type.at);
+                out << "  Kind: BITFIELD\n";
+                out << "  Width: " << b.bits << " bits, Unit: " << b.unit << "\n";
+                out << "  Size: " << b.size << ", Align: " << b.align << "\n";
+                break;
+            }
+
+            case VARIANT: {
+                const atomic_variant& v = get<atomic_variant>(type.at);
+                out << "  Kind: VARIANT\n";
+                out << "  Tag: " << v.tag << "\n";
+                out << "  Fields: ";
+                for (const auto& f : v.fields) {
+                    out << f << " ";
+                }
+                out << "\n  Size: " << v.size << " bytes" << '\n';
+                out << "  Align: " << v.align << " bytes" << '\n';
+                break;
+            }
+        }
+
+        out << "-----------------------------\n";
+    }
+}
+
+/**
+ * Target profile for evaluating the same schema under a different ABI.
+ * 
+ * A target overrides the word size used to print layouts, caps the alignment of every type at max_align (0 means no cap)
+ * and can redefine the size and alignment of individual atomic types. Atomic types that aren't overridden keep the
+ * representation declared with ATOMICO.
+ */
+struct target_profile {
+    string name;
+    int word_size = 4;
+    int max_align = 0;
+    map<string, pair<long long, int>> atomic_overrides;
+};
+
+map<string, target_profile> targets_arr = {};
+
+/**
+ * Summary of the layouts of a type under one target.
+ */
+struct target_layout {
+    string target;
+    int word_size = 4;
+    long long size = 0;
+    int align = 0;
+    struct_layout unpacked;
+    struct_layout packed;
+    struct_layout heuristic;
+};
+
+/**
+ * Shared state of a multi-target traversal.
+ * 
+ * Every type of the graph is visited once: its size and alignment are resolved for all the targets at the same time and
+ * the flattened fields of each struct are memoized, so nested structs are expanded only once no matter how many targets
+ * or how many types embed them.
+ */
+struct target_pass {
+    vector<target_profile> targets;
+    map<string, vector<pair<long long, int>>> metrics;
+    map<string, vector<string>> leaves;
+};
+
+/**
+ * Builds the profile equivalent to the types as they were declared.
+ * 
+ * @param word_size Word size of the profile.
+ * @return target without overrides nor alignment cap.
+ */
+target_profile default_target(int word_size = 4) {
+    target_profile t;
+    t.name = "default";
+    t.word_size = word_size;
+    return t;
+}
+
+/**
+ * Resolves the size and alignment of a type for every target of the pass.
+ * 
+ * They're computed as the type table does, with the sizes and alignments of each target: a struct places its fields
+ * as blocks like struct_block_layout, a union takes its greatest field rounded up to the lcm of the alignments and a
+ * variant places its tag before that union. The alignment of every type is capped by its own #pragma pack cap and by
+ * the max_align of each target, so the default target gives the values of the table.
+ * 
+ * @param pass Multi-target traversal.
+ * @param name Type name.
+ * @return vector with the pair (size, align) of the type for each target.
+ */
+const vector<pair<long long, int>>& resolve_target_metrics(target_pass& pass, const string& name) {
+    auto found = pass.metrics.find(name);
+    if (found != pass.metrics.end()) {
+        return found->second;
+    }
+
+    const atomic_type* type = find_type(types_arr, name);
+    if (type == nullptr) {
+        throw runtime_error("Error: Type '" + name + "' not found in type table.");
+    }
+
+    size_t n = pass.targets.size();
+    vector<pair<long long, int>> result(n, {0, 1});
+
+    if (type->kind == BITFIELD) {
+        result = resolve_target_metrics(pass, get<atomic_bitfield>(type->at).unit);
+    } else if (type->kind == ATOMIC) {
+        const aatomic& a = get<aatomic>(type->at);
+        for (size_t t = 0; t < n; t++) {
+            result[t] = {a.size, a.align};
+            auto over = pass.targets[t].atomic_overrides.find(name);
+            if (over != pass.targets[t].atomic_overrides.end()) {
+                result[t] = over->second;
+            }
+        }
+    } else if (type->kind == STRUCT) {
+        // Cada campo es un bloque, como en struct_block_layout
+        vector<vector<field_slot>> blocks(n);
+        for (const auto& field_name : get<atomic_struct>(type->at).fields) {
+            const vector<pair<long long, int>>& field = resolve_target_metrics(pass, field_name);
+            const atomic_type& field_type = lookup_type(types_arr, field_name);
+            int bits = field_type.kind == BITFIELD ? get<atomic_bitfield>(field_type.at).bits : 0;
+            for (size_t t = 0; t < n; t++) {
+                blocks[t].push_back(field_slot{"", 0, field[t].first, field[t].second, bits});
+            }
+        }
+        for (size_t t = 0; t < n; t++) {
+            struct_layout layout = compute_layout(blocks[t], UNPACKED, false);
+            result[t] = {layout.stride, layout.align};
+        }
+    } else {
+        const vector<string>& fields = type->kind == UNION ? get<atomic_union>(type->at).fields
+                                                           : get<atomic_variant>(type->at).fields;
+        for (const auto& field_name : fields) {
+            const vector<pair<long long, int>>& field = resolve_target_metrics(pass, field_name);
+            for (size_t t = 0; t < n; t++) {
+                result[t].first = max(result[t].first, field[t].first);
+                result[t].second = lcm(result[t].second, field[t].second);
+            }
+        }
+        for (size_t t = 0; t < n; t++) {
+            result[t].first = align_up(result[t].first, result[t].second);
+        }
+
+        if (type->kind == VARIANT) {
+            // La etiqueta va antes de la union de las alternativas, como la guarda push_variant
+            const vector<pair<long long, int>>& tag = resolve_target_metrics(pass, get<atomic_variant>(type->at).tag);
+            for (size_t t = 0; t < n; t++) {
+                field_slot tag_slot{"", 0, tag[t].first, tag[t].second};
+                field_slot block{"", 0, result[t].first, result[t].second};
+                struct_layout layout = compute_layout({tag_slot, block}, UNPACKED, false);
+                result[t] = {layout.stride, layout.align};
+            }
+        }
+    }
+
+    for (size_t t = 0; t < n; t++) {
+        result[t].second = capped_align(capped_align(result[t].second, type_max_align(*type)), pass.targets[t].max_align);
+    }
+
+    return pass.metrics[name] = result;
+}
+
+/**
+ * Flattens a type into the atomic and union fields laid out by the strategies, as collect_struct_fields does.
+ * 
+ * @param pass Multi-target traversal.
+ * @param name Type name.
+ * @return the flattened fields of the type. Atomic types and unions are their own single field.
+ */
+const vector<string>& resolve_target_leaves(target_pass& pass, const string& name) {
+    auto found = pass.leaves.find(name);
+    if (found != pass.leaves.end()) {
+        return found->second;
+    }
+
+    vector<string> result;
+    const atomic_type* type = find_type(types_arr, name);
+    if (type != nullptr && type->kind == STRUCT) {
+        for (const auto& field_name : get<atomic_struct>(type->at).fields) {
+            const vector<string>& inner = resolve_target_leaves(pass, field_name);
+            result.insert(result.end(), inner.begin(), inner.end());
+        }
+    } else {
+        result.push_back(name);
+    }
+
+    return pass.leaves[name] = result;
+}
+
+/**
+ * Computes the three layouts of a type for all the targets of the pass in a single traversal of its type graph.
+ * 
+ * @param pass Multi-target traversal.
+ * @param name Type name.
+ * @return one summary per target, in the order of pass.targets.
+ */
+vector<target_layout> layout_all_targets(target_pass& pass, const string& name) {
+    const vector<pair<long long, int>>& own = resolve_target_metrics(pass, name);
+    const vector<string>& leaves = resolve_target_leaves(pass, name);
+
+    size_t n = pass.targets.size();
+    vector<vector<field_slot>> slots(n);
+    for (const auto& leaf : leaves) {
+        const vector<pair<long long, int>>& field = resolve_target_metrics(pass, leaf);
+        const atomic_type& type = lookup_type(types_arr, leaf);
+        int bits = type.kind == BITFIELD ? get<atomic_bitfield>(type.at).bits : 0;
+        for (size_t t = 0; t < n; t++) {
+            slots[t].push_back(field_slot{leaf, 0, field[t].first, field[t].second, bits});
+        }
+    }
+
+    vector<target_layout> result;
+    for (size_t t = 0; t < n; t++) {
+        target_layout tl;
+        tl.target = pass.targets[t].name;
+        tl.word_size = pass.targets[t].word_size;
+        tl.size = own[t].first;
+        tl.align = own[t].second;
+        tl.unpacked = compute_layout(slots[t], UNPACKED);
+        tl.packed = compute_layout(slots[t], PACKED);
+        tl.heuristic = compute_layout(slots[t], HEURISTIC);
+        result.push_back(tl);
+    }
+    return result;
+}
+
+/**
+ * Builds a traversal over the targets defined so far, headed by the default profile.
+ * 
+ * @param word_size Word size of the default profile.
+ * @return pass ready to be used by layout_all_targets.
+ */
+target_pass make_target_pass(int word_size = 4) {
+    target_pass pass;
+    pass.targets.push_back(default_target(word_size));
+    for (const auto& [key, target] : targets_arr) {
+        pass.targets.push_back(target);
+    }
+    return pass;
+}
+
+/**
+ * Prints the layouts of a type under every target as a table.
+ * 
+ * @param name Type name.
+ * @param layouts Summaries returned by layout_all_targets.
+ * @param out Stream where the output is written.
+ */
+void print_target_layouts(const string& name, const vector<target_layout>& layouts, ostream& out = cout) {
+    out << "Type: " << name << " across " << layouts.size() << " targets" << '\n';
+    out << "  Target | Word | Size | Align | No packing (lost) | Stride | Packing | Heuristics (lost) | Words" << '\n';
+    for (const auto& tl : layouts) {
+        long long words = align_up(tl.unpacked.size, tl.word_size) / tl.word_size;
+        out << "  " << tl.target << " | " << tl.word_size << " | " << tl.size << " | " << tl.align
+             << " | " << tl.unpacked.size << " (" << tl.unpacked.lost << ")"
+             << " | " << tl.unpacked.stride
+             << " | " << tl.packed.size
+             << " | " << tl.heuristic.size << " (" << tl.heuristic.lost << ")"
+             << " | " << words << '\n';
+    }
+}
+
+/**
+ * Prints the layouts of every type of the table under every target.
+ * 
+ * All the types share the same traversal, so each type of the graph is resolved once.
+ * 
+ * @param word_size Word size of the default profile.
+ * @param out Stream where the output is written.
+ */
+void print_targets_report(int word_size = 4, ostream& out = cout) {
+    target_pass pass = make_target_pass(word_size);
+    for (const auto& [key, type] : types_arr) {
+        print_target_layouts(key, layout_all_targets(pass, key), out);
+        out << "-----------------------------\n";
+    }
+}
+
+/**
+ * Parses an atomic override of a target with format <tipo>:<representacion>:<alineacion>.
+ * 
+ * @param token Override given by the user.
+ * @return tuple (type name, size, align).
+ */
+tuple<string, long long, int> parse_atomic_override(const string& token) {
+    size_t first = token.find(':');
+    size_t second = first == string::npos ? string::npos : token.find(':', first + 1);
+
+    if (second == string::npos) {
+        throw runtime_error("Error: Wrong override '" + token + "'.\nUsage: <tipo>:<representacion>:<alineacion>.");
+    }
+
+    string name = token.substr(0, first);
+    string size = token.substr(first + 1, second - first - 1);
+    string align = token.substr(second + 1);
+
+    if (!is_integer(size) || !is_integer(align)) {
+        throw runtime_error("Error: Non-integer size or alignment in override '" + token + "'.");
+    }
+
+    if (stoll(align) > INT_MAX || stoll(align) < INT_MIN) {
+        throw runtime_error("Error: Alignment out of range in override '" + token + "'.");
+    }
+
+    return {name, stoll(size), (int) stoll(align)};
+}
+
+/**
+ * Stores pair (key, value) in the map of targets.
+ * 
+ * @param arr Map of targets.
+ * @param name Name of the target.
+ * @param word_size Word size of the target.
+ * @param max_align Alignment cap of the target, 0 for no cap.
+ * @param overrides Atomic types whose size and alignment change in this target.
+ */
+void push_target(map<string, target_profile>& arr, const string& name, int word_size, int max_align, const map<string, pair<long long, int>>& overrides) {
+    if (word_size <= 0 || max_align < 0) {
+        throw runtime_error("Error: Word size must be positive and max alignment non-negative.");
+    }
+
+    for (const auto& [type_name, repr] : overrides) {
+        const atomic_type* type = find_type(types_arr, type_name);
+        if (type == nullptr || type->kind != ATOMIC) {
+            throw runtime_error("Error: Atomic type '" + type_name + "' not found in type table.");
+        }
+        if (repr.first <= 0 || repr.second <= 0) {
+            throw runtime_error("Error: Size and alignment must be positive integers.");
+        }
+    }
+
+    arr[name] = target_profile{name, word_size, max_align, overrides};
+}
 #endif
\ No newline at end of file
@@ -0,0 +1,788 @@
+#ifndef IMPORTER_HPP
+#define IMPORTER_HPP
+
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Functions.hpp"
+#include "Transaction.hpp"
+#include "Journal.hpp"
+
+/**
+ * Read-only memory mapping of a whole file. The mapping is released when it goes out of scope.
+ */
+struct mapped_file {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    explicit mapped_file(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Error: Can't open file '" + path + "': " + strerror(errno) + ".");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) < 0) {
+            string reason = strerror(errno);
+            ::close(fd);
+            throw runtime_error("Error: Can't read file '" + path + "': " + reason + ".");
+        }
+        size = info.st_size;
+        if (size > 0) {
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                string reason = strerror(errno);
+                ::close(fd);
+                throw runtime_error("Error: Can't map file '" + path + "': " + reason + ".");
+            }
+            // El archivo se recorre una sola vez de principio a fin
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            data = (const char*) mapping;
+        }
+        ::close(fd);
+    }
+
+    ~mapped_file() {
+        if (data) ::munmap((void*) data, size);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+};
+
+/**
+ * Size and alignment of the C primitive types, for a 64-bit target (LP64).
+ *
+ * Signedness doesn't change the layout, so unsigned and signed types share the name of the plain type. Names of more than
+ * one word are joined with '_' so they can be used in commands, and every pointer is "ptr". A primitive that's already
+ * in the type table keeps the size and alignment it has there.
+ */
+const map<string, pair<long long, int>> C_PRIMITIVES = {
+    {"char", {1, 1}},
+    {"short", {2, 2}},
+    {"int", {4, 4}},
+    {"long", {8, 8}},
+    {"long_long", {8, 8}},
+    {"float", {4, 4}},
+    {"double", {8, 8}},
+    {"long_double", {16, 16}},
+    {"bool", {1, 1}},
+    {"ptr", {8, 8}},
+};
+
+/**
+ * Typedefs of the standard headers that can be used without being declared, with the primitive they stand for.
+ */
+const map<string, string> C_STANDARD_TYPEDEFS = {
+    {"int8_t", "char"}, {"uint8_t", "char"},
+    {"int16_t", "short"}, {"uint16_t", "short"},
+    {"int32_t", "int"}, {"uint32_t", "int"},
+    {"int64_t", "long"}, {"uint64_t", "long"},
+    {"intptr_t", "long"}, {"uintptr_t", "long"},
+    {"size_t", "long"}, {"ssize_t", "long"}, {"ptrdiff_t", "long"},
+    {"wchar_t", "int"},
+};
+
+/**
+ * Result of importing a header: the definitions it produced, in dependency order, and how long parsing took.
+ */
+struct c_import {
+    vector<type_definition> definitions;
+    size_t bytes = 0;
+    double elapsed_ms = 0;
+};
+
+/**
+ * Streaming parser of a subset of C declarations.
+ *
+ * It understands typedefs of primitive and aggregate types, structs and unions (named or anonymous, nested at any depth),
+ * enums (as int), pointers (as "ptr"), fixed arrays, bitfields and #pragma pack. Function declarations, variables and
+ * every other preprocessor directive are skipped. Tokens are views into the mapped file, so the text is never copied;
+ * only the names that end in a definition become strings.
+ *
+ * Each struct or union becomes a STRUCT or UNION definition. Anonymous ones are named after the typedef that names them
+ * or, when nested, after the enclosing type and the member ("outer.member"). An array of an atomic type becomes an atomic
+ * type "T[N]" with the size of the whole array and the alignment of T, while an array of an aggregate repeats the field N
+ * times. A bitfield of width B stored in T becomes the bitfield type "T:B". Under #pragma pack(N) each member whose
+ * alignment is greater than N is replaced by a copy of its type "T@N" whose alignment is capped to N. A copy of a struct
+ * or union keeps the fields and the size of the original; only its alignment as a member changes, as in C.
+ */
+struct c_parser {
+    /**
+     * Type named by a specifier. Anonymous aggregates have their body and get their name when it's known.
+     */
+    struct c_aggregate;
+    struct c_type {
+        string name = "";
+        shared_ptr<c_aggregate> body = nullptr;
+    };
+
+    /**
+     * Member of a struct or union.
+     */
+    struct c_field {
+        c_type type;
+        string member = "";
+        long long count = 1;
+        int bits = 0;
+    };
+
+    /**
+     * Body of a struct or union, with the #pragma pack in effect where it ends (0 if none).
+     */
+    struct c_aggregate {
+        AtomicKind kind = STRUCT;
+        vector<c_field> fields;
+        int pack = 0;
+        long long line = 0;
+    };
+
+    /**
+     * Declarator of a member or a typedef: its name, how many elements it has and its width if it's a bitfield.
+     */
+    struct c_declarator {
+        string name;
+        bool is_pointer = false;
+        bool is_function = false;
+        long long count = 1;
+        int bits = 0;
+    };
+
+    string path;
+    const char* p;
+    const char* end;
+    long long line = 1;
+    string_view peeked;
+    bool has_peeked = false;
+
+    vector<type_definition> definitions;
+    unordered_map<string, size_t> defined; // Posicion en definitions de la ultima definicion de cada nombre
+    vector<string> ensured; // Primitivos ya definidos o encontrados en la tabla
+    unordered_map<string, type_definition> from_table; // Tipos de la tabla ya convertidos a definicion
+    int pack = 0;
+    vector<int> pack_stack;
+
+    c_parser(const string& path, const char* data, size_t size) : path(path), p(data), end(data + size) {
+        // Una definicion cada pocas lineas de texto
+        defined.reserve(size / 128);
+        definitions.reserve(size / 128);
+    }
+
+    [[noreturn]] void fail(const string& message) const {
+        throw runtime_error("Error: " + path + ":" + to_string(line) + ": " + message);
+    }
+
+    static bool is_ident_start(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    static bool is_ident_char(char c) {
+        return is_ident_start(c) || (c >= '0' && c <= '9');
+    }
+
+    /**
+     * Skips whitespace, comments and preprocessor directives, applying the #pragma pack ones.
+     */
+    void skip_space() {
+        while (p < end) {
+            char c = *p;
+            if (c == '\n') {
+                line++;
+                p++;
+            } else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+                p++;
+            } else if (c == '/' && p + 1 < end && p[1] == '/') {
+                const char* eol = (const char*) memchr(p, '\n', end - p);
+                p = eol ? eol : end;
+            } else if (c == '/' && p + 1 < end && p[1] == '*') {
+                p += 2;
+                while (p + 1 < end && !(p[0] == '*' && p[1] == '/')) {
+                    if (*p == '\n') line++;
+                    p++;
+                }
+                if (p + 1 >= end) fail("Unterminated comment.");
+                p += 2;
+            } else if (c == '#') {
+                directive();
+            } else {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Reads a preprocessor directive up to the end of its line, joining the lines ended by a backslash.
+     */
+    void directive() {
+        const char* start = ++p;
+        while (p < end && *p != '\n') {
+            if (*p == '\\' && p + 1 < end && p[1] == '\n') {
+                line++;
+                p++;
+            }
+            p++;
+        }
+        string_view text(start, p - start);
+
+        // Solo interesa #pragma pack(...)
+        auto word = [&text]() {
+            size_t i = 0;
+            while (i < text.size() && isspace((unsigned char) text[i])) i++;
+            size_t j = i;
+            while (j < text.size() && is_ident_char(text[j])) j++;
+            string_view w = text.substr(i, j - i);
+            text.remove_prefix(j);
+            return w;
+        };
+        if (word() != "pragma" || word() != "pack") return;
+
+        size_t open = text.find('(');
+        size_t close = text.find(')');
+        if (open == string_view::npos || close == string_view::npos || close < open) fail("Malformed #pragma pack.");
+        string arguments;
+        for (char c : text.substr(open + 1, close - open - 1)) {
+            if (!isspace((unsigned char) c)) arguments.push_back(c);
+        }
+
+        vector<string> parts;
+        size_t from = 0;
+        while (from <= arguments.size() && !arguments.empty()) {
+            size_t comma = arguments.find(',', from);
+            if (comma == string::npos) comma = arguments.size();
+            parts.push_back(arguments.substr(from, comma - from));
+            from = comma + 1;
+        }
+
+        if (parts.empty()) {
+            pack = 0;
+        } else if (parts[0] == "push") {
+            pack_stack.push_back(pack);
+            if (parts.size() > 1) pack = pack_value(parts.back());
+        } else if (parts[0] == "pop") {
+            if (!pack_stack.empty()) {
+                pack = pack_stack.back();
+                pack_stack.pop_back();
+            }
+        } else {
+            pack = pack_value(parts[0]);
+        }
+    }
+
+    int pack_value(const string& text) const {
+        if (!is_integer(text)) fail("Unsupported #pragma pack argument '" + text + "'.");
+        long long value = stoll(text);
+        if (value <= 0 || value > 256 || (value & (value - 1)) != 0) fail("#pragma pack needs a power of two.");
+        return (int) value;
+    }
+
+    /**
+     * Reads the next token: an identifier, a number, a string literal or a single punctuation character.
+     *
+     * @return the token, empty at the end of the file.
+     */
+    string_view next() {
+        if (has_peeked) {
+            has_peeked = false;
+            return peeked;
+        }
+        skip_space();
+        if (p == end) return {};
+
+        const char* start = p;
+        char c = *p;
+        if (is_ident_char(c)) {
+            while (p < end && (is_ident_char(*p) || *p == '.')) p++;
+        } else if (c == '"' || c == '\'') {
+            p++;
+            while (p < end && *p != c && *p != '\n') p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+            if (p < end && *p == c) p++;
+        } else {
+            p++;
+        }
+        return string_view(start, p - start);
+    }
+
+    string_view peek() {
+        if (!has_peeked) {
+            peeked = next();
+            has_peeked = true;
+        }
+        return peeked;
+    }
+
+    void expect(string_view token) {
+        string_view found = next();
+        if (found != token) fail("Expected '" + string(token) + "' but found '" + string(found) + "'.");
+    }
+
+    /**
+     * Skips a group that starts at the next token, up to its matching closing character.
+     */
+    void skip_group() {
+        string_view open = next();
+        char close = open == "(" ? ')' : open == "[" ? ']' : '}';
+        int depth = 1;
+        while (depth > 0) {
+            string_view t = next();
+            if (t.empty()) fail("Unbalanced '" + string(open) + "'.");
+            if (t == open) depth++;
+            else if (t.size() == 1 && t[0] == close) depth--;
+        }
+    }
+
+    /**
+     * Skips a declaration that isn't a type: up to its ';' or, for a function, to the end of its body.
+     */
+    void skip_declaration() {
+        string_view previous;
+        while (true) {
+            string_view t = peek();
+            if (t.empty()) return;
+            if (t == ";") {
+                next();
+                return;
+            }
+            if (t == "(" || t == "[" || t == "{") {
+                bool is_body = t == "{" && previous == ")";
+                skip_group();
+                previous = t == "(" ? ")" : t == "[" ? "]" : "}";
+                if (is_body) return;
+                continue;
+            }
+            previous = next();
+        }
+    }
+
+    bool is_known(const string& name) const {
+        return defined.count(name) > 0 || find_type(types_arr, name) != nullptr;
+    }
+
+    /**
+     * Definition of a type defined in the header or in the type table.
+     *
+     * The reference is only valid until the next definition, which can move the definitions.
+     */
+    const type_definition& lookup(const string& name) {
+        auto found = defined.find(name);
+        if (found != defined.end()) return definitions[found->second];
+        auto converted = from_table.find(name);
+        if (converted != from_table.end()) return converted->second;
+        const atomic_type* in_table = find_type(types_arr, name);
+        if (in_table != nullptr) return from_table[name] = type_to_definition(name, *in_table);
+        fail("Type '" + name + "' not found.");
+    }
+
+    void define(type_definition def) {
+        defined[def.name] = definitions.size();
+        definitions.push_back(move(def));
+    }
+
+    /**
+     * Defines a primitive or standard typedef the first time it's used, unless it's in the type table.
+     */
+    void ensure_primitive(const string& name) {
+        // Los primitivos son pocos y se usan en casi todos los campos: se evita buscarlos en la tabla cada vez
+        if (find(ensured.begin(), ensured.end(), name) != ensured.end()) return;
+        ensured.push_back(name);
+        if (is_known(name)) return;
+        auto standard = C_STANDARD_TYPEDEFS.find(name);
+        const string& primitive = standard == C_STANDARD_TYPEDEFS.end() ? name : standard->second;
+        ensure_primitive_base(primitive);
+        if (name == primitive) return;
+        type_definition def = lookup(primitive);
+        def.name = name;
+        define(move(def));
+    }
+
+    void ensure_primitive_base(const string& name) {
+        if (is_known(name)) return;
+        auto found = C_PRIMITIVES.find(name);
+        if (found == C_PRIMITIVES.end()) fail("Type '" + name + "' not found.");
+        define(type_definition{ATOMIC, name, found->second.first, found->second.second});
+    }
+
+    /**
+     * Reads a type specifier with its qualifiers.
+     */
+    c_type parse_type() {
+        int longs = 0;
+        bool has_sign = false;
+        string primitive;
+
+        while (true) {
+            string_view t = peek();
+            if (t == "const" || t == "volatile" || t == "static" || t == "extern" || t == "register" || t == "inline"
+                || t == "__inline" || t == "__extension__" || t == "restrict" || t == "__restrict" || t == "auto") {
+                next();
+            } else if (t == "signed" || t == "unsigned") {
+                next();
+                has_sign = true;
+            } else if (t == "long") {
+                next();
+                longs++;
+            } else if (t == "char" || t == "short" || t == "int" || t == "float" || t == "double" || t == "void"
+                       || t == "_Bool" || t == "bool") {
+                next();
+                // "int" acompaña a short y long sin cambiar el tipo
+                if (t != "int" || primitive.empty()) primitive = t == "_Bool" ? "bool" : string(t);
+            } else if (t == "struct" || t == "union") {
+                return parse_aggregate();
+            } else if (t == "enum") {
+                return parse_enum();
+            } else if (primitive.empty() && longs == 0 && !has_sign && !t.empty() && is_ident_start(t[0])) {
+                string name(t);
+                if (is_known(name)) {
+                    next();
+                    return c_type{name};
+                }
+                if (C_STANDARD_TYPEDEFS.find(name) == C_STANDARD_TYPEDEFS.end()) fail("Type '" + name + "' not found.");
+                next();
+                ensure_primitive(name);
+                return c_type{name};
+            } else {
+                break;
+            }
+        }
+
+        if (primitive.empty() && longs == 0 && !has_sign) fail("Expected a type but found '" + string(peek()) + "'.");
+        if (primitive == "double" && longs > 0) primitive = "long_double";
+        else if (primitive.empty() || primitive == "int") primitive = longs >= 2 ? "long_long" : longs == 1 ? "long" : "int";
+        if (primitive != "void") ensure_primitive(primitive);
+        return c_type{primitive};
+    }
+
+    /**
+     * Reads a struct or union specifier, with its body if it has one.
+     */
+    c_type parse_aggregate() {
+        AtomicKind kind = next() == "struct" ? STRUCT : UNION;
+        string tag;
+        if (!peek().empty() && is_ident_start(peek()[0])) tag = string(next());
+        if (peek() != "{") {
+            if (tag.empty()) fail("Expected a struct or union name.");
+            return c_type{tag};
+        }
+
+        auto body = make_shared<c_aggregate>();
+        body->kind = kind;
+        body->line = line;
+        next();
+        while (peek() != "}") {
+            if (peek().empty()) fail("Unterminated struct or union.");
+            if (peek() == ";") {
+                next();
+                continue;
+            }
+            c_type type = parse_type();
+            if (peek() == ";") {
+                // Miembro anonimo (C11): sus campos quedan en el tipo que lo contiene
+                if (type.body) body->fields.push_back(c_field{type});
+                next();
+                continue;
+            }
+            while (true) {
+                c_declarator d = parse_declarator();
+                if (d.is_function) fail("Functions can't be members.");
+                c_field field{d.is_pointer ? c_type{"ptr"} : type, d.name, d.count, d.bits};
+                if (d.is_pointer) ensure_primitive("ptr");
+                body->fields.push_back(field);
+                if (peek() != ",") break;
+                next();
+            }
+            expect(";");
+        }
+        next();
+        body->pack = pack;
+
+        c_type type{tag, body};
+        if (!tag.empty()) {
+            finish_aggregate(*body, tag);
+            type.body = nullptr;
+        }
+        return type;
+    }
+
+    /**
+     * Reads an enum specifier. Enums are laid out as int.
+     */
+    c_type parse_enum() {
+        next();
+        string tag;
+        if (!peek().empty() && is_ident_start(peek()[0])) tag = string(next());
+        if (peek() == "{") skip_group();
+        ensure_primitive("int");
+        if (tag.empty()) return c_type{"int"};
+        if (!is_known(tag)) {
+            type_definition def = lookup("int");
+            def.name = tag;
+            define(move(def));
+        }
+        return c_type{tag};
+    }
+
+    /**
+     * Reads a declarator: pointers, name, array dimensions, parameters of a function and width of a bitfield.
+     */
+    c_declarator parse_declarator() {
+        c_declarator d;
+        auto skip_pointers = [this, &d]() {
+            while (peek() == "*" || peek() == "const" || peek() == "volatile" || peek() == "restrict" || peek() == "__restrict") {
+                if (next() == "*") d.is_pointer = true;
+            }
+        };
+
+        skip_pointers();
+        if (peek() == "(") {
+            // Puntero a funcion o a arreglo: (*nombre)(...) o (*nombre)[N]
+            next();
+            skip_pointers();
+            if (!peek().empty() && is_ident_start(peek()[0])) d.name = string(next());
+            expect(")");
+            if (peek() == "(") {
+                skip_group();
+                d.is_pointer = true;
+            }
+        } else if (!peek().empty() && is_ident_start(peek()[0])) {
+            d.name = string(next());
+        }
+
+        while (peek() == "[") {
+            next();
+            if (peek() == "]") {
+                d.count = 0; // Miembro flexible: no ocupa espacio
+            } else {
+                string_view size = next();
+                char* size_end;
+                string text(size);
+                long long value = strtoll(text.c_str(), &size_end, 0);
+                while (*size_end == 'u' || *size_end == 'U' || *size_end == 'l' || *size_end == 'L') size_end++;
+                if (*size_end != '\0' || value < 0) fail("Unsupported array size '" + text + "'.");
+                d.count = checked_mul(d.count, value);
+            }
+            expect("]");
+        }
+
+        if (peek() == "(") {
+            skip_group();
+            d.is_function = !d.is_pointer || d.name.empty();
+        }
+
+        if (peek() == ":") {
+            next();
+            string text(next());
+            if (!is_integer(text) || stoll(text) < 0 || stoll(text) > INT_MAX) fail("Unsupported bitfield width '" + text + "'.");
+            d.bits = (int) stoll(text);
+            if (d.bits == 0) d.count = 0; // Un bitfield de ancho 0 solo separa unidades
+        }
+
+        if (peek() == "=") {
+            while (peek() != "," && peek() != ";" && !peek().empty()) {
+                if (peek() == "{" || peek() == "(") skip_group();
+                else next();
+            }
+        }
+        return d;
+    }
+
+    /**
+     * Alignment a type has as a member, computed as the type table does and capped by the definition of the type.
+     */
+    int alignment(const string& name) {
+        type_definition def = lookup(name);
+        if (def.kind == BITFIELD) return alignment(def.unit);
+        if (def.kind != STRUCT && def.kind != UNION) return def.align;
+        int align = 1;
+        for (const auto& field_name : def.fields) {
+            align = def.kind == STRUCT ? max(align, alignment(field_name)) : lcm(align, alignment(field_name));
+        }
+        return def.align > 0 ? min(align, def.align) : align;
+    }
+
+    /**
+     * Type with its alignment capped by #pragma pack. Types that already fit are returned as they are.
+     */
+    string capped(const string& name, int cap) {
+        if (cap == 0) return name;
+        string capped_name = name + "@" + to_string(cap);
+        if (is_known(capped_name)) return capped_name;
+
+        type_definition def = lookup(name);
+        if (def.kind == ATOMIC || def.kind == STRUCT || def.kind == UNION) {
+            // Un struct o union conserva sus campos y su tamano; solo se limita su alineacion como miembro
+            if (alignment(name) <= cap) return name;
+            def.align = cap;
+        } else if (def.kind == BITFIELD) {
+            string unit = capped(def.unit, cap);
+            if (unit == def.unit) return name;
+            def.unit = unit;
+        } else {
+            return name;
+        }
+        def.name = capped_name;
+        define(move(def));
+        return capped_name;
+    }
+
+    /**
+     * Defines a struct or union whose name is known, after the anonymous aggregates nested in it.
+     *
+     * @return the name of the type.
+     */
+    string finish_aggregate(c_aggregate& body, const string& name) {
+        vector<string> fields;
+        fields.reserve(body.fields.size());
+        for (size_t i = 0; i < body.fields.size(); i++) {
+            c_field& field = body.fields[i];
+            string type = field.type.name;
+            if (field.type.body) {
+                string member = field.member.empty() ? "anon" + to_string(i) : field.member;
+                type = finish_aggregate(*field.type.body, name + "." + member);
+            }
+            type = capped(type, body.pack);
+
+            if (field.bits > 0) {
+                string bitfield = type + ":" + to_string(field.bits);
+                if (!is_known(bitfield)) {
+                    type_definition def{BITFIELD, bitfield};
+                    def.bits = field.bits;
+                    def.unit = type;
+                    define(move(def));
+                }
+                type = bitfield;
+            }
+
+            if (field.count == 1) {
+                fields.push_back(type);
+                continue;
+            }
+            // Si el arreglo ya existe su elemento es atomico y no hace falta buscarlo
+            string array = type + "[" + to_string(field.count) + "]";
+            if (field.count > 0 && is_known(array)) {
+                fields.push_back(array);
+                continue;
+            }
+            const type_definition& element = lookup(type);
+            if (element.kind == ATOMIC && field.count > 0) {
+                long long size = checked_mul(element.size, field.count);
+                define(type_definition{ATOMIC, array, size, element.align});
+                fields.push_back(array);
+            } else {
+                fields.insert(fields.end(), field.count, type);
+            }
+        }
+
+        if (fields.empty()) {
+            line = body.line;
+            fail(string(body.kind == STRUCT ? "Struct" : "Union") + " '" + name + "' has no fields.");
+        }
+        type_definition def{body.kind, name};
+        def.fields = move(fields);
+        define(move(def));
+        return name;
+    }
+
+    /**
+     * Makes a typedef name another name of a type.
+     */
+    void define_alias(const string& alias, const string& type, const c_declarator& d) {
+        string target = type;
+        if (d.is_pointer) {
+            ensure_primitive("ptr");
+            target = "ptr";
+        }
+        if (d.count != 1) {
+            const type_definition& element = lookup(target);
+            if (element.kind != ATOMIC || d.count == 0) fail("Only arrays of atomic types can be typedefs.");
+            string array = target + "[" + to_string(d.count) + "]";
+            if (!is_known(array)) {
+                long long size = checked_mul(element.size, d.count);
+                define(type_definition{ATOMIC, array, size, element.align});
+            }
+            target = array;
+        }
+        if (target == alias) return;
+        type_definition def = lookup(target);
+        def.name = alias;
+        define(move(def));
+    }
+
+    void parse_typedef() {
+        c_type type = parse_type();
+        while (true) {
+            c_declarator d = parse_declarator();
+            if (d.name.empty()) fail("Expected a typedef name.");
+            if (d.is_function) {
+                // Un typedef de funcion no tiene representacion; solo se usan punteros a el
+                ensure_primitive("ptr");
+                define_alias(d.name, "ptr", c_declarator{});
+            } else {
+                // Un struct anonimo toma el nombre del primer typedef, o el de sus elementos si es un puntero o arreglo
+                if (type.body) {
+                    bool is_element = d.is_pointer || d.count != 1;
+                    type = c_type{finish_aggregate(*type.body, is_element ? d.name + ".element" : d.name)};
+                }
+                define_alias(d.name, type.name, d);
+            }
+            if (peek() != ",") break;
+            next();
+        }
+        expect(";");
+    }
+
+    /**
+     * Parses the whole file.
+     */
+    void parse() {
+        while (true) {
+            string_view t = peek();
+            if (t.empty()) return;
+            if (t == "typedef") {
+                next();
+                parse_typedef();
+            } else if (t == "extern") {
+                // extern "C" { ... }: las declaraciones de adentro se leen como las de afuera
+                next();
+                if (!peek().empty() && peek()[0] == '"') {
+                    next();
+                    if (peek() == "{") next();
+                } else {
+                    skip_declaration();
+                }
+            } else if (t == "}" || t == ";") {
+                next();
+            } else if (t == "struct" || t == "union" || t == "enum") {
+                parse_type();
+                skip_declaration();
+            } else {
+                skip_declaration();
+            }
+        }
+    }
+};
+
+/**
+ * Parses a C header into type definitions.
+ *
+ * The file is memory mapped and read once from start to end. Types of the type table can be used by the header.
+ *
+ * @param path Path of the header.
+ * @return the definitions in dependency order, with the bytes parsed and the time it took.
+ */
+c_import import_c_header(const string& path) {
+    auto started = chrono::steady_clock::now();
+    mapped_file file(path);
+    c_parser parser(path, file.data, file.size);
+    parser.parse();
+
+    c_import result;
+    result.definitions = move(parser.definitions);
+    result.bytes = file.size;
+    result.elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    return result;
+}
+#endif
@@ -0,0 +1,662 @@
+#ifndef INTERPRETER_HPP
+#define INTERPRETER_HPP
+
+#include <climits>
+#include "Functions.hpp"
+#include "Racing.hpp"
+#include "Export.hpp"
+#include "Diff.hpp"
+#include "Pipeline.hpp"
+#include "Transaction.hpp"
+#include "Journal.hpp"
+#include "Importer.hpp"
+#include "Query.hpp"
+#include "Stats.hpp"
+
+/**
+ * Code of each command of the interpreter.
+ */
+const map<string, int> AVAILABLE_COMMANDS = {
+    {"ATOMICO", 1},
+    {"STRUCT", 2},
+    {"UNION", 3},
+    {"DESCRIBIR", 4},
+    {"SALIR", 5},
+    {"IMPRIMIR", 6},
+    {"OBJETIVO", 7},
+    {"REPORTE", 8},
+    {"BITFIELD", 9},
+    {"VARIANTE", 10},
+    {"CARRERA", 11},
+    {"EXPORTAR", 12},
+    {"INSTANTANEA", 13},
+    {"DIFERENCIA", 14},
+    {"BEGIN", 15},
+    {"COMMIT", 16},
+    {"ROLLBACK", 17},
+    {"IMPORTAR", 18},
+    {"CONSULTA", 19},
+    {"STATS", 20}
+};
+
+/**
+ * State of an interpreter session that isn't shared with other sessions: the word size, the thread pool of CARRERA, the
+ * snapshots of the type table and the open transaction. wal is the log where the definitions are written, shared by every
+ * session of the process, or nullptr if they aren't logged.
+ */
+struct session {
+    int word_size = 4; // Tamaño de palabra en bytes (32 bits)
+    unique_ptr<thread_pool> pool;
+    map<string, map<string, atomic_type>> snapshots; // Copias de la tabla de tipos por nombre
+    transaction tx; // Definiciones pendientes entre BEGIN y COMMIT
+    journal* wal = nullptr;
+};
+
+/**
+ * Adds a definition to the type table and writes it to the log of the session.
+ *
+ * If the log can't be written the type table is left as it was. When the log is due it's compacted afterwards; if that
+ * fails the definition is kept and the error is reported.
+ *
+ * @param s Session.
+ * @param def Type definition.
+ */
+void define_type(session& s, const type_definition& def) {
+    const atomic_type* found = find_type(types_arr, def.name);
+    optional<atomic_type> previous = found == nullptr ? nullopt : optional<atomic_type>(*found);
+    apply_definition(types_arr, def);
+    if (!s.wal) return;
+
+    bool compact = false;
+    try {
+        compact = s.wal->append({def});
+    } catch (...) {
+        if (previous) {
+            types_arr[def.name] = *previous;
+        } else {
+            types_arr.erase(def.name);
+        }
+        throw;
+    }
+    if (compact) s.wal->compact(types_arr);
+}
+
+/**
+ * Executes one command of the interpreter. Errors are written to the output like any other result.
+ *
+ * @param command Parsed command.
+ * @param s Session the command runs in.
+ * @param out Stream where the output is written.
+ * @return false if the command ends the session (SALIR).
+ */
+bool execute_command(const parsed_command& command, session& s, ostream& out) {
+    const vector<string>& tokens = command.tokens;
+    int word_size = s.word_size;
+    unique_ptr<thread_pool>& pool = s.pool;
+    map<string, map<string, atomic_type>>& snapshots = s.snapshots;
+    transaction& tx = s.tx;
+
+    if (tokens.size() == 0) {
+        out << "Error: Empty command. Try again." << '\n';
+        return true;
+    }
+
+    // Las estadisticas se agrupan por verbo; los comandos desconocidos van juntos para no crecer sin limite
+    static const string unknown_verb = "(unknown)";
+    command_timer timer(command.code != 0 ? tokens[0] : unknown_verb);
+
+    switch (command.code){
+        case 1:{
+            try {
+                if (tokens.size() != 4) {
+                    throw runtime_error("Error: Wrong number of arguments for ATOMIC type.\nUsage: ATOMIC <nombre> <representacion> <alineacion>.");
+                }
+
+                string field1 = tokens[1];
+
+                if (!is_integer(tokens[2]) || !is_integer(tokens[3])){
+                    throw runtime_error("Error: Non-integer type for size or alignment. Try again.");
+                }
+                
+                long long field2 = stoll(tokens[2]);
+
+                if (field2 <= 0) {
+                    throw runtime_error("Error: Size must be a positive integer. Try again.");
+                }
+
+                long long field3 = stoll(tokens[3]);
+
+                if (field3 <= 0 || field3 > INT_MAX) {
+                    throw runtime_error("Error: Alignment must be a positive integer. Try again.");
+                }
+                
+                if (tx.active) {
+                    type_definition def{ATOMIC, field1, field2, (int) field3};
+                    stage_definition(tx, def);
+                    out << "ATOMIC type " << field1 << " staged." << '\n';
+                    break;
+                }
+
+                define_type(s, type_definition{ATOMIC, field1, field2, (int) field3});
+                
+                out << "ATOMIC type " << field1 << " created successfully!" << '\n';
+                
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 2:{
+            try {
+                if (tokens.size() < 3) {
+                    throw runtime_error("Error: Wrong number of arguments for STRUCT type.\nUsage: STRUCT <nombre> [<tipo>].");
+                }
+                string struct_name = tokens[1];
+                vector<string> field_types;
+                
+
+                // Iteramos desde el tercer token
+                for (size_t i = 2; i < tokens.size(); i++) {
+
+                    // Verificamos que exista en el mapa global types_arr (en una transaccion, al hacer COMMIT)
+                    if (!tx.active && find_type(types_arr, tokens[i]) == nullptr) {
+                        throw runtime_error("Error: Type '" + tokens[i] + "' not found in type table.");
+                    }
+
+                    // Si existe, lo agregamos a la lista
+                    field_types.push_back(tokens[i]);
+                }
+
+                if (tx.active) {
+                    type_definition def{STRUCT, struct_name};
+                    def.fields = field_types;
+                    stage_definition(tx, def);
+                    out << "STRUCT type " << struct_name << " staged." << '\n';
+                    break;
+                }
+
+                // Si todos existen, creamos el struct
+                type_definition def{STRUCT, struct_name};
+                def.fields = field_types;
+                define_type(s, def);
+
+                out << "STRUCT type " << struct_name << " created successfully!" << '\n';
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 3: {
+            try {
+                if (tokens.size() < 3) {
+                    throw runtime_error("Error: Wrong number of arguments for UNION type.\nUsage: UNION <nombre> [<tipo>].");
+                }
+                string struct_name = tokens[1];
+                vector<string> field_types;
+
+                // Iteramos desde el tercer token
+                for (size_t i = 2; i < tokens.size(); i++) {
+
+                    // Verificamos que exista en el mapa global types_arr (en una transaccion, al hacer COMMIT)
+                    if (!tx.active && find_type(types_arr, tokens[i]) == nullptr) {
+                        throw runtime_error("Error: Type '" + tokens[i] + "' not found in type table.");
+                    }
+
+                    // Si existe, lo agregamos a la lista
+                    field_types.push_back(tokens[i]);
+                }
+
+                if (tx.active) {
+                    type_definition def{UNION, struct_name};
+                    def.fields = field_types;
+                    stage_definition(tx, def);
+                    out << "UNION type " << struct_name << " staged." << '\n';
+                    break;
+                }
+
+                // Si todos existen, creamos el struct
+                type_definition def{UNION, struct_name};
+                def.fields = field_types;
+                define_type(s, def);
+
+                out << "UNION type " << struct_name << " created successfully!" << '\n';
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 4: {
+            try
+            {
+                const string usage = "\nUsage: DESCRIBIR <nombre> [<desde> [<hasta>]] [N=<instancias>] [CAMPOS] [RESUMEN].";
+                if (tokens.size() < 2 || tokens.size() > 7) {
+                    throw runtime_error("Error: Wrong number of arguments for DESCRIBIR command." + usage);
+                }
+
+                string type_name = tokens[1];
+                long long instances = 0;
+                bool field_maps = false;
+                bool summary = false;
+                vector<long long> window; // Ventana de bytes del diagrama: [desde, hasta)
+
+                // Opciones en cualquier orden
+                for (size_t i = 2; i < tokens.size(); i++) {
+                    if (tokens[i] == "CAMPOS") {
+                        field_maps = true;
+                    } else if (tokens[i] == "RESUMEN") {
+                        summary = true;
+                    } else if (tokens[i].rfind("N=", 0) == 0) {
+                        if (!is_integer(tokens[i].substr(2)) || stoll(tokens[i].substr(2)) <= 0) {
+                            throw runtime_error("Error: Number of instances must be a positive integer." + usage);
+                        }
+                        instances = stoll(tokens[i].substr(2));
+                    } else if (is_integer(tokens[i]) && window.size() < 2) {
+                        window.push_back(stoll(tokens[i]));
+                    } else {
+                        throw runtime_error("Error: Unknown option '" + tokens[i] + "' for DESCRIBIR command." + usage);
+                    }
+                }
+
+                long long from = window.size() > 0 ? window[0] : 0;
+                long long to = window.size() > 1 ? window[1] : LLONG_MAX;
+                if (from < 0 || to <= from) {
+                    throw runtime_error("Error: Byte window must satisfy 0 <= desde < hasta." + usage);
+                }
+
+                if (find_type(types_arr, type_name) == nullptr) {
+                    throw runtime_error("Error: Type '" + type_name + "' not found in type table.");
+                }
+
+                // Solo totales: sin tablas de offsets ni diagramas
+                if (summary) {
+                    print_type_summary(type_name, instances, out);
+                    break;
+                }
+
+                const atomic_type& type = lookup_type(types_arr, type_name);
+
+                switch (type.kind) {
+                    case ATOMIC: {
+                        const aatomic& a = get<aatomic>(type.at);
+                        print_atomic(a, word_size, instances, from, to, out);
+                        break;
+                    }
+                    case STRUCT: {
+                        const atomic_struct& s = get<atomic_struct>(type.at);
+                        out << "Strategy without packing: " << '\n';
+                        print_struct_wt_packing(s, word_size, instances, from, to, out);
+                        out << "Strategy with packing: " << '\n';
+                        print_struct_w_packing(s, word_size, instances, from, to, out);
+                        out << "Strategy with heuristics respecting alignment: " << '\n';
+                        print_struct_heuristics(s, word_size, instances, from, to, out);
+                        out << "Strategy with opaque nested structs: " << '\n';
+                        print_struct_nested(s, OPAQUE, word_size, instances, from, to, out);
+                        out << "Strategy with tail padding reuse: " << '\n';
+                        print_struct_nested(s, TAIL_REUSE, word_size, instances, from, to, out);
+                        out << "Strategy with bounded alignment (#pragma pack): " << '\n';
+                        print_pack_table(s, {1, 2, 4, 8, 16}, out);
+                        if (field_maps) print_struct_field_maps(s, out);
+                        break;
+                    }
+
+                    case UNION: {
+                        const atomic_union& u = get<atomic_union>(type.at);
+                        print_union(u, word_size, instances, from, to, out);
+                        print_union_members(u, UNPACKED, word_size, from, to, out);
+                        break;
+                    }
+
+                    case BITFIELD: {
+                        const atomic_bitfield& b = get<atomic_bitfield>(type.at);
+                        print_bitfield(b, word_size, out);
+                        break;
+                    }
+
+                    case VARIANT: {
+                        const atomic_variant& v = get<atomic_variant>(type.at);
+                        print_variant(v, UNPACKED, out);
+                        break;
+                    }
+                }
+
+                if (!targets_arr.empty()) {
+                    target_pass pass = make_target_pass(word_size);
+                    print_target_layouts(type_name, layout_all_targets(pass, type_name), out);
+                }
+            }
+            catch(const exception& e){
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 5:
+            out << "Saliendo del programa." << '\n';
+            return false;
+        case 6:
+            print_types(out);
+            break;
+        case 7: {
+            try {
+                if (tokens.size() < 4) {
+                    throw runtime_error("Error: Wrong number of arguments for OBJETIVO command.\nUsage: OBJETIVO <nombre> <palabra> <alineacion_max> [<tipo>:<representacion>:<alineacion>].");
+                }
+
+                if (!is_integer(tokens[2]) || !is_integer(tokens[3])){
+                    throw runtime_error("Error: Non-integer type for word size or max alignment. Try again.");
+                }
+
+                long long word = stoll(tokens[2]);
+                long long max_align = stoll(tokens[3]);
+                if (word > INT_MAX || max_align > INT_MAX || word < INT_MIN || max_align < INT_MIN) {
+                    throw runtime_error("Error: Word size or max alignment out of range. Try again.");
+                }
+
+                map<string, pair<long long, int>> overrides;
+
+                // Iteramos desde el quinto token
+                for (size_t i = 4; i < tokens.size(); i++) {
+                    auto [type_name, size, align] = parse_atomic_override(tokens[i]);
+                    overrides[type_name] = {size, align};
+                }
+
+                push_target(targets_arr, tokens[1], (int) word, (int) max_align, overrides);
+
+                out << "Target " << tokens[1] << " created successfully!" << '\n';
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 8:
+            print_targets_report(word_size, out);
+            break;
+        case 9: {
+            try {
+                if (tokens.size() != 4) {
+                    throw runtime_error("Error: Wrong number of arguments for BITFIELD type.\nUsage: BITFIELD <nombre> <bits> <unidad>.");
+                }
+
+                if (!is_integer(tokens[2])){
+                    throw runtime_error("Error: Non-integer type for bitfield width. Try again.");
+                }
+
+                long long bits = stoll(tokens[2]);
+
+                if (bits <= 0 || bits > INT_MAX) {
+                    throw runtime_error("Error: Width must be a positive integer. Try again.");
+                }
+
+                if (tx.active) {
+                    type_definition def{BITFIELD, tokens[1]};
+                    def.bits = (int) bits;
+                    def.unit = tokens[3];
+                    stage_definition(tx, def);
+                    out << "BITFIELD type " << tokens[1] << " staged." << '\n';
+                    break;
+                }
+
+                type_definition def{BITFIELD, tokens[1]};
+                def.bits = (int) bits;
+                def.unit = tokens[3];
+                define_type(s, def);
+
+                out << "BITFIELD type " << tokens[1] << " created successfully!" << '\n';
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 10: {
+            try {
+                if (tokens.size() < 4) {
+                    throw runtime_error("Error: Wrong number of arguments for VARIANTE type.\nUsage: VARIANTE <nombre> <etiqueta> [<tipo>].");
+                }
+                string variant_name = tokens[1];
+                vector<string> field_types;
+
+                // Iteramos desde el cuarto token
+                for (size_t i = 3; i < tokens.size(); i++) {
+
+                    // Verificamos que exista en el mapa global types_arr (en una transaccion, al hacer COMMIT)
+                    if (!tx.active && find_type(types_arr, tokens[i]) == nullptr) {
+                        throw runtime_error("Error: Type '" + tokens[i] + "' not found in type table.");
+                    }
+
+                    field_types.push_back(tokens[i]);
+                }
+
+                if (tx.active) {
+                    type_definition def{VARIANT, variant_name};
+                    def.tag = tokens[2];
+                    def.fields = field_types;
+                    stage_definition(tx, def);
+                    out << "VARIANTE type " << variant_name << " staged." << '\n';
+                    break;
+                }
+
+                type_definition def{VARIANT, variant_name};
+                def.tag = tokens[2];
+                def.fields = field_types;
+                define_type(s, def);
+
+                out << "VARIANTE type " << variant_name << " created successfully!" << '\n';
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 11: {
+            try {
+                if (tokens.size() < 2 || tokens.size() > 3) {
+                    throw runtime_error("Error: Wrong number of arguments for CARRERA command.\nUsage: CARRERA <nombre> [<milisegundos>].");
+                }
+
+                string type_name = tokens[1];
+
+                const atomic_type* type = find_type(types_arr, type_name);
+                if (type == nullptr || type->kind != STRUCT) {
+                    throw runtime_error("Error: Struct type '" + type_name + "' not found in type table.");
+                }
+
+                long long budget = 1000;
+                if (tokens.size() == 3) {
+                    if (!is_integer(tokens[2]) || stoll(tokens[2]) < 0) {
+                        throw runtime_error("Error: Time limit must be a non-negative integer. Try again.");
+                    }
+                    budget = stoll(tokens[2]);
+                }
+
+                if (!pool) {
+                    pool = make_unique<thread_pool>(max(thread::hardware_concurrency(), 2u));
+                }
+
+                print_strategy_race(get<atomic_struct>(type->at), *pool, chrono::milliseconds(budget), out);
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 12: {
+            try {
+                const string usage = "\nUsage: EXPORTAR <JSON|BINARIO> [<archivo>].";
+                if (tokens.size() < 2 || tokens.size() > 3) {
+                    throw runtime_error("Error: Wrong number of arguments for EXPORTAR command." + usage);
+                }
+
+                string output;
+                if (tokens[1] == "JSON") {
+                    output = export_types_json();
+                } else if (tokens[1] == "BINARIO") {
+                    if (tokens.size() != 3) {
+                        throw runtime_error("Error: Binary output must be written to a file." + usage);
+                    }
+                    output = export_types_binary();
+                } else {
+                    throw runtime_error("Error: Unknown format '" + tokens[1] + "'." + usage);
+                }
+
+                // Toda la salida se escribe de una sola vez
+                if (tokens.size() == 3) {
+                    write_buffer(tokens[2], output);
+                    out << types_arr.size() << " types exported to " << tokens[2] << " (" << output.size() << " bytes)." << '\n';
+                } else {
+                    out.write(output.data(), output.size());
+                    out.flush();
+                }
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 13: {
+            try {
+                if (tokens.size() != 2) {
+                    throw runtime_error("Error: Wrong number of arguments for INSTANTANEA command.\nUsage: INSTANTANEA <nombre>.");
+                }
+
+                snapshots[tokens[1]] = types_arr;
+                out << "Snapshot " << tokens[1] << " saved with " << types_arr.size() << " types." << '\n';
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 14: {
+            try {
+                const string usage = "\nUsage: DIFERENCIA ESTRATEGIAS <tipo> <estrategia> <estrategia> | DIFERENCIA INSTANTANEA <nombre> [<estrategia>].";
+
+                if (tokens.size() == 5 && tokens[1] == "ESTRATEGIAS") {
+                    string type_name = tokens[2];
+                    const atomic_type* type = find_type(types_arr, type_name);
+                    if (type == nullptr || type->kind != STRUCT) {
+                        throw runtime_error("Error: Struct type '" + type_name + "' not found in type table.");
+                    }
+
+                    const atomic_struct& s = get<atomic_struct>(type->at);
+                    struct_layout before = compute_struct_layout(s, parse_strategy(tokens[3]));
+                    struct_layout after = compute_struct_layout(s, parse_strategy(tokens[4]));
+                    print_layout_diff(type_name, diff_layouts(before, after), out);
+
+                } else if ((tokens.size() == 3 || tokens.size() == 4) && tokens[1] == "INSTANTANEA") {
+                    auto snapshot = snapshots.find(tokens[2]);
+                    if (snapshot == snapshots.end()) {
+                        throw runtime_error("Error: Snapshot '" + tokens[2] + "' not found.");
+                    }
+
+                    LayoutStrategy strategy = tokens.size() == 4 ? parse_strategy(tokens[3]) : UNPACKED;
+                    print_type_diffs(diff_type_tables(snapshot->second, types_arr, strategy), out);
+
+                } else {
+                    throw runtime_error("Error: Wrong arguments for DIFERENCIA command." + usage);
+                }
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 15: {
+            try {
+                begin_transaction(tx);
+                out << "Transaction started." << '\n';
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 16: {
+            try {
+                size_t staged = tx.staged.size();
+                bool compact = false;
+                size_t applied = commit_transaction(tx, [&s, &compact](const vector<type_definition>& ordered) {
+                    if (s.wal) compact = s.wal->append(ordered);
+                });
+                out << "Transaction committed: " << staged << " definitions staged, " << applied << " types computed." << '\n';
+                if (compact) s.wal->compact(types_arr);
+            } catch (exception& e) {
+                out << e.what() << '\n';
+                if (tx.active) out << "The transaction is still open. Fix it or use ROLLBACK." << '\n';
+            }
+            break;
+        }
+        case 17: {
+            try {
+                size_t discarded = rollback_transaction(tx);
+                out << "Transaction rolled back: " << discarded << " definitions discarded." << '\n';
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 18: {
+            try {
+                if (tokens.size() != 2) {
+                    throw runtime_error("Error: Wrong number of arguments for IMPORTAR command.\nUsage: IMPORTAR <archivo>.");
+                }
+
+                c_import header = import_c_header(tokens[1]);
+                double throughput = header.elapsed_ms > 0 ? header.bytes / 1e3 / header.elapsed_ms : 0;
+                size_t parsed = header.definitions.size();
+
+                if (tx.active) {
+                    for (auto& def : header.definitions) stage_definition(tx, move(def));
+                    out << parsed << " definitions staged from " << tokens[1] << "." << '\n';
+                    break;
+                }
+
+                // Todo el archivo se aplica como una transaccion: entra completo o no entra
+                auto started = chrono::steady_clock::now();
+                transaction import{true, move(header.definitions)};
+                bool compact = false;
+                size_t applied = commit_transaction(import, [&s, &compact](const vector<type_definition>& ordered) {
+                    if (s.wal) compact = s.wal->append(ordered);
+                });
+                double applied_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+
+                out << fixed << setprecision(2) << applied << " types imported from " << tokens[1] << ": " << header.bytes
+                    << " bytes parsed in " << header.elapsed_ms << " ms (" << throughput << " MB/s), applied in "
+                    << applied_ms << " ms." << '\n';
+                out << defaultfloat;
+                if (compact) s.wal->compact(types_arr);
+
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 19: {
+            try {
+                print_type_query(run_type_query(parse_type_query(tokens)), out);
+            } catch (exception& e) {
+                out << e.what() << '\n';
+            }
+            break;
+        }
+        case 20: {
+            if (tokens.size() == 1) {
+                print_command_stats(out);
+            } else if (tokens.size() == 2 && (tokens[1] == "ON" || tokens[1] == "OFF")) {
+                set_command_stats(tokens[1] == "ON");
+                out << "Statistics " << (tokens[1] == "ON" ? "on." : "off.") << '\n';
+            } else {
+                out << "Error: Wrong arguments for STATS command.\nUsage: STATS [ON|OFF]." << '\n';
+            }
+            break;
+        }
+        default:
+            out << "Error: unknown command." << '\n';
+            out << "Available commands: \nATOMICO, STRUCT, UNION, BITFIELD, VARIANTE, DESCRIBIR, CARRERA, EXPORTAR, INSTANTANEA, DIFERENCIA, BEGIN, COMMIT, ROLLBACK, IMPORTAR, CONSULTA, STATS, IMPRIMIR, OBJETIVO, REPORTE, SALIR." << '\n';
+            break;
+    }
+
+    return true;
+}
+#endif
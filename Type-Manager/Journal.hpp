@@ -0,0 +1,518 @@
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include <fstream>
+#include <cstdint>
+#include <chrono>
+#include <iomanip>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Functions.hpp"
+#include "Export.hpp"
+#include "Transaction.hpp"
+
+/**
+ * CRC-32 (IEEE 802.3) of a block of bytes.
+ *
+ * @param data Bytes.
+ * @param size Number of bytes.
+ * @param crc CRC of the bytes before these, to compute it by parts.
+ * @return the checksum.
+ */
+uint32_t crc32(const char* data, size_t size, uint32_t crc = 0) {
+    static const vector<uint32_t> table = []() {
+        vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ (unsigned char) data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * Reads the integers and strings written by append_le and append_binary_string.
+ *
+ * Reading past the end of the data throws, so a truncated record is detected wherever it's cut.
+ */
+struct byte_reader {
+    const string& data;
+    size_t pos = 0;
+
+    explicit byte_reader(const string& data, size_t pos = 0) : data(data), pos(pos) {}
+
+    void require(size_t num_bytes) const {
+        if (data.size() - pos < num_bytes) {
+            throw runtime_error("Error: Unexpected end of data.");
+        }
+    }
+
+    uint64_t read_le(int num_bytes) {
+        require(num_bytes);
+        uint64_t value = 0;
+        for (int i = 0; i < num_bytes; i++) {
+            value |= (uint64_t) (unsigned char) data[pos + i] << (8 * i);
+        }
+        pos += num_bytes;
+        return value;
+    }
+
+    string read_string() {
+        size_t length = read_le(4);
+        require(length);
+        string text = data.substr(pos, length);
+        pos += length;
+        return text;
+    }
+};
+
+/**
+ * Appends a type definition to a buffer.
+ *
+ * The definition is its kind (1 byte), name, size (8 bytes), alignment (4), width in bits (4), storage unit, tag and the
+ * number of fields (4) followed by their type names.
+ *
+ * @param out Buffer.
+ * @param def Type definition.
+ */
+void append_definition(string& out, const type_definition& def) {
+    append_le(out, def.kind, 1);
+    append_binary_string(out, def.name);
+    append_le(out, def.size, 8);
+    append_le(out, def.align, 4);
+    append_le(out, def.bits, 4);
+    append_binary_string(out, def.unit);
+    append_binary_string(out, def.tag);
+    append_le(out, def.fields.size(), 4);
+    for (const auto& field_name : def.fields) {
+        append_binary_string(out, field_name);
+    }
+}
+
+/**
+ * Reads a type definition written by append_definition.
+ *
+ * @param in Reader positioned at the definition.
+ * @return the definition.
+ */
+type_definition read_definition(byte_reader& in) {
+    type_definition def;
+    uint64_t kind = in.read_le(1);
+    if (kind > VARIANT) {
+        throw runtime_error("Error: Unknown kind of type " + to_string(kind) + ".");
+    }
+    def.kind = (AtomicKind) kind;
+    def.name = in.read_string();
+    def.size = (long long) in.read_le(8);
+    def.align = (int) in.read_le(4);
+    def.bits = (int) in.read_le(4);
+    def.unit = in.read_string();
+    def.tag = in.read_string();
+    size_t num_fields = in.read_le(4);
+    for (size_t i = 0; i < num_fields; i++) {
+        def.fields.push_back(in.read_string());
+    }
+    return def;
+}
+
+/**
+ * Definition of a type of the type table, as it would be given by the user.
+ *
+ * @param name Type name.
+ * @param type Type.
+ * @return the definition, with the size and alignment of the type (for structs and unions, the cap of their alignment).
+ */
+type_definition type_to_definition(const string& name, const atomic_type& type) {
+    type_definition def{type.kind, name};
+    switch (type.kind) {
+        case ATOMIC: {
+            const aatomic& a = get<aatomic>(type.at);
+            def.size = a.size;
+            def.align = a.align;
+            break;
+        }
+        case STRUCT: {
+            const atomic_struct& s = get<atomic_struct>(type.at);
+            def.fields = s.fields;
+            def.size = s.size;
+            def.align = s.max_align;
+            break;
+        }
+        case UNION: {
+            const atomic_union& u = get<atomic_union>(type.at);
+            def.fields = u.fields;
+            def.size = u.size;
+            def.align = u.max_align;
+            break;
+        }
+        case BITFIELD: {
+            const atomic_bitfield& b = get<atomic_bitfield>(type.at);
+            def.bits = b.bits;
+            def.unit = b.unit;
+            def.size = b.size;
+            def.align = b.align;
+            break;
+        }
+        case VARIANT: {
+            const atomic_variant& v = get<atomic_variant>(type.at);
+            def.tag = v.tag;
+            def.fields = v.fields;
+            def.size = v.size;
+            def.align = v.align;
+            break;
+        }
+    }
+    return def;
+}
+
+/**
+ * Type of the type table built from a definition whose size and alignment are already known, without computing them.
+ *
+ * @param def Type definition.
+ * @param size Size of the type.
+ * @param align Alignment of the type.
+ * @return the type.
+ */
+atomic_type definition_to_type(const type_definition& def, long long size, int align) {
+    atomic_type type;
+    type.kind = def.kind;
+    switch (def.kind) {
+        case ATOMIC: type.at = aatomic{def.name, size, align}; break;
+        case STRUCT: type.at = atomic_struct{def.name, def.fields, size, align, def.align}; break;
+        case UNION: type.at = atomic_union{def.name, def.fields, size, align, def.align}; break;
+        case BITFIELD: type.at = atomic_bitfield{def.name, def.bits, def.unit, size, align}; break;
+        case VARIANT: type.at = atomic_variant{def.name, def.tag, def.fields, size, align}; break;
+    }
+    return type;
+}
+
+/**
+ * Reads a whole file.
+ *
+ * @param path Path of the file.
+ * @param data Filled with the bytes of the file.
+ * @return false if the file doesn't exist or can't be read.
+ */
+bool read_buffer(const string& path, string& data) {
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file) return false;
+    data.resize((size_t) file.tellg());
+    file.seekg(0);
+    file.read(&data[0], data.size());
+    return (bool) file;
+}
+
+/**
+ * Magic number at the start of the log of definitions.
+ */
+const string JOURNAL_MAGIC = "TMWL";
+
+/**
+ * Magic number at the start of a snapshot of the type table.
+ */
+const string SNAPSHOT_MAGIC = "TMSN";
+
+/**
+ * Version of the formats of the log and the snapshot.
+ */
+const int JOURNAL_VERSION = 1;
+
+/**
+ * What was recovered when a log was opened.
+ */
+struct recovery_report {
+    bool has_snapshot = false;
+    long long snapshot_types = 0;
+    long long replayed_records = 0;
+    long long replayed_definitions = 0;
+    long long discarded_bytes = 0;
+    double elapsed_ms = 0;
+};
+
+/**
+ * Append-only log of the definitions that changed the type table, compacted from time to time into a snapshot.
+ *
+ * The directory has two files. types.log starts with the magic "TMWL" and the version (4 bytes) and has one record per
+ * command: the length of its payload (4 bytes), the CRC-32 of the sequence number and the payload (4), the sequence number
+ * (8) and the payload, which is the number of definitions (4) followed by them. A COMMIT is a single record, so it's
+ * replayed whole or not at all. Each record is written with a single write, so it survives a crash of the process as soon
+ * as the command returns.
+ *
+ * types.snapshot has the magic "TMSN", the version (4 bytes), the sequence number of the last record it includes (8), the
+ * number of types (4) and each type as a definition followed by its size (8) and alignment (4), in name order, and ends
+ * with the CRC-32 of everything before it. Types are stored with their computed size and alignment instead of being
+ * recomputed, so a snapshot gives back exactly the table it was taken from even if a type was redefined after the types
+ * that use it.
+ *
+ * Once the log has at least compact_every records and is as big as the snapshot, the owner of the table is asked to
+ * compact it: the table is written to a new snapshot, which replaces the old one with a rename, and the log is emptied.
+ * Waiting for the log to grow as big as the snapshot keeps the cost of rewriting the snapshot proportional to the bytes
+ * logged, and replaying the log at most as slow as loading the snapshot.
+ *
+ * Recovery loads the snapshot and replays the records of the log after it. Records left by a crash between the rename
+ * and the emptying are skipped by their sequence number, and a record cut by a crash or with a wrong checksum ends the
+ * log: it's cut off so new records follow the last good one.
+ */
+struct journal {
+    string dir;
+    long long compact_every;
+    int fd = -1;
+    uint64_t sequence = 0; // Numero del ultimo registro escrito
+    long long records_since_snapshot = 0;
+    size_t log_bytes = 0; // Bytes de los registros posteriores a la instantanea
+    size_t snapshot_bytes = 0;
+
+    /**
+     * @param dir Directory of the log. It's created if it doesn't exist.
+     * @param compact_every Minimum number of records between two snapshots.
+     */
+    explicit journal(const string& dir, long long compact_every = 1000) : dir(dir), compact_every(max(compact_every, 1LL)) {
+        if (::mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) {
+            throw runtime_error("Error: Can't create directory '" + dir + "': " + strerror(errno) + ".");
+        }
+    }
+
+    ~journal() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    string log_path() const { return dir + "/types.log"; }
+    string snapshot_path() const { return dir + "/types.snapshot"; }
+
+    /**
+     * Loads the snapshot and replays the log after it into a type table, and opens the log for new records.
+     *
+     * @param arr Type table. Types of the log replace the ones with the same name.
+     * @return what was recovered and how long it took.
+     */
+    recovery_report recover(map<string, atomic_type>& arr) {
+        recovery_report report;
+        auto started = chrono::steady_clock::now();
+
+        string data;
+        uint64_t snapshot_sequence = 0;
+        if (read_buffer(snapshot_path(), data)) {
+            snapshot_sequence = load_snapshot(data, arr);
+            snapshot_bytes = data.size();
+            report.has_snapshot = true;
+            report.snapshot_types = arr.size();
+        }
+        sequence = snapshot_sequence;
+
+        size_t good_end = 0;
+        if (read_buffer(log_path(), data) && data.size() >= 8) {
+            byte_reader in(data, 4);
+            if (data.compare(0, 4, JOURNAL_MAGIC) != 0 || in.read_le(4) != (uint64_t) JOURNAL_VERSION) {
+                throw runtime_error("Error: '" + log_path() + "' isn't a log of this version.");
+            }
+            good_end = 8;
+
+            while (data.size() - good_end >= 16) {
+                in.pos = good_end;
+                size_t length = in.read_le(4);
+                uint32_t checksum = in.read_le(4);
+                if (data.size() - in.pos < 8 + length || crc32(data.data() + in.pos, 8 + length) != checksum) break;
+
+                uint64_t record_sequence = in.read_le(8);
+                size_t record_end = in.pos + length;
+                if (record_sequence > snapshot_sequence) {
+                    size_t num_definitions = in.read_le(4);
+                    for (size_t i = 0; i < num_definitions; i++) {
+                        type_definition def = read_definition(in);
+                        try {
+                            apply_definition(arr, def);
+                        } catch (exception& e) {
+                            throw runtime_error("Error: Can't replay record " + to_string(record_sequence) + " of the log. " + e.what());
+                        }
+                        report.replayed_definitions++;
+                    }
+                    report.replayed_records++;
+                    log_bytes += record_end - good_end;
+                }
+                sequence = max(sequence, record_sequence);
+                good_end = record_end;
+            }
+            report.discarded_bytes = data.size() - good_end;
+        }
+
+        open_log(good_end);
+        records_since_snapshot = report.replayed_records;
+        report.elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+    /**
+     * Loads a snapshot into a type table.
+     *
+     * @param data Bytes of the snapshot.
+     * @param arr Type table.
+     * @return sequence number of the last record included in the snapshot.
+     */
+    uint64_t load_snapshot(const string& data, map<string, atomic_type>& arr) const {
+        if (data.size() < 24 || data.compare(0, 4, SNAPSHOT_MAGIC) != 0
+            || crc32(data.data(), data.size() - 4) != byte_reader(data, data.size() - 4).read_le(4)) {
+            throw runtime_error("Error: '" + snapshot_path() + "' is damaged.");
+        }
+
+        byte_reader in(data, 4);
+        if (in.read_le(4) != (uint64_t) JOURNAL_VERSION) {
+            throw runtime_error("Error: '" + snapshot_path() + "' isn't a snapshot of this version.");
+        }
+        uint64_t snapshot_sequence = in.read_le(8);
+        size_t num_types = in.read_le(4);
+
+        // Los tipos vienen en orden de nombre, asi que cada uno se inserta al final
+        arr.clear();
+        for (size_t i = 0; i < num_types; i++) {
+            type_definition def = read_definition(in);
+            long long size = (long long) in.read_le(8);
+            int align = (int) in.read_le(4);
+            arr.emplace_hint(arr.end(), def.name, definition_to_type(def, size, align));
+            note_type_change(arr, def.name);
+        }
+        return snapshot_sequence;
+    }
+
+    /**
+     * Opens the log for appending, creating it if it doesn't exist and cutting off whatever follows the last good record.
+     *
+     * @param good_end Size of the valid part of the log, 0 if it has none.
+     */
+    void open_log(size_t good_end) {
+        if (fd >= 0) ::close(fd);
+        fd = ::open(log_path().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0 || ::ftruncate(fd, good_end) < 0) {
+            throw runtime_error("Error: Can't open log '" + log_path() + "': " + strerror(errno) + ".");
+        }
+        if (good_end == 0) {
+            string header = JOURNAL_MAGIC;
+            append_le(header, JOURNAL_VERSION, 4);
+            write_all(header);
+        }
+    }
+
+    /**
+     * Writes a block of bytes at the end of the log, retrying on partial writes.
+     *
+     * @param data Bytes to write.
+     */
+    void write_all(const string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw runtime_error("Error: Can't write log '" + log_path() + "': " + strerror(errno) + ".");
+            }
+            written += n;
+        }
+    }
+
+    /**
+     * Appends a record with the definitions of a command that changed the type table. If the record can't be written
+     * whole, the log is cut back to its size before the append.
+     *
+     * @param defs Definitions in the order they were applied.
+     * @return true if the log is due to be compacted.
+     */
+    bool append(const vector<type_definition>& defs) {
+        string record(16, '\0');
+        append_le(record, defs.size(), 4);
+        for (const auto& def : defs) {
+            append_definition(record, def);
+        }
+
+        // Cabecera: longitud del contenido, checksum, numero de secuencia
+        string header;
+        append_le(header, record.size() - 16, 4);
+        header.append(4, '\0');
+        append_le(header, sequence + 1, 8);
+        record.replace(0, 16, header);
+        string checksum;
+        append_le(checksum, crc32(record.data() + 8, record.size() - 8), 4);
+        record.replace(4, 4, checksum);
+
+        // Un registro a medias cortaria el diario y los siguientes se perderian al recuperar: se quita si falla la escritura
+        off_t end = ::lseek(fd, 0, SEEK_END);
+        try {
+            write_all(record);
+        } catch (exception&) {
+            if (end < 0 || ::ftruncate(fd, end) < 0) {
+                throw runtime_error("Error: Can't cut torn record off log '" + log_path() + "': " + strerror(errno) + ".");
+            }
+            throw;
+        }
+        sequence++;
+        log_bytes += record.size();
+        return ++records_since_snapshot >= compact_every && log_bytes >= snapshot_bytes;
+    }
+
+    /**
+     * Writes the type table to a new snapshot and empties the log.
+     *
+     * The snapshot is written to a temporary file and synced before it replaces the old one, so there's always a complete
+     * snapshot on disk.
+     *
+     * @param arr Type table.
+     */
+    void compact(const map<string, atomic_type>& arr) {
+        string data = SNAPSHOT_MAGIC;
+        data.reserve(24 + arr.size() * 64);
+        append_le(data, JOURNAL_VERSION, 4);
+        append_le(data, sequence, 8);
+        append_le(data, arr.size(), 4);
+        for (const auto& [name, type] : arr) {
+            auto [size, align] = type_size_align(type);
+            append_definition(data, type_to_definition(name, type));
+            append_le(data, size, 8);
+            append_le(data, align, 4);
+        }
+        append_le(data, crc32(data.data(), data.size()), 4);
+
+        string temporary = snapshot_path() + ".tmp";
+        int snapshot_fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool ok = snapshot_fd >= 0;
+        for (size_t written = 0; ok && written < data.size();) {
+            ssize_t n = ::write(snapshot_fd, data.data() + written, data.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            ok = n > 0;
+            if (ok) written += n;
+        }
+        ok = ok && ::fsync(snapshot_fd) == 0;
+        if (snapshot_fd >= 0) ::close(snapshot_fd);
+        if (!ok || ::rename(temporary.c_str(), snapshot_path().c_str()) < 0) {
+            throw runtime_error("Error: Can't write snapshot '" + snapshot_path() + "': " + strerror(errno) + ".");
+        }
+
+        open_log(0);
+        records_since_snapshot = 0;
+        log_bytes = 0;
+        snapshot_bytes = data.size();
+    }
+};
+
+/**
+ * Prints what was recovered when a log was opened.
+ *
+ * @param report Result of the recovery.
+ * @param out Stream where the output is written.
+ */
+void print_recovery_report(const recovery_report& report, ostream& out = cout) {
+    out << "Recovered " << (report.has_snapshot ? report.snapshot_types : 0) << " types from snapshot and "
+        << report.replayed_definitions << " definitions from " << report.replayed_records << " log records in "
+        << fixed << setprecision(2) << report.elapsed_ms << " ms";
+    out << defaultfloat;
+    if (report.discarded_bytes > 0) out << " (" << report.discarded_bytes << " damaged bytes discarded)";
+    out << '\n';
+}
+#endif
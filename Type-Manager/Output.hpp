@@ -0,0 +1,152 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <streambuf>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include "Functions.hpp"
+
+/**
+ * Destination of the output of the printers.
+ *
+ * Sinks are stream buffers, so a printer writes to one through an ostream built on top of it. writes counts the times
+ * the output was handed to the system and bytes the number of bytes received.
+ */
+struct output_sink : public streambuf {
+    long long writes = 0;
+    long long bytes = 0;
+};
+
+/**
+ * Sink that keeps the output in a memory buffer reserved up front.
+ */
+struct memory_sink : public output_sink {
+    string data;
+
+    explicit memory_sink(size_t capacity = 1 << 16) {
+        data.reserve(capacity);
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            data.push_back(traits_type::to_char_type(c));
+            bytes++;
+        }
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char* s, streamsize n) override {
+        data.append(s, n);
+        bytes += n;
+        return n;
+    }
+};
+
+/**
+ * Sink that writes to a file descriptor through a fixed buffer.
+ *
+ * The buffer is written when it gets full or when the stream is flushed, so flushing only between commands makes one
+ * write per command (or per buffer full of output).
+ */
+struct fd_sink : public output_sink {
+    int fd;
+    vector<char> buffer;
+
+    explicit fd_sink(int fd, size_t capacity = 1 << 16) : fd(fd), buffer(max(capacity, (size_t) 1)) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+    ~fd_sink() override {
+        sync();
+    }
+
+protected:
+    /**
+     * Writes a block of bytes, retrying on partial writes.
+     *
+     * @return false if the descriptor failed.
+     */
+    bool write_all(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            writes++;
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    int sync() override {
+        size_t pending = pptr() - pbase();
+        bytes += pending;
+        bool ok = write_all(pbase(), pending);
+        setp(buffer.data(), buffer.data() + buffer.size());
+        return ok ? 0 : -1;
+    }
+
+    int_type overflow(int_type c) override {
+        if (sync() != 0) return traits_type::eof();
+        if (c != traits_type::eof()) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char* s, streamsize n) override {
+        if (n <= epptr() - pptr()) {
+            memcpy(pptr(), s, n);
+            pbump(n);
+            return n;
+        }
+        // Lo que no entra en el buffer se escribe directamente, sin copiarlo
+        if (sync() != 0) return 0;
+        if (n >= (streamsize) buffer.size()) {
+            bytes += n;
+            return write_all(s, n) ? n : 0;
+        }
+        memcpy(pptr(), s, n);
+        pbump(n);
+        return n;
+    }
+};
+
+/**
+ * Sink that discards the output. Useful to measure the cost of the printers without the cost of the output.
+ */
+struct null_sink : public output_sink {
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) bytes++;
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char*, streamsize n) override {
+        bytes += n;
+        return n;
+    }
+};
+
+/**
+ * Redirects a stream to another stream buffer until it goes out of scope.
+ *
+ * The stream is flushed before its previous buffer is restored.
+ */
+struct stream_redirect {
+    ostream& stream;
+    streambuf* previous;
+
+    stream_redirect(ostream& stream, streambuf* sink) : stream(stream), previous(stream.rdbuf(sink)) {}
+
+    ~stream_redirect() {
+        stream.flush();
+        stream.rdbuf(previous);
+    }
+};
+#endif
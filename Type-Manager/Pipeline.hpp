@@ -0,0 +1,292 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "Functions.hpp"
+
+/**
+ * Bounded single-producer single-consumer queue.
+ *
+ * A ring buffer whose positions are only advanced by one thread each, so pushing and popping need no locks. A thread that
+ * has to wait (queue full or empty) sleeps on a condition variable until the other side moves or wake is called. The
+ * mutex is only taken to sleep and, when the other side is sleeping, to wake it up, so while both sides keep up with
+ * each other no operation locks. The capacity is rounded up to a power of two.
+ */
+template <typename T>
+struct spsc_queue {
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> head{0}; // Siguiente posicion a leer, solo la avanza el consumidor
+    alignas(64) atomic<size_t> tail{0}; // Siguiente posicion a escribir, solo la avanza el productor
+    mutex m;
+    condition_variable cv;
+    atomic<int> sleepers{0}; // Hilos dormidos (o por dormirse) en cv
+
+    explicit spsc_queue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    /**
+     * Adds an element if there's room for it. Only called by the producer.
+     *
+     * @return false if the queue is full.
+     */
+    bool try_push(T& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = move(value);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Takes the oldest element if there's any. Only called by the consumer.
+     *
+     * @return false if the queue is empty.
+     */
+    bool try_pop(T& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;
+        value = move(slots[h & mask]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * Wakes up the threads waiting on the queue, so they check again for room, elements or stop.
+     */
+    void wake() {
+        // Tomar el mutex evita que el aviso llegue entre la comprobacion de un hilo y su espera
+        { lock_guard<mutex> lock(m); }
+        cv.notify_all();
+    }
+
+    /**
+     * Wakes up the other side after an element moved, only if it's sleeping.
+     */
+    void wake_sleepers() {
+        // La barrera ordena el avance de la posicion antes de leer sleepers: o el hilo que se va a dormir ve la posicion
+        // nueva al comprobar, o aqui se ve que duerme y se lo despierta
+        atomic_thread_fence(memory_order_seq_cst);
+        if (sleepers.load() > 0) wake();
+    }
+
+    /**
+     * Sleeps until the condition holds or stop is set.
+     */
+    template <typename Condition>
+    void sleep_until(const atomic<bool>& stop, Condition ready) {
+        unique_lock<mutex> lock(m);
+        sleepers.fetch_add(1);
+        cv.wait(lock, [&]() { return stop.load() || ready(); });
+        sleepers.fetch_sub(1);
+    }
+
+    /**
+     * Adds an element, waiting while the queue is full.
+     *
+     * @return false if stop was set while waiting.
+     */
+    bool push(T value, const atomic<bool>& stop) {
+        while (!try_push(value)) {
+            sleep_until(stop, [&]() { return tail.load() - head.load() < slots.size(); });
+            if (stop.load()) return false;
+        }
+        wake_sleepers();
+        return true;
+    }
+
+    /**
+     * Takes the oldest element, waiting while the queue is empty.
+     *
+     * @return false if stop was set while waiting.
+     */
+    bool pop(T& value, const atomic<bool>& stop) {
+        while (!try_pop(value)) {
+            sleep_until(stop, [&]() { return head.load() != tail.load(); });
+            if (stop.load()) return false;
+        }
+        wake_sleepers();
+        return true;
+    }
+};
+
+/**
+ * Command read by the interpreter: its tokens and the code of the command (0 if it's unknown).
+ */
+struct parsed_command {
+    vector<string> tokens;
+    int code = 0;
+};
+
+/**
+ * Tokenizes a line and looks up its command.
+ *
+ * @param line Line of input.
+ * @param commands Code of each command name.
+ * @return the parsed command.
+ */
+parsed_command parse_command(const string& line, const map<string, int>& commands) {
+    parsed_command command;
+    command.tokens = split(line);
+    if (!command.tokens.empty()) {
+        auto found = commands.find(command.tokens[0]);
+        command.code = found == commands.end() ? 0 : found->second;
+    }
+    return command;
+}
+
+/**
+ * Consecutive elements passed at once between two stages of the pipeline. is_end marks the last batch of the input.
+ */
+template <typename T>
+struct batch {
+    vector<T> items;
+    bool is_end = false;
+};
+
+/**
+ * Source of the commands executed by the interpreter.
+ *
+ * Sequential sources read and tokenize each line when the executor asks for the next command. Pipelined sources run a
+ * reader stage and a tokenizer stage on their own threads, connected to each other and to the executor by bounded SPSC
+ * queues, so reading and tokenizing the next commands overlaps with the execution of the current one. Lines travel in
+ * batches of whatever is already buffered in the input, so the stages don't hand over each line separately but a partial
+ * batch is never held back waiting for more input. Commands reach the executor in input order either way. Whatever depends on the type table is still validated by the executor, which is the
+ * only stage that touches it.
+ *
+ * A reader waiting for input can't be interrupted, so if the source is destroyed while its reader waits, the reader is
+ * detached instead of joined. The state it uses is shared with it and outlives the source.
+ */
+struct command_source {
+    /**
+     * State shared by the stages of the pipeline. reading is set while the reader waits for input that may never come.
+     */
+    struct stages {
+        atomic<bool> stop{false};
+        atomic<bool> reading{false};
+        spsc_queue<batch<string>> lines;
+        spsc_queue<batch<parsed_command>> parsed;
+
+        explicit stages(size_t capacity) : lines(capacity), parsed(capacity) {}
+    };
+
+    istream& in;
+    ostream& out;
+    map<string, int> commands;
+    bool pipelined;
+    shared_ptr<stages> pipeline;
+    batch<parsed_command> current;
+    size_t current_index = 0;
+    thread reader;
+    thread tokenizer;
+    ostream* tied = nullptr;
+
+    /**
+     * @param in Input with one command per line.
+     * @param out Output of the interpreter. It's flushed each time a command is requested.
+     * @param commands Code of each command name.
+     * @param pipelined If true the reader and tokenizer stages run on their own threads.
+     * @param capacity Capacity, in batches, of each queue of the pipeline.
+     * @param batch_size Maximum number of lines of a batch.
+     */
+    command_source(istream& in, ostream& out, const map<string, int>& commands, bool pipelined, size_t capacity = 64,
+                   size_t batch_size = 256)
+        : in(in), out(out), commands(commands), pipelined(pipelined), pipeline(make_shared<stages>(capacity)) {
+        if (!pipelined) return;
+
+        // El lector no debe vaciar la salida desde su hilo
+        tied = in.tie(nullptr);
+
+        // El lector solo usa el estado compartido y la entrada: puede quedar suelto esperando una linea
+        reader = thread([state = pipeline, input = &in, batch_size]() {
+            batch<string> pending;
+            string line;
+            while (true) {
+                // Antes de una lectura que puede bloquear se entrega lo acumulado
+                bool may_block = input->rdbuf()->in_avail() <= 0;
+                if (!pending.items.empty() && (may_block || pending.items.size() >= batch_size)) {
+                    if (!state->lines.push(move(pending), state->stop)) return;
+                    pending = batch<string>();
+                }
+                // reading se publica antes de mirar stop: el destructor ve uno de los dos y no espera una lectura bloqueada
+                state->reading = may_block;
+                if (state->stop) return;
+                bool has_line = (bool) getline(*input, line);
+                state->reading = false;
+                if (!has_line) break;
+                pending.items.push_back(move(line));
+            }
+            pending.is_end = true;
+            state->lines.push(move(pending), state->stop);
+        });
+
+        tokenizer = thread([this]() {
+            batch<string> read;
+            while (pipeline->lines.pop(read, pipeline->stop)) {
+                batch<parsed_command> commands;
+                commands.items.reserve(read.items.size());
+                for (const auto& line : read.items) {
+                    commands.items.push_back(parse(line));
+                }
+                commands.is_end = read.is_end;
+                if (!pipeline->parsed.push(move(commands), pipeline->stop) || read.is_end) return;
+            }
+        });
+    }
+
+    ~command_source() {
+        pipeline->stop = true;
+        pipeline->lines.wake();
+        pipeline->parsed.wake();
+        if (tokenizer.joinable()) tokenizer.join();
+        if (reader.joinable()) {
+            if (pipeline->reading) {
+                reader.detach();
+            } else {
+                reader.join();
+            }
+        }
+        if (pipelined) in.tie(tied);
+    }
+
+    /**
+     * Tokenizes a line and looks up its command.
+     *
+     * @param line Line of input.
+     * @return the parsed command.
+     */
+    parsed_command parse(const string& line) const {
+        return parse_command(line, commands);
+    }
+
+    /**
+     * Takes the next command, flushing the output of the previous ones first.
+     *
+     * @param command Filled with the next command.
+     * @return false at the end of the input.
+     */
+    bool next(parsed_command& command) {
+        out.flush();
+        if (!pipelined) {
+            string line;
+            if (!getline(in, line)) return false;
+            command = parse(line);
+            return true;
+        }
+        while (current_index == current.items.size()) {
+            if (current.is_end || !pipeline->parsed.pop(current, pipeline->stop)) return false;
+            current_index = 0;
+        }
+        command = move(current.items[current_index++]);
+        return true;
+    }
+};
+#endif
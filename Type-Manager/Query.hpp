@@ -0,0 +1,429 @@
+#ifndef QUERY_HPP
+#define QUERY_HPP
+
+#include <set>
+#include <mutex>
+#include <array>
+#include <deque>
+#include "Functions.hpp"
+
+/**
+ * Values of a type the index can be searched by.
+ *
+ * All of them come from the layout of the type with the C rules, where nested structs and unions are placed as blocks like
+ * the opaque strategy does. METRIC_SIZE and METRIC_ALIGN are its stride and alignment, which follow the fields of the
+ * type when they're redefined (the type table keeps the values of the definition). METRIC_WASTED is the bytes of padding
+ * in an element of an array of the type (for unions, the bytes left unused by its smallest alternative) and
+ * METRIC_SAVING, for structs, the bytes saved per element by reordering its members with the heuristic. Unlike the
+ * flattened strategies, that layout can be computed from the direct fields of a type and the layouts already computed
+ * for them, so each type is laid out once.
+ */
+enum TypeMetric { METRIC_SIZE, METRIC_ALIGN, METRIC_WASTED, METRIC_SAVING };
+
+/**
+ * Names of the metrics in the query language, in the order of TypeMetric.
+ */
+const vector<string> METRIC_NAMES = {"TAMANO", "ALINEACION", "DESPERDICIO", "AHORRO"};
+
+/**
+ * Secondary indexes of the type table.
+ *
+ * Each metric has an ordered index of (value, name) and each type keeps the types that have it as a field, unit or tag.
+ * Entries are linked by pointers, which stay valid while the map grows. stride, align, used and slot are the ones of the
+ * layout of the type with the C rules, kept to lay out the types that contain it.
+ *
+ * The indexes are brought up to date before each query from changed_types: only the types defined since the last query
+ * and the types that embed them, whose layouts depend on them, are laid out again. A type that only appears as a
+ * dependency of another has an entry that isn't present. Queries only take the shared lock of the server, so updates to
+ * the indexes are serialized by m.
+ */
+struct type_index {
+    struct index_entry {
+        const string* name = nullptr;
+        bool present = false;
+        bool indexed = false;
+        bool affected = false;
+        AtomicKind kind = ATOMIC;
+        array<long long, 4> values = {0, 0, 0, 0};
+        long long stride = 0;
+        long long used = 0;
+        int align = 1;
+        field_slot slot;
+        vector<index_entry*> dependencies; // Campos, unidad o etiqueta en orden de declaracion, con repetidos
+        // Tipos que lo contienen con la version de sus aristas al enlazarlo: al redefinirse un tipo sus aristas viejas
+        // quedan obsoletas en vez de borrarse, porque un tipo como int puede estar en cientos de miles de structs
+        vector<pair<index_entry*, unsigned>> embedded_in;
+        unsigned version = 0;
+    };
+
+    struct value_less {
+        bool operator()(const pair<long long, const string*>& a, const pair<long long, const string*>& b) const {
+            return a.first != b.first ? a.first < b.first : *a.second < *b.second;
+        }
+    };
+
+    mutex m;
+    unordered_map<string, index_entry> entries;
+    array<set<pair<long long, const string*>, value_less>, 4> by_metric;
+    size_t present = 0;
+};
+
+/**
+ * Indexes of types_arr, shared like the table itself.
+ */
+type_index types_index;
+
+/**
+ * Drops the stale edges of the types that contain a type.
+ *
+ * @param entry Entry of the type.
+ * @return the entries of the types that contain it.
+ */
+const vector<pair<type_index::index_entry*, unsigned>>& live_containers(type_index::index_entry& entry) {
+    auto& containers = entry.embedded_in;
+    containers.erase(remove_if(containers.begin(), containers.end(), [](const auto& edge) {
+        return !edge.first->present || edge.first->version != edge.second;
+    }), containers.end());
+    return containers;
+}
+
+/**
+ * Lays out a type of the table with the C rules and computes its metrics, using the entries of its fields, which must be
+ * up to date.
+ *
+ * @param entry Entry of the type, whose values and layout are set.
+ */
+void compute_type_metrics(type_index::index_entry& entry) {
+    const atomic_type& type = lookup_type(types_arr, *entry.name);
+    auto [size, align] = type_size_align(type);
+    entry.values = {size, align, 0, 0};
+
+    // Cada campo es un bloque: los structs y uniones anidados con el layout que ya tienen en el indice
+    auto block = [](const type_index::index_entry* field) {
+        if (field->present && (field->kind == STRUCT || field->kind == UNION)) {
+            return field_slot{"", 0, field->stride, field->align};
+        }
+        return field->slot;
+    };
+
+    try {
+        if (entry.kind == STRUCT) {
+            vector<field_slot> blocks;
+            blocks.reserve(entry.dependencies.size());
+            long long used = 0;
+            long long block_used = 0; // Bytes de los bloques que compute_layout cuenta como ocupados
+            for (const auto* field : entry.dependencies) {
+                blocks.push_back(block(field));
+                used = checked_add(used, field->used);
+                block_used = checked_add(block_used, blocks.back().size);
+            }
+            struct_layout natural = compute_layout(blocks, UNPACKED, false);
+            struct_layout reordered = compute_layout(blocks, HEURISTIC, false);
+            entry.stride = natural.stride;
+            entry.align = capped_align(natural.align, type_max_align(type));
+            entry.used = natural.used - block_used + used;
+            entry.values[METRIC_WASTED] = natural.stride - entry.used;
+            entry.values[METRIC_SAVING] = natural.stride - reordered.stride;
+        } else if (entry.kind == UNION) {
+            long long largest = 0;
+            long long least_used = LLONG_MAX;
+            entry.align = 1;
+            entry.used = 0;
+            for (const auto* field : entry.dependencies) {
+                field_slot slot = block(field);
+                largest = max(largest, align_up(slot.size, slot.align));
+                entry.align = lcm(entry.align, slot.align);
+                entry.used = max(entry.used, field->used);
+                least_used = min(least_used, field->used);
+            }
+            entry.stride = align_up(largest, entry.align);
+            entry.align = capped_align(entry.align, type_max_align(type));
+            entry.values[METRIC_WASTED] = entry.stride - least_used;
+        } else {
+            entry.slot = leaf_slot(*entry.name);
+            entry.slot.name = "";
+            struct_layout layout = compute_layout({entry.slot}, UNPACKED, false);
+            entry.stride = layout.stride;
+            entry.align = layout.align;
+            entry.used = layout.used;
+        }
+        // El tamano y la alineacion son los del layout del indice, que siguen a los campos aunque se redefinan
+        entry.values[METRIC_SIZE] = entry.stride;
+        entry.values[METRIC_ALIGN] = entry.align;
+    } catch (overflow_error&) {
+        // Un tipo demasiado grande para ubicarse queda con los valores de la tabla, sin desperdicio ni ahorro
+        entry.values[METRIC_WASTED] = 0;
+        entry.values[METRIC_SAVING] = 0;
+    }
+}
+
+/**
+ * Brings the indexes up to date with the type table.
+ *
+ * If the number of present types doesn't match the table, it was changed without going through push_* (for example
+ * cleared), and the indexes are rebuilt from scratch. An empty index is filled from its sorted values at once, which is
+ * linear, instead of one insertion at a time.
+ *
+ * @param index Indexes of types_arr.
+ */
+void refresh_type_index(type_index& index) {
+    using index_entry = type_index::index_entry;
+    if (changed_types.empty() && index.present == types_arr.size()) return;
+
+    vector<string> changed(changed_types.begin(), changed_types.end());
+    changed_types.clear();
+
+    auto entry_of = [&index](const string& name) {
+        auto it = index.entries.try_emplace(name).first;
+        it->second.name = &it->first;
+        return &it->second;
+    };
+    auto unindex = [&index](index_entry& entry) {
+        if (!entry.indexed) return;
+        for (int metric = 0; metric < 4; metric++) index.by_metric[metric].erase({entry.values[metric], entry.name});
+        entry.indexed = false;
+    };
+
+    // Primero se actualizan las aristas de los tipos que cambiaron
+    auto relink = [&](const string& name) {
+        index_entry* entry = entry_of(name);
+        entry->version++;
+        entry->dependencies.clear();
+        if (entry->present) index.present--;
+        entry->present = false;
+
+        const atomic_type* found = find_type(types_arr, name);
+        if (found != nullptr) {
+            entry->present = true;
+            entry->kind = found->kind;
+            index.present++;
+            // Las dependencias se leen del tipo sin copiarlo a una definicion
+            auto link = [&](const string& dependency) {
+                index_entry* target = entry_of(dependency);
+                entry->dependencies.push_back(target);
+                auto& containers = target->embedded_in;
+                if (containers.empty() || containers.back() != make_pair(entry, entry->version)) {
+                    containers.push_back({entry, entry->version});
+                }
+            };
+            const auto& at = found->at;
+            if (entry->kind == STRUCT) for (const auto& field : get<atomic_struct>(at).fields) link(field);
+            else if (entry->kind == UNION) for (const auto& field : get<atomic_union>(at).fields) link(field);
+            else if (entry->kind == BITFIELD) link(get<atomic_bitfield>(at).unit);
+            else if (entry->kind == VARIANT) {
+                link(get<atomic_variant>(at).tag);
+                for (const auto& field : get<atomic_variant>(at).fields) link(field);
+            }
+        }
+        return entry;
+    };
+    vector<index_entry*> affected;
+    for (const auto& name : changed) affected.push_back(relink(name));
+
+    if (index.present != types_arr.size()) {
+        index.entries.clear();
+        index.entries.reserve(types_arr.size());
+        for (auto& metric : index.by_metric) metric.clear();
+        index.present = 0;
+        affected.clear();
+        for (const auto& [name, type] : types_arr) affected.push_back(relink(name));
+    }
+
+    // Los tipos que contienen a uno que cambio tambien se vuelven a ubicar
+    for (index_entry* entry : affected) entry->affected = true;
+    for (size_t i = 0; i < affected.size(); i++) {
+        for (const auto& [container, version] : live_containers(*affected[i])) {
+            if (!container->affected) {
+                container->affected = true;
+                affected.push_back(container);
+            }
+        }
+    }
+
+    // Cada tipo se ubica despues de sus dependencias, con DFS iterativo porque el anidamiento puede ser muy profundo
+    bool bulk = index.by_metric[0].empty();
+    vector<index_entry*> computed;
+    vector<pair<index_entry*, size_t>> stack;
+    for (index_entry* root : affected) {
+        if (!root->affected) continue;
+        root->affected = false;
+        stack.push_back({root, 0});
+        while (!stack.empty()) {
+            index_entry* entry = stack.back().first;
+            size_t next = stack.back().second++;
+            if (next < entry->dependencies.size()) {
+                index_entry* dependency = entry->dependencies[next];
+                if (dependency->affected) {
+                    dependency->affected = false;
+                    stack.push_back({dependency, 0});
+                }
+                continue;
+            }
+            stack.pop_back();
+            unindex(*entry);
+            if (!entry->present) continue;
+            compute_type_metrics(*entry);
+            entry->indexed = true;
+            if (bulk) {
+                computed.push_back(entry);
+            } else {
+                for (int metric = 0; metric < 4; metric++) index.by_metric[metric].insert({entry->values[metric], entry->name});
+            }
+        }
+    }
+
+    for (int metric = 0; bulk && metric < 4; metric++) {
+        vector<pair<long long, const string*>> values;
+        values.reserve(computed.size());
+        for (index_entry* entry : computed) values.push_back({entry->values[metric], entry->name});
+        sort(values.begin(), values.end(), type_index::value_less());
+        index.by_metric[metric] = set<pair<long long, const string*>, type_index::value_less>(values.begin(), values.end());
+    }
+}
+
+/**
+ * Query over the indexes of the type table.
+ *
+ * A range query (op one of <, <=, =, >=, >) returns the types whose metric compares with value, in increasing order of
+ * the metric. A top query (op "MAYORES") returns the value types with the greatest metric, in decreasing order. A
+ * containment query (embeds not empty) returns the types that have the type as a field at any depth, by name. limit caps
+ * the number of results (-1 for none).
+ */
+struct type_query {
+    TypeMetric metric = METRIC_SIZE;
+    string op = "";
+    long long value = 0;
+    string embeds = "";
+    long long limit = -1;
+};
+
+/**
+ * Parses the arguments of CONSULTA.
+ *
+ * @param tokens Tokens of the command, including CONSULTA.
+ * @return the query.
+ */
+type_query parse_type_query(const vector<string>& tokens) {
+    const string usage = "\nUsage: CONSULTA <TAMANO|ALINEACION|DESPERDICIO|AHORRO> <op> <valor> [LIMITE <n>], "
+                         "CONSULTA <TAMANO|ALINEACION|DESPERDICIO|AHORRO> MAYORES <n> o CONSULTA CONTIENE <tipo> [LIMITE <n>].";
+    type_query query;
+    size_t next;
+    if (tokens.size() >= 3 && tokens[1] == "CONTIENE") {
+        query.embeds = tokens[2];
+        next = 3;
+    } else if (tokens.size() >= 4) {
+        auto metric = find(METRIC_NAMES.begin(), METRIC_NAMES.end(), tokens[1]);
+        if (metric == METRIC_NAMES.end()) {
+            throw runtime_error("Error: Unknown metric '" + tokens[1] + "'." + usage);
+        }
+        query.metric = (TypeMetric) (metric - METRIC_NAMES.begin());
+        query.op = tokens[2];
+        if (query.op != "<" && query.op != "<=" && query.op != "=" && query.op != ">=" && query.op != ">" && query.op != "MAYORES") {
+            throw runtime_error("Error: Unknown operator '" + query.op + "'." + usage);
+        }
+        if (!is_integer(tokens[3])) {
+            throw runtime_error("Error: Non-integer value '" + tokens[3] + "'." + usage);
+        }
+        query.value = stoll(tokens[3]);
+        if (query.op == "MAYORES" && query.value < 0) {
+            throw runtime_error("Error: The number of types must be positive." + usage);
+        }
+        next = 4;
+    } else {
+        throw runtime_error("Error: Wrong number of arguments for CONSULTA command." + usage);
+    }
+
+    if (next < tokens.size()) {
+        if (tokens.size() != next + 2 || tokens[next] != "LIMITE" || query.op == "MAYORES" || !is_integer(tokens[next + 1])
+            || stoll(tokens[next + 1]) < 0) {
+            throw runtime_error("Error: Unexpected arguments after the query." + usage);
+        }
+        query.limit = stoll(tokens[next + 1]);
+    }
+    return query;
+}
+
+/**
+ * Answers a query from the indexes of the type table, bringing them up to date first.
+ *
+ * The cost depends on the number of results (for CONTIENE, of the types that contain the type, since they're sorted by
+ * name before the limit) and on the types changed since the last query, not on the size of the table.
+ *
+ * @param query Query.
+ * @param index Indexes of types_arr.
+ * @return pairs (name, metric values) of the types that match, in the order of the query.
+ */
+vector<pair<string, array<long long, 4>>> run_type_query(const type_query& query, type_index& index = types_index) {
+    lock_guard<mutex> lock(index.m);
+    refresh_type_index(index);
+
+    vector<pair<string, array<long long, 4>>> results;
+    size_t limit = query.limit < 0 ? SIZE_MAX : (size_t) query.limit;
+    auto add = [&](const string* name) {
+        if (results.size() >= limit) return false;
+        results.push_back({*name, index.entries.find(*name)->second.values});
+        return true;
+    };
+
+    if (!query.embeds.empty()) {
+        auto root = index.entries.find(query.embeds);
+        if (root == index.entries.end() || !root->second.present) {
+            throw runtime_error("Error: Type '" + query.embeds + "' not found in type table.");
+        }
+        // Recorrido por las dependencias inversas: solo se visitan los tipos que lo contienen
+        unordered_set<type_index::index_entry*> visited;
+        vector<type_index::index_entry*> pending = {&root->second};
+        vector<const string*> found;
+        while (!pending.empty()) {
+            type_index::index_entry* entry = pending.back();
+            pending.pop_back();
+            for (const auto& [container, version] : live_containers(*entry)) {
+                if (visited.insert(container).second) {
+                    pending.push_back(container);
+                    found.push_back(container->name);
+                }
+            }
+        }
+        sort(found.begin(), found.end(), [](const string* a, const string* b) { return *a < *b; });
+        for (const string* name : found) {
+            if (!add(name)) break;
+        }
+        return results;
+    }
+
+    const auto& values = index.by_metric[query.metric];
+    static const string first_name = "";
+    if (query.op == "MAYORES") {
+        limit = min(limit, (size_t) query.value);
+        for (auto it = values.rbegin(); it != values.rend() && add(it->second); ++it) {}
+        return results;
+    }
+
+    // Rango [from, to) sobre el indice ordenado por valor
+    auto at_least = [&values](long long value) { return values.lower_bound({value, &first_name}); };
+    auto above = [&](long long value) { return value == LLONG_MAX ? values.end() : at_least(value + 1); };
+    auto from = values.begin();
+    auto to = values.end();
+    if (query.op == "<") to = at_least(query.value);
+    else if (query.op == "<=") to = above(query.value);
+    else if (query.op == "=") from = at_least(query.value), to = above(query.value);
+    else if (query.op == ">=") from = at_least(query.value);
+    else if (query.op == ">") from = above(query.value);
+    for (auto it = from; it != to && add(it->second); ++it) {}
+    return results;
+}
+
+/**
+ * Prints the result of a query, one type per line with its metrics.
+ *
+ * @param results Result of run_type_query.
+ * @param out Stream where the output is written.
+ */
+void print_type_query(const vector<pair<string, array<long long, 4>>>& results, ostream& out = cout) {
+    for (const auto& [name, values] : results) {
+        out << name << ": size " << values[METRIC_SIZE] << ", align " << values[METRIC_ALIGN] << ", wasted "
+            << values[METRIC_WASTED] << ", saving " << values[METRIC_SAVING] << '\n';
+    }
+    out << results.size() << (results.size() == 1 ? " type matches." : " types match.") << '\n';
+}
+#endif
@@ -0,0 +1,401 @@
+#ifndef RACING_HPP
+#define RACING_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <queue>
+#include <chrono>
+#include "Functions.hpp"
+
+/**
+ * Fixed-size pool of worker threads.
+ *
+ * Tasks are run in submission order by the first free worker. The destructor waits for the pending tasks to finish.
+ */
+struct thread_pool {
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex m;
+    condition_variable cv;
+    bool stopping = false;
+
+    explicit thread_pool(size_t num_threads) {
+        num_threads = max(num_threads, (size_t) 1);
+        for (size_t i = 0; i < num_threads; i++) {
+            workers.emplace_back([this]() {
+                while (true) {
+                    function<void()> task;
+                    {
+                        unique_lock<mutex> lock(m);
+                        cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                        if (tasks.empty()) return;
+                        task = move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~thread_pool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void submit(function<void()> task) {
+        {
+            lock_guard<mutex> lock(m);
+            tasks.push(move(task));
+        }
+        cv.notify_one();
+    }
+};
+
+/**
+ * Result of one strategy of a race.
+ *
+ * Search strategies publish a result each time they improve their best layout (is_final false) and a last one when they
+ * finish. is_exhaustive is false when the search was cut off before proving its layout optimal.
+ */
+struct strategy_result {
+    string strategy;
+    struct_layout layout;
+    bool is_cheap = true;
+    bool respects_alignment = true;
+    bool is_final = true;
+    bool is_exhaustive = true;
+    double elapsed_ms = 0;
+};
+
+/**
+ * Shared state of a race between strategies.
+ *
+ * Results are queued in the order they're produced. cancel asks the search strategies to stop and publish their best
+ * layout so far. failure keeps the error of the first strategy that failed; it also cancels the race.
+ */
+struct strategy_race {
+    mutex m;
+    condition_variable cv;
+    deque<strategy_result> ready;
+    int pending = 0;
+    int cheap_pending = 0;
+    string failure;
+    atomic<bool> cancel{false};
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+};
+
+/**
+ * Queues a result of the race and wakes up the consumers.
+ *
+ * @param race Race state.
+ * @param result Result to publish.
+ */
+void publish_strategy_result(strategy_race& race, strategy_result result) {
+    result.elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - race.started).count();
+    {
+        lock_guard<mutex> lock(race.m);
+        if (result.is_final) {
+            race.pending--;
+            if (result.is_cheap) race.cheap_pending--;
+        }
+        race.ready.push_back(move(result));
+    }
+    race.cv.notify_all();
+}
+
+/**
+ * Records that a strategy of the race failed. It counts as finished and publishes no result.
+ *
+ * @param race Race state.
+ * @param is_cheap True if the strategy is a cheap one.
+ * @param error Error of the strategy.
+ */
+void fail_strategy(strategy_race& race, bool is_cheap, const exception& error) {
+    {
+        lock_guard<mutex> lock(race.m);
+        race.pending--;
+        if (is_cheap) race.cheap_pending--;
+        if (race.failure.empty()) race.failure = error.what();
+    }
+    race.cancel.store(true);
+    race.cv.notify_all();
+}
+
+/**
+ * Searches the order of the fields that minimizes the size of a struct laid out without packing.
+ *
+ * Branch and bound over the orderings of the fields. Fields with the same size, alignment and width are interchangeable,
+ * so the search branches over classes of fields instead of fields. A branch is pruned when its bytes plus the bytes of
+ * the fields still to place can't beat the best layout found. The search starts from the fields sorted by alignment.
+ *
+ * @param leaves Atomic fields of the struct with their size and alignment set.
+ * @param cancel When set, the search stops and returns its best layout so far.
+ * @param deadline Moment after which the search stops as if cancelled.
+ * @param on_improvement Called with each layout better than the previous ones.
+ * @param is_exhaustive Set to true if the search explored every ordering (the layout is optimal).
+ * @return the best layout found.
+ */
+struct_layout search_optimal_layout(const vector<field_slot>& leaves, const atomic<bool>& cancel,
+                                    chrono::steady_clock::time_point deadline,
+                                    const function<void(const struct_layout&)>& on_improvement, bool& is_exhaustive) {
+    vector<field_slot> classes;
+    vector<int> counts;
+    vector<vector<size_t>> members;
+    long long remaining = 0;
+
+    for (size_t i = 0; i < leaves.size(); i++) {
+        const field_slot& leaf = leaves[i];
+        size_t c = 0;
+        while (c < classes.size() && !(classes[c].size == leaf.size && classes[c].align == leaf.align && classes[c].bits == leaf.bits)) {
+            c++;
+        }
+        if (c == classes.size()) {
+            classes.push_back(leaf);
+            counts.push_back(0);
+            members.push_back({});
+        }
+        counts[c]++;
+        members[c].push_back(i);
+        remaining = checked_add(remaining, leaf.bits > 0 ? leaf.bits : checked_mul(leaf.size, 8));
+    }
+
+    vector<field_slot> sorted = leaves;
+    stable_sort(sorted.begin(), sorted.end(), [](const field_slot& a, const field_slot& b) { return a.align > b.align; });
+    struct_layout best = compute_layout(sorted, UNPACKED);
+    on_improvement(best);
+
+    // Busqueda en profundidad con pila explicita: un struct puede tener miles de campos
+    struct frame {
+        long long cursor;
+        long long left;
+        size_t next_class;
+    };
+
+    vector<size_t> order;
+    vector<frame> stack = {{0, remaining, 0}};
+    long long nodes = 0;
+    bool stopped = false;
+
+    auto pop_frame = [&]() {
+        stack.pop_back();
+        if (!order.empty()) {
+            counts[order.back()]++;
+            order.pop_back();
+        }
+    };
+
+    while (!stack.empty()) {
+        if (nodes++ % 1024 == 0 && (cancel.load() || chrono::steady_clock::now() > deadline)) {
+            stopped = true;
+            break;
+        }
+
+        frame& f = stack.back();
+
+        if (f.next_class == 0) {
+            if (f.left == 0) {
+                if ((f.cursor + 7) / 8 < best.size) {
+                    vector<size_t> next(classes.size(), 0);
+                    vector<field_slot> ordered;
+                    for (size_t c : order) {
+                        ordered.push_back(leaves[members[c][next[c]++]]);
+                    }
+                    best = compute_layout(ordered, UNPACKED);
+                    on_improvement(best);
+                }
+                pop_frame();
+                continue;
+            }
+            if ((f.cursor + f.left + 7) / 8 >= best.size) {
+                pop_frame();
+                continue;
+            }
+        }
+
+        size_t c = f.next_class;
+        while (c < classes.size() && counts[c] == 0) c++;
+        if (c == classes.size()) {
+            pop_frame();
+            continue;
+        }
+
+        f.next_class = c + 1;
+        long long width = classes[c].bits > 0 ? classes[c].bits : 8 * classes[c].size;
+        long long start = place_field_bits(classes[c], f.cursor, UNPACKED);
+        long long left = f.left - width;
+        counts[c]--;
+        order.push_back(c);
+        stack.push_back({start + width, left, 0});
+    }
+
+    is_exhaustive = !stopped;
+    return best;
+}
+
+/**
+ * Starts a race between all the layout strategies of a struct.
+ *
+ * The cheap strategies (no packing, packing, heuristics, opaque nested structs and tail padding reuse) and the optimal
+ * search run concurrently on the pool. The caller gets the results with wait_cheap_results and next_strategy_result as
+ * they arrive. The search publishes its best layout so far each time it improves and stops after budget, or earlier if
+ * the race is cancelled.
+ *
+ * @param at_struct Struct type.
+ * @param pool Thread pool running the strategies.
+ * @param budget Time limit of the search strategies.
+ * @return race state shared with the running strategies.
+ */
+shared_ptr<strategy_race> start_strategy_race(const atomic_struct& at_struct, thread_pool& pool, chrono::milliseconds budget = chrono::milliseconds(1000)) {
+    auto race = make_shared<strategy_race>();
+
+    vector<pair<string, LayoutStrategy>> cheap = {
+        {"no packing", UNPACKED},
+        {"packing", PACKED},
+        {"heuristics", HEURISTIC},
+        {"opaque nested", OPAQUE},
+        {"tail padding reuse", TAIL_REUSE},
+    };
+
+    vector<string> fields;
+    collect_struct_fields(at_struct, fields);
+    vector<field_slot> leaves;
+    for (const auto& field_name : fields) {
+        leaves.push_back(leaf_slot(field_name));
+    }
+
+    race->pending = cheap.size() + 1;
+    race->cheap_pending = cheap.size();
+
+    for (const auto& [name, strategy] : cheap) {
+        pool.submit([race, at_struct, name = name, strategy = strategy]() {
+            try {
+                strategy_result result;
+                result.strategy = name;
+                result.respects_alignment = strategy != PACKED;
+                result.layout = compute_struct_layout(at_struct, strategy);
+                publish_strategy_result(*race, result);
+            } catch (exception& e) {
+                fail_strategy(*race, true, e);
+            }
+        });
+    }
+
+    chrono::steady_clock::time_point deadline = race->started + budget;
+    pool.submit([race, leaves, deadline]() {
+        bool is_exhaustive = false;
+        auto on_improvement = [&race](const struct_layout& layout) {
+            strategy_result partial;
+            partial.strategy = "optimal search";
+            partial.layout = layout;
+            partial.is_cheap = false;
+            partial.is_final = false;
+            partial.is_exhaustive = false;
+            publish_strategy_result(*race, partial);
+        };
+
+        try {
+            strategy_result result;
+            result.strategy = "optimal search";
+            result.layout = search_optimal_layout(leaves, race->cancel, deadline, on_improvement, is_exhaustive);
+            result.is_cheap = false;
+            result.is_exhaustive = is_exhaustive;
+            publish_strategy_result(*race, result);
+        } catch (exception& e) {
+            fail_strategy(*race, false, e);
+        }
+    });
+
+    return race;
+}
+
+/**
+ * Waits until every cheap strategy of the race has finished.
+ *
+ * @param race Race state.
+ * @return the results available so far, including the cheap ones. They're removed from the queue.
+ */
+vector<strategy_result> wait_cheap_results(strategy_race& race) {
+    unique_lock<mutex> lock(race.m);
+    race.cv.wait(lock, [&race]() { return race.cheap_pending == 0; });
+    vector<strategy_result> results(race.ready.begin(), race.ready.end());
+    race.ready.clear();
+    return results;
+}
+
+/**
+ * Takes the next result of the race, waiting for it if needed.
+ *
+ * @param race Race state.
+ * @param result Filled with the next result.
+ * @return false when every strategy has finished and all their results were taken.
+ */
+bool next_strategy_result(strategy_race& race, strategy_result& result) {
+    unique_lock<mutex> lock(race.m);
+    race.cv.wait(lock, [&race]() { return !race.ready.empty() || race.pending == 0; });
+    if (race.ready.empty()) {
+        return false;
+    }
+    result = move(race.ready.front());
+    race.ready.pop_front();
+    return true;
+}
+
+/**
+ * Prints a result of the race.
+ *
+ * @param result Result of a strategy.
+ * @param out Stream where the output is written.
+ */
+void print_strategy_result(const strategy_result& result, ostream& out = cout) {
+    out << "  [" << result.elapsed_ms << " ms] " << result.strategy << (result.is_final ? "" : " (best so far)")
+         << (result.is_final && !result.is_exhaustive ? " (cut off)" : "")
+         << ": Bytes allocated: " << result.layout.size << " bytes, Bytes lost: " << result.layout.lost
+         << ", Stride: " << result.layout.stride << " bytes" << '\n';
+}
+
+/**
+ * Races every strategy of a struct, printing the cheap results first and then the rest as they arrive.
+ *
+ * The best strategy is the smallest of the ones that respect alignment. If a strategy failed, the results of the others are
+ * printed and then its error is thrown.
+ *
+ * @param at_struct Struct type.
+ * @param pool Thread pool running the strategies.
+ * @param budget Time limit of the search strategies.
+ * @param out Stream where the output is written. It's flushed after each late result so they show up as they arrive.
+ */
+void print_strategy_race(const atomic_struct& at_struct, thread_pool& pool, chrono::milliseconds budget = chrono::milliseconds(1000), ostream& out = cout) {
+    shared_ptr<strategy_race> race = start_strategy_race(at_struct, pool, budget);
+
+    out << "Struct Type: " << at_struct.name << '\n';
+    strategy_result best;
+    best.layout.size = LLONG_MAX;
+
+    for (const auto& result : wait_cheap_results(*race)) {
+        print_strategy_result(result, out);
+        if (result.is_final && result.respects_alignment && result.layout.size < best.layout.size) best = result;
+    }
+
+    strategy_result result;
+    while (next_strategy_result(*race, result)) {
+        print_strategy_result(result, out);
+        out.flush();
+        if (result.is_final && result.respects_alignment && result.layout.size < best.layout.size) best = result;
+    }
+
+    if (!race->failure.empty()) throw runtime_error(race->failure);
+    out << "Best strategy: " << best.strategy << " (" << best.layout.size << " bytes)" << '\n';
+}
+#endif
@@ -0,0 +1,290 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <shared_mutex>
+#include <list>
+#include <iomanip>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include "Functions.hpp"
+#include "Output.hpp"
+#include "Pipeline.hpp"
+#include "Interpreter.hpp"
+
+/**
+ * Lock of the type table and the target table while they're shared by the clients of a server.
+ *
+ * Commands that only read them run together under a shared lock. Commands that change them run alone. Readers only look up
+ * names that are already in the tables, which doesn't modify them.
+ */
+shared_mutex types_mutex;
+
+/**
+ * Set by the signal handler of the server to stop accepting clients.
+ */
+volatile sig_atomic_t server_interrupted = 0;
+
+/**
+ * Signal handler that stops the server.
+ */
+void interrupt_server(int) {
+    server_interrupted = 1;
+}
+
+/**
+ * Checks if a command changes the type table or the target table.
+ *
+ * @param code Code of the command.
+ * @return true if the command needs the table for itself.
+ */
+bool is_write_command(int code) {
+    switch (code) {
+        case 1:  // ATOMICO
+        case 2:  // STRUCT
+        case 3:  // UNION
+        case 7:  // OBJETIVO
+        case 9:  // BITFIELD
+        case 10: // VARIANTE
+        case 16: // COMMIT
+        case 18: // IMPORTAR
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Latency of the commands of a client, in microseconds.
+ *
+ * The latency of a command goes from the moment it's read from the socket until its output is written back. lock_wait is
+ * the part of it spent waiting for the type table.
+ */
+struct client_latency {
+    long long commands = 0;
+    double total_us = 0;
+    double max_us = 0;
+    double lock_wait_us = 0;
+};
+
+/**
+ * Executes a command holding the lock of the type table it needs.
+ *
+ * @param command Parsed command.
+ * @param s Session of the client.
+ * @param out Stream where the output is written.
+ * @param lock_wait_us Increased by the time waited for the lock, in microseconds.
+ * @return false if the command ends the session (SALIR).
+ */
+bool execute_shared_command(const parsed_command& command, session& s, ostream& out, double& lock_wait_us) {
+    auto started = chrono::steady_clock::now();
+    if (is_write_command(command.code)) {
+        unique_lock<shared_mutex> lock(types_mutex);
+        lock_wait_us += chrono::duration<double, micro>(chrono::steady_clock::now() - started).count();
+        return execute_command(command, s, out);
+    }
+    shared_lock<shared_mutex> lock(types_mutex);
+    lock_wait_us += chrono::duration<double, micro>(chrono::steady_clock::now() - started).count();
+    return execute_command(command, s, out);
+}
+
+/**
+ * Serves the command language to one client until it sends SALIR or disconnects.
+ *
+ * The client gets the same output as the interactive interpreter, prompts included, so each reply ends with "> ". Every
+ * command that arrived in the same read is executed before the output is written back, with a single write.
+ *
+ * @param fd Socket of the client.
+ * @param wal Log where the definitions are written, nullptr if they aren't logged.
+ * @return latency of the commands of the client.
+ */
+client_latency serve_client(int fd, journal* wal = nullptr) {
+    client_latency latency;
+    session s;
+    s.wal = wal;
+    fd_sink sink(fd);
+    ostream out(&sink);
+    out << "Enter command:" << '\n' << "> ";
+    out.flush();
+
+    string pending;
+    vector<char> buffer(1 << 16);
+    bool open = true;
+    while (open) {
+        ssize_t received = ::read(fd, buffer.data(), buffer.size());
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        auto arrived = chrono::steady_clock::now();
+        pending.append(buffer.data(), received);
+
+        // Solo se ejecutan las lineas completas, el resto espera a la siguiente lectura
+        size_t start = 0;
+        size_t end;
+        long long executed = 0;
+        while (open && (end = pending.find('\n', start)) != string::npos) {
+            parsed_command command = parse_command(pending.substr(start, end - start), AVAILABLE_COMMANDS);
+            start = end + 1;
+            open = execute_shared_command(command, s, out, latency.lock_wait_us);
+            if (open) out << "> ";
+            executed++;
+        }
+        pending.erase(0, start);
+        out.flush();
+
+        double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - arrived).count();
+        latency.commands += executed;
+        latency.total_us += elapsed * executed;
+        if (executed > 0) latency.max_us = max(latency.max_us, elapsed);
+    }
+    return latency;
+}
+
+/**
+ * Prints the latency of the commands of a client.
+ *
+ * @param id Number of the client.
+ * @param latency Latency of its commands.
+ * @param out Stream where the output is written.
+ */
+void print_client_latency(long long id, const client_latency& latency, ostream& out = cout) {
+    double average = latency.commands > 0 ? latency.total_us / latency.commands : 0;
+    double lock_wait = latency.commands > 0 ? latency.lock_wait_us / latency.commands : 0;
+    out << fixed << setprecision(1) << "Client " << id << " disconnected: " << latency.commands << " commands, latency avg "
+        << average << " us, max " << latency.max_us << " us, lock wait avg " << lock_wait << " us" << '\n';
+    out << defaultfloat;
+}
+
+/**
+ * Server that serves the command language on a Unix domain socket.
+ *
+ * Each client runs on its own thread with its own session (word size, snapshots and transaction), while the type table
+ * and the target table are shared by all of them under types_mutex. When a client leaves its latency is printed to the
+ * log.
+ */
+struct type_server {
+    /**
+     * Connection of a client. done is set by its thread when it finishes.
+     */
+    struct connection {
+        int fd;
+        thread worker;
+        atomic<bool> done{false};
+    };
+
+    string path;
+    ostream& log;
+    journal* wal;
+    int listen_fd = -1;
+    atomic<bool> stop{false};
+    mutex m; // Protege connections y el log
+    list<unique_ptr<connection>> connections;
+    long long next_id = 1;
+
+    /**
+     * Binds the socket. A socket file left at the path by a previous server is replaced.
+     *
+     * @param path Path of the socket.
+     * @param log Stream where the server reports its clients.
+     * @param wal Log where the definitions of every client are written, nullptr if they aren't logged.
+     */
+    type_server(const string& path, ostream& log, journal* wal = nullptr) : path(path), log(log), wal(wal) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+            throw runtime_error("Error: Invalid socket path '" + path + "'.");
+        }
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            throw runtime_error("Error: Can't create socket: " + string(strerror(errno)) + ".");
+        }
+        ::unlink(path.c_str());
+        if (::bind(listen_fd, (sockaddr*) &address, sizeof(address)) < 0 || ::listen(listen_fd, SOMAXCONN) < 0) {
+            string reason = strerror(errno);
+            ::close(listen_fd);
+            throw runtime_error("Error: Can't listen on '" + path + "': " + reason + ".");
+        }
+
+        // Un cliente que se desconecta no debe terminar el proceso al escribirle
+        signal(SIGPIPE, SIG_IGN);
+    }
+
+    ~type_server() {
+        shutdown_clients();
+        ::close(listen_fd);
+        ::unlink(path.c_str());
+    }
+
+    /**
+     * Accepts clients until stop is set or the process gets SIGINT or SIGTERM. Finished clients are joined as new ones
+     * arrive, so a long running server doesn't keep their threads.
+     */
+    void run() {
+        {
+            lock_guard<mutex> lock(m);
+            log << "Listening on " << path << '\n';
+            log.flush();
+        }
+
+        pollfd listener{listen_fd, POLLIN, 0};
+        while (!stop && !server_interrupted) {
+            reap_clients();
+            if (poll(&listener, 1, 100) <= 0 || !(listener.revents & POLLIN)) continue;
+
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) continue;
+
+            lock_guard<mutex> lock(m);
+            auto client = make_unique<connection>();
+            connection* c = client.get();
+            c->fd = fd;
+            long long id = next_id++;
+            c->worker = thread([this, c, id]() {
+                client_latency latency = serve_client(c->fd, wal);
+                {
+                    lock_guard<mutex> lock(m);
+                    print_client_latency(id, latency, log);
+                    log.flush();
+                }
+                c->done = true;
+            });
+            connections.push_back(move(client));
+        }
+        shutdown_clients();
+    }
+
+    /**
+     * Joins the threads of the clients that already left.
+     */
+    void reap_clients() {
+        lock_guard<mutex> lock(m);
+        for (auto it = connections.begin(); it != connections.end();) {
+            if ((*it)->done) {
+                (*it)->worker.join();
+                ::close((*it)->fd);
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /**
+     * Disconnects every client and waits for their threads.
+     */
+    void shutdown_clients() {
+        list<unique_ptr<connection>> remaining;
+        {
+            lock_guard<mutex> lock(m);
+            remaining.swap(connections);
+            for (auto& c : remaining) ::shutdown(c->fd, SHUT_RDWR);
+        }
+        for (auto& c : remaining) {
+            c->worker.join();
+            ::close(c->fd);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+/**
+ * Replacement of the global operator new and delete that counts the allocations of each thread for the statistics.
+ *
+ * It lives in its own translation unit because a program must define the replacement exactly once, and every form is
+ * replaced so that memory always goes back to the function matching the one that allocated it.
+ */
+
+atomic<bool> allocation_counting{false};
+thread_local long long thread_allocations = 0;
+
+/**
+ * Allocates memory like the default operator new: retries through the new handler and throws bad_alloc if there's none.
+ *
+ * @param size Bytes to allocate.
+ * @param align Alignment of the memory, 0 for the default one.
+ * @return the allocated memory.
+ */
+static void* counted_allocate(size_t size, size_t align) {
+    if (allocation_counting.load(memory_order_relaxed)) thread_allocations++;
+    if (size == 0) size = 1;
+    while (true) {
+        // aligned_alloc pide un tamano multiplo de la alineacion
+        void* memory = align == 0 ? malloc(size) : aligned_alloc(align, (size + align - 1) / align * align);
+        if (memory) return memory;
+        new_handler handler = get_new_handler();
+        if (!handler) throw bad_alloc();
+        handler();
+    }
+}
+
+static void* counted_allocate_nothrow(size_t size, size_t align) noexcept {
+    try {
+        return counted_allocate(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new(size_t size) { return counted_allocate(size, 0); }
+void* operator new[](size_t size) { return counted_allocate(size, 0); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return counted_allocate_nothrow(size, 0); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return counted_allocate_nothrow(size, 0); }
+void* operator new(size_t size, align_val_t align) { return counted_allocate(size, (size_t) align); }
+void* operator new[](size_t size, align_val_t align) { return counted_allocate(size, (size_t) align); }
+void* operator new(size_t size, align_val_t align, const nothrow_t&) noexcept { return counted_allocate_nothrow(size, (size_t) align); }
+void* operator new[](size_t size, align_val_t align, const nothrow_t&) noexcept { return counted_allocate_nothrow(size, (size_t) align); }
+
+// malloc y aligned_alloc se liberan igual, asi que todas las formas de delete son free
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+void operator delete(void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete(void* memory, align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, size_t, align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t, align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, align_val_t, const nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, align_val_t, const nothrow_t&) noexcept { free(memory); }
@@ -0,0 +1,160 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <iomanip>
+#include "Functions.hpp"
+
+// Definidos en Stats.cpp, que reemplaza operator new y delete: cada programa que incluye este archivo lo enlaza
+extern atomic<bool> allocation_counting;
+extern thread_local long long thread_allocations;
+
+/**
+ * Histogram of latencies in nanoseconds with the buckets of an HDR histogram.
+ *
+ * Values below SUB_BUCKETS have a bucket each. Above that, each power of two is split in SUB_BUCKETS / 2 buckets of the
+ * same width, so a bucket never spans more than 1/64 of its values and recording is a shift, with no search. The
+ * percentiles are the greatest value of the bucket they fall in, capped at the greatest value recorded.
+ */
+struct latency_histogram {
+    static const int SUB_BITS = 7;
+    static const long long SUB_BUCKETS = 1LL << SUB_BITS;
+    static const long long HALF = SUB_BUCKETS / 2;
+
+    array<long long, (64 - SUB_BITS + 2) * HALF> counts = {};
+    long long total = 0;
+    long long max_value = 0;
+    long double sum = 0;
+
+    static size_t bucket_of(long long value) {
+        if (value < SUB_BUCKETS) return (size_t) max(value, 0LL);
+        int shift = 63 - __builtin_clzll((unsigned long long) value) - SUB_BITS + 1;
+        return (size_t) (shift * HALF + (value >> shift));
+    }
+
+    static long long highest_in_bucket(size_t bucket) {
+        if ((long long) bucket < SUB_BUCKETS) return (long long) bucket;
+        int shift = (int) (bucket / HALF) - 1;
+        long long mantissa = (long long) bucket - shift * HALF;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void record(long long value) {
+        counts[bucket_of(value)]++;
+        total++;
+        max_value = max(max_value, value);
+        sum += value;
+    }
+
+    /**
+     * Value below which percentile percent of the recorded values fall.
+     *
+     * @param percentile Percentile, between 0 and 100.
+     * @return the value, or 0 if nothing was recorded.
+     */
+    long long value_at(double percentile) const {
+        if (total == 0) return 0;
+        long long rank = max(1LL, (long long) ceil(percentile / 100 * total));
+        long long seen = 0;
+        for (size_t bucket = 0; bucket < counts.size(); bucket++) {
+            seen += counts[bucket];
+            if (seen >= rank) return min(highest_in_bucket(bucket), max_value);
+        }
+        return max_value;
+    }
+};
+
+/**
+ * Statistics of one command verb: its latencies and the work counted while it ran, added over every call.
+ */
+struct command_stats {
+    latency_histogram latency;
+    long long lookups = 0;
+    long long allocations = 0;
+    long long layout_bytes = 0;
+};
+
+/**
+ * Statistics of every command verb, shared by the sessions of the process.
+ */
+struct stats_registry {
+    mutex m;
+    map<string, command_stats> by_command;
+};
+
+stats_registry command_stats_registry;
+
+/**
+ * Turns the statistics on or off. While they're off nothing is recorded and what was recorded is kept.
+ *
+ * @param enabled True to record the commands.
+ */
+void set_command_stats(bool enabled) {
+    command_counters_enabled.store(enabled);
+    allocation_counting.store(enabled);
+}
+
+/**
+ * Records the latency and the counters of a command from its creation to its destruction, if the statistics were on when
+ * it started. The counters are the ones of the thread of the command: work handed to other threads (CARRERA) isn't
+ * counted.
+ */
+struct command_timer {
+    bool active;
+    string verb;
+    command_counters before;
+    long long allocations_before = 0;
+    chrono::steady_clock::time_point started;
+
+    explicit command_timer(const string& verb) : active(command_counters_enabled.load(memory_order_relaxed)) {
+        if (!active) return;
+        this->verb = verb;
+        before = current_counters;
+        allocations_before = thread_allocations;
+        started = chrono::steady_clock::now();
+    }
+
+    ~command_timer() {
+        if (!active) return;
+        long long elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+        lock_guard<mutex> lock(command_stats_registry.m);
+        command_stats& stats = command_stats_registry.by_command[verb];
+        stats.latency.record(elapsed);
+        stats.lookups += current_counters.lookups - before.lookups;
+        stats.allocations += thread_allocations - allocations_before;
+        stats.layout_bytes += current_counters.layout_bytes - before.layout_bytes;
+    }
+};
+
+/**
+ * Prints the statistics of each command verb: number of calls, percentiles of its latency in microseconds and the mean
+ * lookups, allocations and layout bytes per call.
+ *
+ * @param out Stream where the output is written.
+ */
+void print_command_stats(ostream& out = cout) {
+    lock_guard<mutex> lock(command_stats_registry.m);
+    if (!command_counters_enabled.load() && command_stats_registry.by_command.empty()) {
+        out << "Statistics are off. Turn them on with STATS ON or start with --estadisticas." << '\n';
+        return;
+    }
+
+    auto micros = [](long long nanos) {
+        ostringstream text;
+        text << fixed << setprecision(1) << nanos / 1000.0;
+        return text.str();
+    };
+    out << "Command statistics (latencies in us):" << '\n';
+    for (const auto& [verb, stats] : command_stats_registry.by_command) {
+        long long calls = stats.latency.total;
+        out << "  " << verb << ": " << calls << (calls == 1 ? " call" : " calls")
+            << ", p50 " << micros(stats.latency.value_at(50)) << ", p90 " << micros(stats.latency.value_at(90))
+            << ", p99 " << micros(stats.latency.value_at(99)) << ", p99.9 " << micros(stats.latency.value_at(99.9))
+            << ", max " << micros(stats.latency.max_value)
+            << ", per call: " << stats.lookups / calls << " lookups, " << stats.allocations / calls << " allocations, "
+            << stats.layout_bytes / calls << " layout bytes" << '\n';
+    }
+}
+#endif
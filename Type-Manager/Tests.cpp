@@ -1,371 +1,1544 @@
-#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
-#include "doctest.h"
-#include "Functions.hpp"
-
-using namespace std;
-
-void setup_basic_atomics() {
-    types_arr.clear();
-    push_atomic(types_arr, "char", 1, 1);
-    push_atomic(types_arr, "short", 2, 2);
-    push_atomic(types_arr, "int", 4, 4);
-    push_atomic(types_arr, "long", 8, 8);
-    push_atomic(types_arr, "float", 4, 4);
-    push_atomic(types_arr, "double", 8, 8);
-    push_atomic(types_arr, "bool", 1, 2);
-}
-
-TEST_CASE("push_atomic crea tipos atomicos correctos") {
-    types_arr.clear();
-    push_atomic(types_arr, "mychar", 1, 1);
-    REQUIRE(types_arr.count("mychar") == 1);
-    REQUIRE(types_arr["mychar"].kind == ATOMIC);
-    const aatomic &a = get<aatomic>(types_arr["mychar"].at);
-    CHECK(a.name == "mychar");
-    CHECK(a.size == 1);
-    CHECK(a.align == 1);
-}
-
-TEST_CASE("push_struct crea tipos structs planos correctos") {
-    types_arr.clear();
-    setup_basic_atomics();
-    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
-    atomic_struct s = get<atomic_struct>(types_arr["MyStruct1"].at);
-    CHECK(s.name == "MyStruct1");
-    CHECK(s.size == 19);
-    CHECK(s.align == 4);
-}
-
-TEST_CASE("push_struct crea tipos structs compuestos correctos") {
-    types_arr.clear();
-    setup_basic_atomics();
-    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
-    push_struct(types_arr, "MyStruct2", {"MyStruct1", "bool", "char"});
-    atomic_struct s = get<atomic_struct>(types_arr["MyStruct2"].at);
-    CHECK(s.name == "MyStruct2");
-    CHECK(s.size == 21);
-    CHECK(s.align == 4);
-}
-
-TEST_CASE("push_struct impide tipos recursivos") {
-    types_arr.clear();
-    setup_basic_atomics();
-    CHECK_THROWS_AS(
-        push_struct(types_arr, "MyStruct1",
-            {"int", "char", "char", "int", "double", "bool", "MyStruct1"}
-        ),
-        std::runtime_error
-    );
-}
-
-TEST_CASE("push_union crea tipos union planos correctos") {
-    types_arr.clear();
-    setup_basic_atomics();
-    push_union(types_arr, "MyUnion1", {"int", "char", "char", "int", "double", "bool"});
-    atomic_union s = get<atomic_union>(types_arr["MyUnion1"].at);
-    CHECK(s.name == "MyUnion1");
-    CHECK(s.size == 8);
-    CHECK(s.align == 8);
-}
-
-TEST_CASE("push_union crea tipos union compuestos correctos") {
-    types_arr.clear();
-    setup_basic_atomics();
-    push_union(types_arr, "MyUnion1", {"int", "char", "char", "int", "double", "bool"});
-    push_union(types_arr, "MyUnion2", {"MyUnion1", "bool", "char"});
-    atomic_union s = get<atomic_union>(types_arr["MyUnion2"].at);
-    CHECK(s.name == "MyUnion2");
-    CHECK(s.size == 8);
-    CHECK(s.align == 8);
-}
-
-TEST_CASE("push_union impide tipos recursivos") {
-    types_arr.clear();
-    setup_basic_atomics();
-    CHECK_THROWS_AS(
-        push_union(types_arr, "MyUnion1",
-            {"int", "char", "char", "int", "double", "bool", "MyUnion1"}
-        ),
-        std::runtime_error
-    );
-}
-
-TEST_CASE("push_struct puede crear strucs con unions anidados correctamente") {
-    types_arr.clear();
-    setup_basic_atomics();
-    push_union(types_arr, "MyUnion1", {"int", "char", "char", "int", "double", "bool"});
-    push_struct(types_arr, "MyStruct1", {"MyUnion1"});
-    atomic_struct s = get<atomic_struct>(types_arr["MyStruct1"].at);
-    CHECK(s.name == "MyStruct1");
-    CHECK(s.size == 8);
-    CHECK(s.align == 8);
-}
-
-TEST_CASE("push_union puede crear unions con structs anidados correctamente") {
-    types_arr.clear();
-    setup_basic_atomics();
-    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
-    push_union(types_arr, "MyUnion1", {"MyStruct1"});
-    atomic_union s = get<atomic_union>(types_arr["MyUnion1"].at);
-    CHECK(s.name == "MyUnion1");
-    CHECK(s.size == 19);
-    CHECK(s.align == 4);
-}
-
-TEST_CASE("push_struct y calc_size/align_struct funcionan") {
-    setup_basic_atomics();
-
-    // crea estructura simple: S1 { int, char, short }
-    vector<string> fields = {"int", "char", "short"};
-    push_struct(types_arr, "S1", fields);
-
-    REQUIRE(types_arr.count("S1") == 1);
-    CHECK(types_arr["S1"].kind == STRUCT);
-
-    const atomic_struct &s = get<atomic_struct>(types_arr["S1"].at);
-
-    // calc_size_struct debe dar suma de tamaños
-    int expected_size = get<aatomic>(types_arr["int"].at).size
-                      + get<aatomic>(types_arr["char"].at).size
-                      + get<aatomic>(types_arr["short"].at).size;
-    CHECK(calc_size_struct(s) == expected_size);
-
-    // calc_align_struct, según tu impl, toma la alineación del primer campo
-    CHECK(calc_align_struct(s) == get<aatomic>(types_arr["int"].at).align);
-}
-
-TEST_CASE("push_union y calc_size/align_union funcionan") {
-    setup_basic_atomics();
-
-    // Union U1 { int, double, short } -> size = max(4,8,2)=8 ; align = lcm(4,8,2)=8
-    vector<string> ufields = {"int", "double", "short"};
-    push_union(types_arr, "U1", ufields);
-
-    REQUIRE(types_arr.count("U1") == 1);
-    CHECK(types_arr["U1"].kind == UNION);
-
-    const atomic_union &u = get<atomic_union>(types_arr["U1"].at);
-
-    CHECK(calc_size_union(u) == 8);
-    CHECK(calc_align_union(u) == 8);
-}
-
-TEST_CASE("collect_struct_fields aplana structs anidados") {
-    setup_basic_atomics();
-
-    // Define inner struct I { char, short }
-    push_struct(types_arr, "I", vector<string>{"char", "short"});
-    // Define outer struct O { int, I, char }
-    push_struct(types_arr, "O", vector<string>{"int", "I", "char"});
-
-    const atomic_struct &outer = get<atomic_struct>(types_arr["O"].at);
-
-    vector<string> acc;
-    collect_struct_fields(outer, acc);
-
-    // debe contener los atomic que aparecen al final: int, char, short, char (I's fields inserted in order)
-    // collect_struct_fields recorre I y agrega su fields; orden esperado: int, char, short, char
-    REQUIRE(!acc.empty());
-    CHECK(acc.front() == "int");
-    CHECK(std::find(acc.begin(), acc.end(), "short") != acc.end());
-}
-
-TEST_CASE("sort_struct_fields_by_alignment ordena tipos simples por align descendente") {
-    setup_basic_atomics();
-    // crea 3 atomics con diferentes align (ya definidos arriba)
-    // struct test { char, int, short } -> alins: 1,4,2 => orden esperado: int, short, char
-    push_struct(types_arr, "T", vector<string>{"char","int","short"});
-    const atomic_struct &t = get<atomic_struct>(types_arr["T"].at);
-
-    vector<string> out_init;
-    vector<string> sorted = sort_struct_fields_by_alignment(t, out_init);
-
-    REQUIRE(sorted.size() == 3);
-    CHECK(sorted[0] == "int");
-    CHECK(sorted[1] == "short");
-    CHECK(sorted[2] == "char");
-}
-
-TEST_CASE("sort_struct_fields_by_alignment ordena tipos compuestos por align descendente") {
-    setup_basic_atomics();
-    // crea 3 atomics con diferentes align (ya definidos arriba)
-    // struct test { char, int, short } -> alins: 1,4,2 => orden esperado: int, short, char
-    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
-    push_union(types_arr, "MyUnion1", {"int", "double"});
-    push_struct(types_arr, "T", vector<string>{"char","MyStruct1","MyUnion1"});
-    const atomic_struct &t = get<atomic_struct>(types_arr["T"].at);
-
-    vector<string> out_init;
-    vector<string> sorted = sort_struct_fields_by_alignment(t, out_init);
-
-    REQUIRE(sorted.size() == 8);
-    CHECK(sorted[0] == "double");
-    CHECK(sorted[1] == "MyUnion1");
-    CHECK(sorted[2] == "int");
-    CHECK(sorted[3] == "int");
-    CHECK(sorted[4] == "bool");
-    CHECK(sorted[5] == "char");
-    CHECK(sorted[6] == "char");
-    CHECK(sorted[7] == "char");
-}
-
-TEST_CASE("split tokeniza correctamente") {
-    string s = "STRUCT MyStruct int char";
-    vector<string> toks = split(s);
-    REQUIRE(toks.size() == 4);
-    CHECK(toks[0] == "STRUCT");
-    CHECK(toks[1] == "MyStruct");
-    CHECK(toks[2] == "int");
-    CHECK(toks[3] == "char");
-}
-
-TEST_CASE("is_integer reconoce enteros válidos e inválidos") {
-    CHECK(is_integer("123") == true);
-    CHECK(is_integer("-42") == true);
-    CHECK(is_integer("12abc") == false);
-    CHECK(is_integer("") == false);
-}
-
-TEST_CASE("print_mem_layout_diagram no crashea y formatea índices") {
-    vector<int> mem = {1,0,1,1, 0,0,1,1};
-    // Solo llamamos para verificar que imprime sin fallas
-    print_mem_layout_diagram(mem, 4);
-    CHECK(true); // si llegamos acá está ok
-}
-
-
-TEST_CASE("print_atomic y print_union no crashean") {
-    aatomic a{"mydouble", 8, 8};
-    print_atomic(a, 4);
-
-    atomic_union u{"Utest", {"int","char"}, 4, 4};
-    print_union(u, 4);
-
-    CHECK(true);
-}
-
-TEST_CASE("print_struct_w_packing funciona con tipos simples") {
-    setup_basic_atomics();
-    push_struct(types_arr, "S2", vector<string>{"char","int","short"});
-    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
-
-    // packing y no-packing: llamamos para que no crasheen
-    print_struct_w_packing(s2, 4);
-
-    CHECK(true);
-}
-
-TEST_CASE("print_struct_wt_packing funciona con tipos simples") {
-    setup_basic_atomics();
-    push_struct(types_arr, "S2", vector<string>{"char","int","short"});
-    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
-
-    // packing y no-packing: llamamos para que no crasheen
-    print_struct_wt_packing(s2, 4);
-
-    CHECK(true);
-}
-
-TEST_CASE("print_struct_heuristics funciona con tipos simples") {
-    setup_basic_atomics();
-    push_struct(types_arr, "S2", vector<string>{"char","int","short"});
-    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
-
-    // packing y no-packing: llamamos para que no crasheen
-    print_struct_heuristics(s2, 4);
-
-    CHECK(true);
-}
-
-TEST_CASE("print_struct_w_packing funciona con tipos compuestos") {
-    setup_basic_atomics();
-    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
-    push_union(types_arr, "MyUnion1", {"int", "double"});
-    push_struct(types_arr, "S2", vector<string>{"char","MyStruct1","MyUnion1"});
-    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
-
-    // packing y no-packing: llamamos para que no crasheen
-    print_struct_w_packing(s2, 4);
-
-    CHECK(true);
-}
-
-TEST_CASE("print_struct_wt_packing funciona con tipos compuestos") {
-    setup_basic_atomics();
-    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
-    push_union(types_arr, "MyUnion1", {"int", "double"});
-    push_struct(types_arr, "S2", vector<string>{"char","MyStruct1","MyUnion1"});
-    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
-
-    // packing y no-packing: llamamos para que no crasheen
-    print_struct_wt_packing(s2, 4);
-
-    CHECK(true);
-}
-
-TEST_CASE("print_struct_heuristics funciona con tipos compuestos") {
-    setup_basic_atomics();
-    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
-    push_union(types_arr, "MyUnion1", {"int", "double"});
-    push_struct(types_arr, "S2", vector<string>{"char","MyStruct1","MyUnion1"});
-    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
-
-    // packing y no-packing: llamamos para que no crasheen
-
-    print_struct_heuristics(s2, 4);
-
-    CHECK(true);
-}
-
-TEST_CASE("print_struct_heuristics_aux retorna conteo consistente") {
-    setup_basic_atomics();
-    vector<string> fields = {"int","char"};
-    vector<int> mem_arr;
-    long unsigned int mem_ptr = 0;
-    vector<int> bytes = {0,0,0};
-    vector<int> res = print_struct_heuristics_aux(fields, mem_arr, mem_ptr, bytes);
-    // bytes[2] debe ser suma de usados y lost (>= used)
-    CHECK(res[2] >= res[0]);
-}
-
-TEST_CASE("calc_size/align para structs y unions compuestos") {
-    setup_basic_atomics();
-    // crea struct nested
-    push_struct(types_arr, "Inner", {"short","char"});
-    push_union(types_arr, "MyUnion", {"Inner","int"});
-    const atomic_struct &inner = get<atomic_struct>(types_arr["Inner"].at);
-    const atomic_union &u = get<atomic_union>(types_arr["MyUnion"].at);
-
-    CHECK(calc_size_struct(inner) == 3); // short(2)+char(1)
-    CHECK(calc_align_union(u) == lcm(get<atomic_struct>(types_arr["Inner"].at).align, get<aatomic>(types_arr["int"].at).align));
-}
-
-TEST_CASE("push_struct detecta recursividad simple") {
-    setup_basic_atomics();
-    // intento crear struct recursivo
-    try {
-        push_struct(types_arr, "R", {"R"});
-        // si no lanza excepción --> falla
-        FAIL("Expected runtime_error for recursive declaration");
-    } catch (const runtime_error& e) {
-        CHECK(string(e.what()).find("Recursive declaration") != string::npos);
-    }
-}
-
-TEST_CASE("push_union detecta recursividad simple") {
-    setup_basic_atomics();
-    try {
-        push_union(types_arr, "U", {"U"});
-        FAIL("Expected runtime_error for recursive declaration");
-    } catch (const runtime_error& e) {
-        CHECK(string(e.what()).find("Recursive declaration") != string::npos);
-    }
-}
-
-TEST_CASE("print_types itera e imprime sin fallar") {
-    setup_basic_atomics();
-    push_struct(types_arr, "StructForPrint", {"int","char"});
-    push_union(types_arr, "UnionForPrint", {"int","short"});
-    print_types();
-    CHECK(true);
-}
\ No newline at end of file
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "Functions.hpp"
+#include "Racing.hpp"
+#include "Export.hpp"
+#include "Diff.hpp"
+#include "Output.hpp"
+#include "Pipeline.hpp"
+#include "Transaction.hpp"
+#include "Interpreter.hpp"
+#include "Server.hpp"
+#include "Journal.hpp"
+#include "Validation.hpp"
+#include "Bench.hpp"
+#include <fcntl.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+void setup_basic_atomics() {
+    types_arr.clear();
+    push_atomic(types_arr, "char", 1, 1);
+    push_atomic(types_arr, "short", 2, 2);
+    push_atomic(types_arr, "int", 4, 4);
+    push_atomic(types_arr, "long", 8, 8);
+    push_atomic(types_arr, "float", 4, 4);
+    push_atomic(types_arr, "double", 8, 8);
+    push_atomic(types_arr, "bool", 1, 2);
+}
+
+TEST_CASE("push_atomic crea tipos atomicos correctos") {
+    types_arr.clear();
+    push_atomic(types_arr, "mychar", 1, 1);
+    REQUIRE(types_arr.count("mychar") == 1);
+    REQUIRE(types_arr["mychar"].kind == ATOMIC);
+    const aatomic &a = get<aatomic>(types_arr["mychar"].at);
+    CHECK(a.name == "mychar");
+    CHECK(a.size == 1);
+    CHECK(a.align == 1);
+}
+
+TEST_CASE("push_struct crea tipos structs planos correctos") {
+    types_arr.clear();
+    setup_basic_atomics();
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    atomic_struct s = get<atomic_struct>(types_arr["MyStruct1"].at);
+    CHECK(s.name == "MyStruct1");
+    CHECK(s.size == 32);
+    CHECK(s.align == 8);
+}
+
+TEST_CASE("push_struct crea tipos structs compuestos correctos") {
+    types_arr.clear();
+    setup_basic_atomics();
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    push_struct(types_arr, "MyStruct2", {"MyStruct1", "bool", "char"});
+    atomic_struct s = get<atomic_struct>(types_arr["MyStruct2"].at);
+    CHECK(s.name == "MyStruct2");
+    CHECK(s.size == 40);
+    CHECK(s.align == 8);
+}
+
+TEST_CASE("push_struct impide tipos recursivos") {
+    types_arr.clear();
+    setup_basic_atomics();
+    CHECK_THROWS_AS(
+        push_struct(types_arr, "MyStruct1",
+            {"int", "char", "char", "int", "double", "bool", "MyStruct1"}
+        ),
+        std::runtime_error
+    );
+}
+
+TEST_CASE("push_union crea tipos union planos correctos") {
+    types_arr.clear();
+    setup_basic_atomics();
+    push_union(types_arr, "MyUnion1", {"int", "char", "char", "int", "double", "bool"});
+    atomic_union s = get<atomic_union>(types_arr["MyUnion1"].at);
+    CHECK(s.name == "MyUnion1");
+    CHECK(s.size == 8);
+    CHECK(s.align == 8);
+}
+
+TEST_CASE("push_union crea tipos union compuestos correctos") {
+    types_arr.clear();
+    setup_basic_atomics();
+    push_union(types_arr, "MyUnion1", {"int", "char", "char", "int", "double", "bool"});
+    push_union(types_arr, "MyUnion2", {"MyUnion1", "bool", "char"});
+    atomic_union s = get<atomic_union>(types_arr["MyUnion2"].at);
+    CHECK(s.name == "MyUnion2");
+    CHECK(s.size == 8);
+    CHECK(s.align == 8);
+}
+
+TEST_CASE("push_union impide tipos recursivos") {
+    types_arr.clear();
+    setup_basic_atomics();
+    CHECK_THROWS_AS(
+        push_union(types_arr, "MyUnion1",
+            {"int", "char", "char", "int", "double", "bool", "MyUnion1"}
+        ),
+        std::runtime_error
+    );
+}
+
+TEST_CASE("push_struct puede crear strucs con unions anidados correctamente") {
+    types_arr.clear();
+    setup_basic_atomics();
+    push_union(types_arr, "MyUnion1", {"int", "char", "char", "int", "double", "bool"});
+    push_struct(types_arr, "MyStruct1", {"MyUnion1"});
+    atomic_struct s = get<atomic_struct>(types_arr["MyStruct1"].at);
+    CHECK(s.name == "MyStruct1");
+    CHECK(s.size == 8);
+    CHECK(s.align == 8);
+}
+
+TEST_CASE("push_union puede crear unions con structs anidados correctamente") {
+    types_arr.clear();
+    setup_basic_atomics();
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    push_union(types_arr, "MyUnion1", {"MyStruct1"});
+    atomic_union s = get<atomic_union>(types_arr["MyUnion1"].at);
+    CHECK(s.name == "MyUnion1");
+    CHECK(s.size == 32);
+    CHECK(s.align == 8);
+}
+
+TEST_CASE("push_struct y calc_size/align_struct funcionan") {
+    setup_basic_atomics();
+
+    // crea estructura simple: S1 { int, char, short }
+    vector<string> fields = {"int", "char", "short"};
+    push_struct(types_arr, "S1", fields);
+
+    REQUIRE(types_arr.count("S1") == 1);
+    CHECK(types_arr["S1"].kind == STRUCT);
+
+    const atomic_struct &s = get<atomic_struct>(types_arr["S1"].at);
+
+    // calc_size_struct da el sizeof de C: int en 0, char en 4, short en 6
+    CHECK(calc_size_struct(s) == 8);
+
+    // calc_align_struct toma la mayor alineacion de los campos
+    CHECK(calc_align_struct(s) == get<aatomic>(types_arr["int"].at).align);
+    CHECK(s.size == 8);
+    CHECK(s.align == 4);
+}
+
+TEST_CASE("push_union y calc_size/align_union funcionan") {
+    setup_basic_atomics();
+
+    // Union U1 { int, double, short } -> size = max(4,8,2)=8 ; align = lcm(4,8,2)=8
+    vector<string> ufields = {"int", "double", "short"};
+    push_union(types_arr, "U1", ufields);
+
+    REQUIRE(types_arr.count("U1") == 1);
+    CHECK(types_arr["U1"].kind == UNION);
+
+    const atomic_union &u = get<atomic_union>(types_arr["U1"].at);
+
+    CHECK(calc_size_union(u) == 8);
+    CHECK(calc_align_union(u) == 8);
+}
+
+TEST_CASE("collect_struct_fields aplana structs anidados") {
+    setup_basic_atomics();
+
+    // Define inner struct I { char, short }
+    push_struct(types_arr, "I", vector<string>{"char", "short"});
+    // Define outer struct O { int, I, char }
+    push_struct(types_arr, "O", vector<string>{"int", "I", "char"});
+
+    const atomic_struct &outer = get<atomic_struct>(types_arr["O"].at);
+
+    vector<string> acc;
+    collect_struct_fields(outer, acc);
+
+    // debe contener los atomic que aparecen al final: int, char, short, char (I's fields inserted in order)
+    // collect_struct_fields recorre I y agrega su fields; orden esperado: int, char, short, char
+    REQUIRE(!acc.empty());
+    CHECK(acc.front() == "int");
+    CHECK(std::find(acc.begin(), acc.end(), "short") != acc.end());
+}
+
+TEST_CASE("sort_struct_fields_by_alignment ordena tipos simples por align descendente") {
+    setup_basic_atomics();
+    // crea 3 atomics con diferentes align (ya definidos arriba)
+    // struct test { char, int, short } -> alins: 1,4,2 => orden esperado: int, short, char
+    push_struct(types_arr, "T", vector<string>{"char","int","short"});
+    const atomic_struct &t = get<atomic_struct>(types_arr["T"].at);
+
+    vector<string> out_init;
+    vector<string> sorted = sort_struct_fields_by_alignment(t, out_init);
+
+    REQUIRE(sorted.size() == 3);
+    CHECK(sorted[0] == "int");
+    CHECK(sorted[1] == "short");
+    CHECK(sorted[2] == "char");
+}
+
+TEST_CASE("sort_struct_fields_by_alignment ordena tipos compuestos por align descendente") {
+    setup_basic_atomics();
+    // crea 3 atomics con diferentes align (ya definidos arriba)
+    // struct test { char, int, short } -> alins: 1,4,2 => orden esperado: int, short, char
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    push_union(types_arr, "MyUnion1", {"int", "double"});
+    push_struct(types_arr, "T", vector<string>{"char","MyStruct1","MyUnion1"});
+    const atomic_struct &t = get<atomic_struct>(types_arr["T"].at);
+
+    vector<string> out_init;
+    vector<string> sorted = sort_struct_fields_by_alignment(t, out_init);
+
+    REQUIRE(sorted.size() == 8);
+    CHECK(sorted[0] == "double");
+    CHECK(sorted[1] == "MyUnion1");
+    CHECK(sorted[2] == "int");
+    CHECK(sorted[3] == "int");
+    CHECK(sorted[4] == "bool");
+    CHECK(sorted[5] == "char");
+    CHECK(sorted[6] == "char");
+    CHECK(sorted[7] == "char");
+}
+
+TEST_CASE("split tokeniza correctamente") {
+    string s = "STRUCT MyStruct int char";
+    vector<string> toks = split(s);
+    REQUIRE(toks.size() == 4);
+    CHECK(toks[0] == "STRUCT");
+    CHECK(toks[1] == "MyStruct");
+    CHECK(toks[2] == "int");
+    CHECK(toks[3] == "char");
+}
+
+TEST_CASE("is_integer reconoce enteros válidos e inválidos") {
+    CHECK(is_integer("123") == true);
+    CHECK(is_integer("-42") == true);
+    CHECK(is_integer("12abc") == false);
+    CHECK(is_integer("") == false);
+}
+
+TEST_CASE("print_mem_layout_diagram no crashea y formatea índices") {
+    vector<int> mem = {1,0,1,1, 0,0,1,1};
+    // Solo llamamos para verificar que imprime sin fallas
+    print_mem_layout_diagram(mem, 4);
+    CHECK(true); // si llegamos acá está ok
+}
+
+
+TEST_CASE("print_atomic y print_union no crashean") {
+    aatomic a{"mydouble", 8, 8};
+    print_atomic(a, 4);
+
+    atomic_union u{"Utest", {"int","char"}, 4, 4};
+    print_union(u, 4);
+
+    CHECK(true);
+}
+
+TEST_CASE("print_struct_w_packing funciona con tipos simples") {
+    setup_basic_atomics();
+    push_struct(types_arr, "S2", vector<string>{"char","int","short"});
+    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
+
+    // packing y no-packing: llamamos para que no crasheen
+    print_struct_w_packing(s2, 4);
+
+    CHECK(true);
+}
+
+TEST_CASE("print_struct_wt_packing funciona con tipos simples") {
+    setup_basic_atomics();
+    push_struct(types_arr, "S2", vector<string>{"char","int","short"});
+    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
+
+    // packing y no-packing: llamamos para que no crasheen
+    print_struct_wt_packing(s2, 4);
+
+    CHECK(true);
+}
+
+TEST_CASE("print_struct_heuristics funciona con tipos simples") {
+    setup_basic_atomics();
+    push_struct(types_arr, "S2", vector<string>{"char","int","short"});
+    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
+
+    // packing y no-packing: llamamos para que no crasheen
+    print_struct_heuristics(s2, 4);
+
+    CHECK(true);
+}
+
+TEST_CASE("print_struct_w_packing funciona con tipos compuestos") {
+    setup_basic_atomics();
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    push_union(types_arr, "MyUnion1", {"int", "double"});
+    push_struct(types_arr, "S2", vector<string>{"char","MyStruct1","MyUnion1"});
+    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
+
+    // packing y no-packing: llamamos para que no crasheen
+    print_struct_w_packing(s2, 4);
+
+    CHECK(true);
+}
+
+TEST_CASE("print_struct_wt_packing funciona con tipos compuestos") {
+    setup_basic_atomics();
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    push_union(types_arr, "MyUnion1", {"int", "double"});
+    push_struct(types_arr, "S2", vector<string>{"char","MyStruct1","MyUnion1"});
+    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
+
+    // packing y no-packing: llamamos para que no crasheen
+    print_struct_wt_packing(s2, 4);
+
+    CHECK(true);
+}
+
+TEST_CASE("print_struct_heuristics funciona con tipos compuestos") {
+    setup_basic_atomics();
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    push_union(types_arr, "MyUnion1", {"int", "double"});
+    push_struct(types_arr, "S2", vector<string>{"char","MyStruct1","MyUnion1"});
+    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
+
+    // packing y no-packing: llamamos para que no crasheen
+
+    print_struct_heuristics(s2, 4);
+
+    CHECK(true);
+}
+
+TEST_CASE("calc_size/align para structs y unions compuestos") {
+    setup_basic_atomics();
+    // crea struct nested
+    push_struct(types_arr, "Inner", {"short","char"});
+    push_union(types_arr, "MyUnion", {"Inner","int"});
+    const atomic_struct &inner = get<atomic_struct>(types_arr["Inner"].at);
+    const atomic_union &u = get<atomic_union>(types_arr["MyUnion"].at);
+
+    CHECK(calc_size_struct(inner) == 4); // short(2)+char(1) y relleno hasta la alineacion
+    CHECK(calc_align_union(u) == lcm(get<atomic_struct>(types_arr["Inner"].at).align, get<aatomic>(types_arr["int"].at).align));
+}
+
+TEST_CASE("push_struct detecta recursividad simple") {
+    setup_basic_atomics();
+    // intento crear struct recursivo
+    try {
+        push_struct(types_arr, "R", {"R"});
+        // si no lanza excepción --> falla
+        FAIL("Expected runtime_error for recursive declaration");
+    } catch (const runtime_error& e) {
+        CHECK(string(e.what()).find("Recursive declaration") != string::npos);
+    }
+}
+
+TEST_CASE("push_union detecta recursividad simple") {
+    setup_basic_atomics();
+    try {
+        push_union(types_arr, "U", {"U"});
+        FAIL("Expected runtime_error for recursive declaration");
+    } catch (const runtime_error& e) {
+        CHECK(string(e.what()).find("Recursive declaration") != string::npos);
+    }
+}
+
+TEST_CASE("print_types itera e imprime sin fallar") {
+    setup_basic_atomics();
+    push_struct(types_arr, "StructForPrint", {"int","char"});
+    push_union(types_arr, "UnionForPrint", {"int","short"});
+    print_types();
+    CHECK(true);
+}
+
+TEST_CASE("compute_layout coincide con las estrategias de print_struct_*") {
+    setup_basic_atomics();
+    push_struct(types_arr, "MyStruct1", {"int", "char", "char", "int", "double", "bool"});
+    push_union(types_arr, "MyUnion1", {"int", "double"});
+    push_struct(types_arr, "S2", vector<string>{"char","MyStruct1","MyUnion1"});
+    const atomic_struct &s2 = get<atomic_struct>(types_arr["S2"].at);
+
+    target_pass pass = make_target_pass(4);
+    vector<target_layout> layouts = layout_all_targets(pass, "S2");
+    REQUIRE(layouts.size() == 1);
+
+    struct_layout unpacked = compute_struct_layout(s2, UNPACKED);
+    CHECK(layouts[0].unpacked.size == unpacked.size);
+    CHECK(layouts[0].unpacked.lost == unpacked.lost);
+
+    struct_layout heuristic = compute_struct_layout(s2, HEURISTIC);
+    CHECK(layouts[0].heuristic.size == heuristic.size);
+    CHECK(layouts[0].heuristic.lost == heuristic.lost);
+
+    CHECK(layouts[0].packed.size == 28); // Suma de las hojas: char, las seis de MyStruct1 y la union
+    CHECK(layouts[0].packed.lost == 0);
+}
+
+TEST_CASE("layout_all_targets aplica overrides y tope de alineacion por objetivo") {
+    setup_basic_atomics();
+    targets_arr.clear();
+    push_struct(types_arr, "S", vector<string>{"char", "long"});
+    push_target(targets_arr, "arm32", 4, 4, {{"long", {4, 4}}});
+    push_target(targets_arr, "wire", 1, 1, {});
+
+    target_pass pass = make_target_pass(4);
+    vector<target_layout> layouts = layout_all_targets(pass, "S");
+    REQUIRE(layouts.size() == 3);
+
+    CHECK(layouts[0].target == "default");
+    CHECK(layouts[0].unpacked.size == 16);
+    CHECK(layouts[1].target == "arm32");
+    CHECK(layouts[1].size == 8);
+    CHECK(layouts[1].align == 4);
+    CHECK(layouts[1].unpacked.size == 8);
+    CHECK(layouts[2].target == "wire");
+    CHECK(layouts[2].size == 9);
+    CHECK(layouts[2].align == 1);
+    CHECK(layouts[2].unpacked.size == 9);
+    CHECK(layouts[2].unpacked.lost == 0);
+
+    // Cada tipo del grafo se resuelve una sola vez para todos los objetivos
+    CHECK(pass.metrics.size() == 3);
+    targets_arr.clear();
+}
+
+TEST_CASE("el objetivo por defecto da el tamano y la alineacion de la tabla") {
+    types_arr.clear();
+    targets_arr.clear();
+    push_atomic(types_arr, "c", 1, 1);
+    push_atomic(types_arr, "i", 4, 4);
+    push_struct(types_arr, "s", vector<string>{"c", "i", "c"});
+    push_union(types_arr, "u", vector<string>{"c", "s"});
+    push_bitfield(types_arr, "i:3", 3, "i");
+    push_struct(types_arr, "b", vector<string>{"c", "i:3", "i:3", "s"});
+    push_variant(types_arr, "v", "c", vector<string>{"c", "u"});
+    push_struct(types_arr, "s@1", vector<string>{"c", "i", "c"}, 1);
+    push_struct(types_arr, "p", vector<string>{"c", "s@1"});
+
+    target_pass pass = make_target_pass(4);
+    for (const auto& [name, type] : types_arr) {
+        vector<target_layout> layouts = layout_all_targets(pass, name);
+        REQUIRE(layouts.size() == 1);
+        CHECK(pair<long long, int>{layouts[0].size, layouts[0].align} == type_size_align(type));
+    }
+    CHECK(type_size_align("s") == pair<long long, int>{12, 4});
+    CHECK(type_size_align("u") == pair<long long, int>{12, 4});
+    CHECK(type_size_align("p") == pair<long long, int>{13, 1});
+}
+
+TEST_CASE("push_target y parse_atomic_override validan la entrada") {
+    setup_basic_atomics();
+    targets_arr.clear();
+    CHECK_THROWS_AS(push_target(targets_arr, "bad", 4, 0, {{"missing", {4, 4}}}), std::runtime_error);
+    CHECK_THROWS_AS(push_target(targets_arr, "bad", 0, 0, {}), std::runtime_error);
+    CHECK_THROWS_AS(parse_atomic_override("long:8"), std::runtime_error);
+    CHECK_THROWS_AS(parse_atomic_override("long:x:8"), std::runtime_error);
+
+    auto [name, size, align] = parse_atomic_override("long:8:4");
+    CHECK(name == "long");
+    CHECK(size == 8);
+    CHECK(align == 4);
+}
+
+
+TEST_CASE("calc_size_struct usa 64 bits y detecta desbordamiento") {
+    setup_basic_atomics();
+    push_atomic(types_arr, "block", 3000000000LL, 8);
+    push_struct(types_arr, "Big", {"block", "char", "block"});
+    const atomic_struct &big = get<atomic_struct>(types_arr["Big"].at);
+    CHECK(big.size == 6000000008LL); // El segundo bloque se alinea a 8
+
+    push_atomic(types_arr, "huge", LLONG_MAX / 2 + 1, 1);
+    CHECK_THROWS_AS(push_struct(types_arr, "Overflow", {"huge", "huge"}), std::overflow_error);
+    CHECK_THROWS_AS(align_up(LLONG_MAX - 2, 8), std::overflow_error);
+}
+
+TEST_CASE("layout_runs representa estructuras de varios GB por campos") {
+    setup_basic_atomics();
+    push_atomic(types_arr, "block", 3000000000LL, 8);
+    push_struct(types_arr, "Big", {"char", "block", "char", "block"});
+    const atomic_struct &big = get<atomic_struct>(types_arr["Big"].at);
+
+    struct_layout layout = compute_struct_layout(big, UNPACKED);
+    CHECK(layout.size == 6000000016LL);
+    CHECK(layout.lost == 14);
+
+    vector<mem_run> runs = layout_runs(layout);
+    REQUIRE(runs.size() == 5);
+    CHECK(runs[0].start == 0);
+    CHECK(runs[0].value == 1);
+    CHECK(runs[1].start == 1);
+    CHECK(runs[1].length == 7);
+    CHECK(runs[1].value == 0);
+    CHECK(runs[2].length == 3000000001LL);
+    CHECK(runs[3].length == 7);
+    CHECK(runs[4].start + runs[4].length == layout.size);
+
+    // No debe materializar los bytes del diagrama
+    print_struct_wt_packing(big, 4);
+}
+
+
+TEST_CASE("compute_layout reporta relleno final y stride") {
+    setup_basic_atomics();
+    push_struct(types_arr, "S", vector<string>{"double", "char"});
+    const atomic_struct &st = get<atomic_struct>(types_arr["S"].at);
+
+    struct_layout unpacked = compute_struct_layout(st, UNPACKED);
+    CHECK(unpacked.size == 9);
+    CHECK(unpacked.align == 8);
+    CHECK(unpacked.tail == 7);
+    CHECK(unpacked.stride == 16);
+
+    struct_layout packed = compute_struct_layout(st, PACKED);
+    CHECK(packed.align == 1);
+    CHECK(packed.tail == 0);
+    CHECK(packed.stride == 9);
+
+    CHECK(checked_mul(unpacked.stride, 1000000) == 16000000);
+    CHECK_THROWS_AS(checked_mul(unpacked.stride, LLONG_MAX / 2), std::overflow_error);
+    print_struct_wt_packing(st, 4, 1000000);
+}
+
+
+TEST_CASE("push_bitfield valida ancho y unidad") {
+    setup_basic_atomics();
+    push_bitfield(types_arr, "flag", 1, "int");
+    REQUIRE(types_arr["flag"].kind == BITFIELD);
+    const atomic_bitfield &b = get<atomic_bitfield>(types_arr["flag"].at);
+    CHECK(b.bits == 1);
+    CHECK(b.size == 4);
+    CHECK(b.align == 4);
+
+    CHECK_THROWS_AS(push_bitfield(types_arr, "wide", 33, "int"), std::runtime_error);
+    CHECK_THROWS_AS(push_bitfield(types_arr, "nounit", 3, "missing"), std::runtime_error);
+    print_bitfield(b, 4);
+}
+
+TEST_CASE("compute_layout ubica bitfields a nivel de bit") {
+    setup_basic_atomics();
+    push_bitfield(types_arr, "a3", 3, "int");
+    push_bitfield(types_arr, "b30", 30, "int");
+    push_bitfield(types_arr, "c5", 5, "char");
+    push_struct(types_arr, "Header", vector<string>{"a3", "c5", "b30", "char"});
+    const atomic_struct &h = get<atomic_struct>(types_arr["Header"].at);
+
+    // a3 en bits 0-2, c5 en 3-7, b30 no cabe en el primer int y empieza en el bit 32
+    struct_layout unpacked = compute_struct_layout(h, UNPACKED);
+    REQUIRE(unpacked.has_bits);
+    CHECK(unpacked.slots[0].bit_offset == 0);
+    CHECK(unpacked.slots[1].bit_offset == 3);
+    CHECK(unpacked.slots[2].bit_offset == 32);
+    CHECK(unpacked.slots[3].bit_offset == 64);
+    CHECK(unpacked.size_bits == 72);
+    CHECK(unpacked.used_bits == 46);
+    CHECK(unpacked.lost_bits == 26);
+    CHECK(unpacked.size == 9);
+    CHECK(unpacked.stride == 12);
+
+    // Empaquetado: los bits van uno tras otro y el char empieza en el siguiente byte
+    struct_layout packed = compute_struct_layout(h, PACKED);
+    CHECK(packed.slots[2].bit_offset == 8);
+    CHECK(packed.slots[3].bit_offset == 40);
+    CHECK(packed.size_bits == 48);
+    CHECK(packed.lost_bits == 2);
+
+    // Heuristica: c5 y char rellenan el hueco que b30 deja en el primer int
+    struct_layout heuristic = compute_struct_layout(h, HEURISTIC);
+    CHECK(heuristic.size_bits == 62);
+    CHECK(heuristic.used_bits == 46);
+    CHECK(heuristic.size == 8);
+
+    vector<mem_run> bit_runs = layout_runs(unpacked, true);
+    REQUIRE(!bit_runs.empty());
+    CHECK(bit_runs.back().start + bit_runs.back().length == 72);
+    print_struct_wt_packing(h, 4);
+
+    // Una ventana que empieza pasado el final no desborda al pasarla a bits
+    memory_sink far_sink, end_sink;
+    ostream far_out(&far_sink), end_out(&end_sink);
+    print_layout_diagram(unpacked, 4, LLONG_MAX / 4, LLONG_MAX, far_out);
+    print_layout_diagram(unpacked, 4, unpacked.stride, LLONG_MAX, end_out);
+    CHECK(far_sink.data == end_sink.data);
+}
+
+
+TEST_CASE("compute_struct_layout con structs anidados opacos y reuso de relleno final") {
+    setup_basic_atomics();
+    push_struct(types_arr, "Inner", vector<string>{"int", "char"});
+    push_struct(types_arr, "Outer", vector<string>{"Inner", "char", "int"});
+    const atomic_struct &outer = get<atomic_struct>(types_arr["Outer"].at);
+
+    // Expansion en linea: int, char, char, pad 2, int
+    struct_layout inline_layout = compute_struct_layout(outer, UNPACKED);
+    CHECK(inline_layout.size == 12);
+
+    // Opaco: Inner ocupa su stride de 8 bytes
+    struct_layout opaque = compute_struct_layout(outer, OPAQUE);
+    CHECK(opaque.size == 16);
+    CHECK(opaque.lost == 6);
+    REQUIRE(opaque.slots.size() == 4);
+    CHECK(opaque.slots[2].name == "char");
+    CHECK(opaque.slots[2].offset == 8);
+
+    // Reuso del relleno final: el char exterior entra en el byte 5
+    struct_layout reuse = compute_struct_layout(outer, TAIL_REUSE);
+    CHECK(reuse.slots[2].offset == 5);
+    CHECK(reuse.size == 12);
+    CHECK(reuse.stride == 12);
+
+    print_struct_nested(outer, OPAQUE, 4);
+    print_struct_nested(outer, TAIL_REUSE, 4);
+}
+
+
+TEST_CASE("compute_pack_table acota la alineacion para cada N") {
+    setup_basic_atomics();
+    push_struct(types_arr, "P", vector<string>{"char", "double", "short", "int"});
+    const atomic_struct &p = get<atomic_struct>(types_arr["P"].at);
+
+    vector<pack_result> table = compute_pack_table(p);
+    REQUIRE(table.size() == 5);
+
+    // pack(1): sin relleno, double/short/int desalineados
+    CHECK(table[0].pack == 1);
+    CHECK(table[0].layout.size == 15);
+    CHECK(table[0].layout.stride == 15);
+    CHECK(table[0].misaligned == 3);
+
+    // pack(2): char, pad, double en 2, short en 10, int en 12
+    CHECK(table[1].layout.size == 16);
+    CHECK(table[1].misaligned == 1);
+
+    // pack(4): double en 4, short en 12, int en 16
+    CHECK(table[2].layout.size == 20);
+    CHECK(table[2].misaligned == 1);
+
+    // pack(8) y pack(16) equivalen a la estrategia sin empaquetamiento
+    CHECK(table[3].layout.size == compute_struct_layout(p, UNPACKED).size);
+    CHECK(table[3].misaligned == 0);
+    CHECK(table[4].layout.stride == 24);
+
+    CHECK_THROWS_AS(compute_pack_table(p, {0}), std::runtime_error);
+    print_pack_table(p);
+}
+
+
+TEST_CASE("compute_union_layout mapea cada alternativa y su desperdicio") {
+    setup_basic_atomics();
+    push_struct(types_arr, "Pt", vector<string>{"char", "int"});
+    push_union(types_arr, "U", vector<string>{"Pt", "short", "double"});
+    const atomic_union &u = get<atomic_union>(types_arr["U"].at);
+
+    union_layout layout = compute_union_layout(u, UNPACKED);
+    CHECK(layout.size == 8);
+    CHECK(layout.align == 8);
+    REQUIRE(layout.members.size() == 3);
+    CHECK(layout.members[0].layout.size == 8);
+    CHECK(layout.members[0].wasted == 3);
+    CHECK(layout.members[1].wasted == 6);
+    CHECK(layout.members[2].wasted == 0);
+    CHECK(layout.max_wasted == 6);
+    CHECK(layout.total_wasted == 9);
+
+    // 0-0: Pt, short y double; 1-1: short y double; 2-3: double; 4-7: Pt y double
+    REQUIRE(layout.overlap.size() == 4);
+    CHECK(layout.overlap[0].value == 3);
+    CHECK(layout.overlap[1].value == 2);
+    CHECK(layout.overlap[2].start == 2);
+    CHECK(layout.overlap[2].value == 1);
+    CHECK(layout.overlap[3].value == 2);
+    CHECK(layout.overlap[3].start + layout.overlap[3].length == 8);
+
+    // Con empaquetamiento Pt ocupa 5 bytes
+    union_layout packed = compute_union_layout(u, PACKED);
+    CHECK(packed.members[0].layout.size == 5);
+    print_union_members(u, UNPACKED, 4);
+}
+
+
+TEST_CASE("la union ocupa un multiplo de su alineacion como sizeof, en la tabla y en compute_union_layout") {
+    setup_basic_atomics();
+    push_atomic(types_arr, "char5", 5, 1);
+    push_atomic(types_arr, "raro", 3, 6);
+    push_union(types_arr, "u", vector<string>{"char5", "int"});
+    push_union(types_arr, "w", vector<string>{"raro", "int"});
+
+    const atomic_union &u = get<atomic_union>(types_arr["u"].at);
+    CHECK(u.size == 8);
+    CHECK(u.align == 4);
+    union_layout layout = compute_union_layout(u, OPAQUE);
+    CHECK(layout.size == u.size);
+    CHECK(layout.align == u.align);
+
+    // La alineacion es el minimo comun multiplo, igual que calc_align_union
+    const atomic_union &w = get<atomic_union>(types_arr["w"].at);
+    CHECK(w.align == 12);
+    CHECK(w.size == 12);
+    layout = compute_union_layout(w, OPAQUE);
+    CHECK(layout.size == 12);
+    CHECK(layout.align == 12);
+}
+
+
+TEST_CASE("push_variant y compute_variant_placements buscan donde ubicar la etiqueta") {
+    setup_basic_atomics();
+    push_struct(types_arr, "Pt", vector<string>{"char", "int"});
+    push_struct(types_arr, "Q", vector<string>{"short", "int"});
+    push_variant(types_arr, "V", "char", vector<string>{"Pt", "Q"});
+    REQUIRE(types_arr["V"].kind == VARIANT);
+    const atomic_variant &v = get<atomic_variant>(types_arr["V"].at);
+    CHECK(v.size == 12);
+    CHECK(v.align == 4);
+
+    // La tabla guarda la ubicacion "before" con las alternativas como bloques
+    vector<variant_placement> opaque = compute_variant_placements(v, OPAQUE);
+    CHECK(opaque[0].stride == v.size);
+    CHECK(opaque[0].union_offset == 4);
+
+    vector<variant_placement> placements = compute_variant_placements(v);
+    REQUIRE(placements.size() == 4);
+
+    // Antes: etiqueta en 0 y union alineada a 4
+    CHECK(placements[0].available);
+    CHECK(placements[0].union_offset == 4);
+    CHECK(placements[0].stride == 12);
+
+    // Despues: union en 0 y etiqueta en 8
+    CHECK(placements[1].tag_offset == 8);
+    CHECK(placements[1].stride == 12);
+
+    // La union no tiene relleno final
+    CHECK_FALSE(placements[2].available);
+
+    // Los bytes 2-3 no los usa ninguna alternativa
+    CHECK(placements[3].available);
+    CHECK(placements[3].tag_offset == 2);
+    CHECK(placements[3].stride == 8);
+
+    CHECK_THROWS_AS(push_variant(types_arr, "W", "Pt", vector<string>{"Q"}), std::runtime_error);
+    CHECK_THROWS_AS(push_variant(types_arr, "W", "char", vector<string>{"W"}), std::runtime_error);
+    print_variant(v);
+}
+
+
+TEST_CASE("search_optimal_layout encuentra el orden de menor tamano") {
+    setup_basic_atomics();
+    push_struct(types_arr, "S", vector<string>{"char", "int", "short", "char", "double", "short"});
+    const atomic_struct &st = get<atomic_struct>(types_arr["S"].at);
+
+    vector<string> fields;
+    collect_struct_fields(st, fields);
+    vector<field_slot> leaves;
+    for (const auto& f : fields) leaves.push_back(leaf_slot(f));
+
+    atomic<bool> cancel{false};
+    int improvements = 0;
+    bool is_exhaustive = false;
+    struct_layout best = search_optimal_layout(leaves, cancel, chrono::steady_clock::now() + chrono::seconds(10),
+        [&improvements](const struct_layout&) { improvements++; }, is_exhaustive);
+
+    CHECK(is_exhaustive);
+    CHECK(improvements >= 1);
+    CHECK(best.size == 18);
+    CHECK(best.lost == 0);
+    CHECK(best.size <= compute_struct_layout(st, HEURISTIC).size);
+}
+
+TEST_CASE("start_strategy_race entrega primero los resultados baratos y luego la busqueda") {
+    setup_basic_atomics();
+    push_struct(types_arr, "S", vector<string>{"char", "int", "short", "char", "double", "bool"});
+    const atomic_struct &st = get<atomic_struct>(types_arr["S"].at);
+
+    thread_pool pool(2);
+    shared_ptr<strategy_race> race = start_strategy_race(st, pool, chrono::milliseconds(1000));
+
+    vector<strategy_result> results = wait_cheap_results(*race);
+    int cheap_final = 0;
+    for (const auto& r : results) {
+        if (r.is_cheap && r.is_final) cheap_final++;
+    }
+    CHECK(cheap_final == 5);
+
+    strategy_result r;
+    while (next_strategy_result(*race, r)) {
+        results.push_back(r);
+    }
+
+    int search_final = 0;
+    for (const auto& result : results) {
+        if (!result.is_cheap && result.is_final) {
+            search_final++;
+            CHECK(result.layout.size <= compute_struct_layout(st, HEURISTIC).size);
+        }
+    }
+    CHECK(search_final == 1);
+}
+
+TEST_CASE("la busqueda cancelada devuelve el mejor resultado hasta el momento") {
+    setup_basic_atomics();
+    vector<field_slot> leaves;
+    for (int i = 1; i <= 40; i++) {
+        leaves.push_back(field_slot{"f" + to_string(i), 0, i, (i % 4 == 0) ? 4 : (i % 2 == 0 ? 2 : 1)});
+    }
+
+    atomic<bool> cancel{true};
+    bool is_exhaustive = true;
+    struct_layout best = search_optimal_layout(leaves, cancel, chrono::steady_clock::now() + chrono::seconds(10),
+        [](const struct_layout&) {}, is_exhaustive);
+
+    CHECK_FALSE(is_exhaustive);
+    CHECK(best.slots.size() == 40);
+}
+
+TEST_CASE("la carrera informa el desborde de una estrategia sin terminar el proceso") {
+    setup_basic_atomics();
+    push_atomic(types_arr, "huge", 8, 1);
+    push_struct(types_arr, "S", vector<string>{"huge", "char"});
+    // Redefinir el campo deja un struct que desborda al calcular su disposicion en bits
+    push_atomic(types_arr, "huge", 2000000000000000000LL, 1);
+
+    thread_pool pool(2);
+    memory_sink sink;
+    ostream out(&sink);
+    CHECK_THROWS_WITH_AS(print_strategy_race(get<atomic_struct>(types_arr["S"].at), pool, chrono::milliseconds(100), out),
+                         "Error: Size overflow multiplying 2000000000000000000 by 8.", std::runtime_error);
+    CHECK(sink.data.find("Best strategy") == string::npos);
+}
+
+
+TEST_CASE("render_runs_diagram colapsa las filas iguales") {
+    vector<mem_run> runs = {{0, 6, 1}, {6, 2, 0}};
+    CHECK(render_runs_diagram(runs, 4) ==
+          " - - - - - - - - - - - -\n Memory Layout Diagram (each '1' represents a byte):"
+          "\n   0 | 1 1 1 1 |\n   4 | 1 1 0 0 |\n - - - - - - - - - - - -\n");
+
+    // 1 GB simulado: la salida depende de la cantidad de runs y no de bytes
+    long long gb = 1LL << 30;
+    vector<mem_run> big = {{0, gb - 2, 1}, {gb - 2, 2, 0}};
+    string out = render_runs_diagram(big, 4);
+    CHECK(out.find("rows 0..268435454: all 1s (bytes 0..1073741819)") != string::npos);
+    CHECK(out.find("1073741820 | 1 1 0 0 |") != string::npos);
+    CHECK(out.size() < 256);
+}
+
+TEST_CASE("render_field_map etiqueta cada campo y su padding") {
+    setup_basic_atomics();
+    push_struct(types_arr, "s", {"char", "int", "short"});
+    const atomic_struct& s = get<atomic_struct>(types_arr["s"].at);
+
+    string map = render_field_map(compute_struct_layout(s, UNPACKED));
+    CHECK(map.find("     0..0      | #0 char\n") != string::npos);
+    CHECK(map.find("     1..3      | padding before #1 int (3 bytes)\n") != string::npos);
+    CHECK(map.find("     4..7      | #1 int\n") != string::npos);
+    CHECK(map.find("    10..11     | tail padding (2 bytes)\n") != string::npos);
+
+    string heuristic = render_field_map(compute_struct_layout(s, HEURISTIC));
+    CHECK(heuristic.find("     0..3      | #1 int\n") != string::npos);
+    CHECK(heuristic.find("padding before") == string::npos);
+}
+
+TEST_CASE("layout_runs recorta la ventana pedida sin recorrer los campos de afuera") {
+    setup_basic_atomics();
+    push_struct(types_arr, "s", {"char", "int", "char", "double"});
+    const atomic_struct& s = get<atomic_struct>(types_arr["s"].at);
+    struct_layout layout = compute_struct_layout(s, UNPACKED); // c . . . i i i i c . . . . . . . d*8
+
+    vector<mem_run> runs = layout_runs(layout, false, 2, 10);
+    REQUIRE(runs.size() == 3);
+    CHECK(runs[0].start == 2);  CHECK(runs[0].length == 2); CHECK(runs[0].value == 0);
+    CHECK(runs[1].start == 4);  CHECK(runs[1].length == 5); CHECK(runs[1].value == 1);
+    CHECK(runs[2].start == 9);  CHECK(runs[2].length == 1); CHECK(runs[2].value == 0);
+
+    CHECK(layout_runs(layout, false, 30, 40).empty());
+    CHECK(render_runs_diagram(runs, 4).find("\n   0 |     0 0 |\n   4 | 1 1 1 1 |\n   8 | 1 0 ") != string::npos);
+
+    vector<mem_run> block = block_runs(10, 4, 8, 100);
+    REQUIRE(block.size() == 2);
+    CHECK(block[0].start == 8); CHECK(block[0].length == 2);
+    CHECK(block[1].start == 10); CHECK(block[1].length == 2);
+}
+
+TEST_CASE("export_types_json y export_types_binary exportan cada tipo") {
+    setup_basic_atomics();
+    push_struct(types_arr, "s", {"char", "int"});
+
+    string json = export_types_json();
+    CHECK(count(json.begin(), json.end(), '\n') == (long) types_arr.size());
+    CHECK(json.find("{\"name\":\"char\",\"kind\":\"atomic\",\"size\":1,\"align\":1}\n") != string::npos);
+    CHECK(json.find("\"unpacked\":{\"size\":8,\"align\":4,\"stride\":8,\"lost\":3,\"slots\":["
+                    "{\"id\":0,\"type\":\"char\",\"offset\":0,\"size\":1},{\"id\":1,\"type\":\"int\",\"offset\":4,\"size\":4}]}") != string::npos);
+    CHECK(json.find("\"packed\":{\"size\":5,") != string::npos);
+
+    push_struct(types_arr, "outer", {"short", "s", "char"});
+    struct_layout opaque = compute_struct_layout(get<atomic_struct>(types_arr["outer"].at), OPAQUE);
+    REQUIRE(opaque.slots.size() == 4);
+    CHECK(opaque.slots[1].id == 1);
+    CHECK(opaque.slots[2].id == 2);
+    CHECK(opaque.slots[3].id == 3);
+
+    string binary = export_types_binary();
+    REQUIRE(binary.size() > 12);
+    CHECK(binary.substr(0, 4) == "TMGR");
+    CHECK((unsigned char) binary[4] == BINARY_VERSION);
+    CHECK((unsigned char) binary[8] == types_arr.size());
+}
+
+TEST_CASE("diff_layouts lista solo los campos que cambiaron") {
+    setup_basic_atomics();
+    push_struct(types_arr, "s", {"char", "int", "short"});
+    const atomic_struct& s = get<atomic_struct>(types_arr["s"].at);
+
+    // sin empaquetar: char 0, int 4, short 8 / heuristica: int 0, short 4, char 6
+    layout_diff diff = diff_layouts(compute_struct_layout(s, UNPACKED), compute_struct_layout(s, HEURISTIC));
+    REQUIRE(diff.edits.size() == 3);
+    CHECK(diff.edits[0].op == FIELD_MOVED); CHECK(diff.edits[0].name == "char"); CHECK(diff.edits[0].new_offset == 6);
+    CHECK(diff.edits[1].op == FIELD_MOVED); CHECK(diff.edits[1].old_offset == 4); CHECK(diff.edits[1].new_offset == 0);
+    CHECK(diff.old_size == 10); CHECK(diff.new_size == 7);
+    CHECK_FALSE(has_changes(diff_layouts(compute_struct_layout(s, UNPACKED), compute_struct_layout(s, UNPACKED))));
+
+    map<string, atomic_type> before = types_arr;
+    push_atomic(types_arr, "short", 4, 4);
+    push_struct(types_arr, "s", {"char", "char", "int", "short"});
+    push_struct(types_arr, "t", {"char"});
+
+    vector<type_diff> diffs = diff_type_tables(before, types_arr, UNPACKED);
+    REQUIRE(diffs.size() == 2);
+    CHECK(diffs[0].name == "s");
+    REQUIRE(diffs[0].layout.edits.size() == 2);
+    CHECK(diffs[0].layout.edits[0].op == FIELD_ADDED);   // el segundo char
+    CHECK(diffs[0].layout.edits[1].op == FIELD_RESIZED); // short pasa a 4 bytes
+    CHECK(diffs[1].name == "t");
+    CHECK(diffs[1].is_added);
+
+    // La instantanea se lee sin tocar la tabla global
+    CHECK(compute_struct_layout(get<atomic_struct>(before.at("s").at), UNPACKED, true, before).size == 10);
+    CHECK(types_arr.find("t") != types_arr.end());
+    CHECK(get<aatomic>(types_arr["short"].at).size == 4);
+}
+
+TEST_CASE("compute_struct_layout sin tabla de offsets da los mismos totales") {
+    setup_basic_atomics();
+    push_bitfield(types_arr, "flag", 3, "int");
+    vector<string> fields;
+    for (int i = 0; i < 1000; i++) fields.push_back(i % 3 == 0 ? "char" : (i % 3 == 1 ? "double" : "flag"));
+    push_struct(types_arr, "wide", fields);
+    const atomic_struct& wide = get<atomic_struct>(types_arr["wide"].at);
+
+    for (LayoutStrategy strategy : {UNPACKED, PACKED, HEURISTIC}) {
+        struct_layout full = compute_struct_layout(wide, strategy);
+        struct_layout summary = compute_struct_layout(wide, strategy, false);
+        CHECK(summary.slots.empty());
+        CHECK(summary.size == full.size);
+        CHECK(summary.used == full.used);
+        CHECK(summary.lost == full.lost);
+        CHECK(summary.align == full.align);
+        CHECK(summary.stride == full.stride);
+    }
+}
+
+TEST_CASE("los printers escriben en el sink recibido y solo se escribe al hacer flush") {
+    setup_basic_atomics();
+    push_struct(types_arr, "s", {"char", "int"});
+    const atomic_struct& s = get<atomic_struct>(types_arr["s"].at);
+
+    memory_sink memory;
+    ostream to_memory(&memory);
+    print_struct_wt_packing(s, 4, 0, 0, LLONG_MAX, to_memory);
+    CHECK(memory.data.find("Struct Type: s, Bytes allocated: 8 bytes, Bytes lost: 3\n") == 0);
+    CHECK(memory.bytes == (long long) memory.data.size());
+
+    null_sink discard;
+    ostream to_null(&discard);
+    print_types(to_null);
+    CHECK(discard.bytes > 0);
+
+    int fd = open("/dev/null", O_WRONLY);
+    REQUIRE(fd >= 0);
+    {
+        fd_sink file(fd, 1 << 16);
+        ostream to_file(&file);
+        for (int i = 0; i < 100; i++) print_struct_heuristics(s, 4, 0, 0, LLONG_MAX, to_file);
+        CHECK(file.writes == 0);
+        to_file.flush();
+        CHECK(file.writes == 1);
+    }
+    close(fd);
+}
+
+TEST_CASE("command_source entrega los comandos en orden con y sin pipeline") {
+    map<string, int> commands = {{"ATOMICO", 1}, {"STRUCT", 2}, {"SALIR", 5}};
+    string script;
+    for (int i = 0; i < 5000; i++) script += "ATOMICO t" + to_string(i) + " 4 4\n" + (i % 7 == 0 ? "\n" : "") + "FOO\t bar\n";
+    script += "SALIR";
+
+    vector<vector<parsed_command>> results;
+    for (bool pipelined : {false, true}) {
+        istringstream in(script);
+        ostringstream out;
+        command_source source(in, out, commands, pipelined, 16);
+        vector<parsed_command> read;
+        parsed_command command;
+        while (source.next(command)) read.push_back(command);
+        results.push_back(read);
+    }
+
+    REQUIRE(results[0].size() == results[1].size());
+    CHECK(results[0].size() == 5000 * 2 + 715 + 1);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < results[0].size(); i++) {
+        if (results[0][i].tokens != results[1][i].tokens || results[0][i].code != results[1][i].code) mismatches++;
+    }
+    CHECK(mismatches == 0);
+    CHECK(results[1][0].code == 1);
+    CHECK(results[1][1].tokens.empty());
+    CHECK(results[1][2].code == 0);
+    CHECK(results[1][2].tokens == vector<string>{"FOO", "bar"});
+    CHECK(results[1].back().code == 5);
+}
+
+TEST_CASE("spsc_queue entrega todo en orden y no deja hilos dormidos") {
+    // Con capacidad 2 los dos lados se duermen a menudo; un aviso perdido colgaria la prueba
+    spsc_queue<int> queue(2);
+    atomic<bool> stop{false};
+    const int count = 200000;
+    thread producer([&]() {
+        for (int i = 0; i < count; i++) queue.push(i, stop);
+    });
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        int value = -1;
+        if (!queue.pop(value, stop) || value != i) mismatches++;
+    }
+    producer.join();
+    CHECK(mismatches == 0);
+    CHECK(queue.sleepers.load() == 0);
+}
+
+// Entrada que lee de un descriptor y bloquea hasta que llegue algo, como stdin conectado a un pipe
+struct fd_source : streambuf {
+    int fd;
+    char buffer[256];
+
+    explicit fd_source(int fd) : fd(fd) {}
+
+    int_type underflow() override {
+        ssize_t count = ::read(fd, buffer, sizeof(buffer));
+        if (count <= 0) return traits_type::eof();
+        setg(buffer, buffer, buffer + count);
+        return traits_type::to_int_type(buffer[0]);
+    }
+};
+
+TEST_CASE("command_source no espera al lector bloqueado al destruirse") {
+    map<string, int> commands = {{"ATOMICO", 1}, {"SALIR", 5}};
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    REQUIRE(::write(fds[1], "ATOMICO a 1 1\nSALIR\n", 20) == 20);
+
+    // El lector suelto sigue usando la entrada hasta que se cierra el pipe, asi que vive hasta el final del programa
+    static fd_source buffer(fds[0]);
+    static istream in(&buffer);
+    ostringstream out;
+    auto started = chrono::steady_clock::now();
+    {
+        command_source source(in, out, commands, true);
+        parsed_command command;
+        REQUIRE(source.next(command));
+        CHECK(command.code == 1);
+        REQUIRE(source.next(command));
+        CHECK(command.code == 5);
+    }
+    CHECK(chrono::steady_clock::now() - started < chrono::seconds(5));
+    ::close(fds[1]);
+}
+
+TEST_CASE("las transacciones aplican las definiciones al hacer COMMIT y ROLLBACK no toca la tabla") {
+    setup_basic_atomics();
+    transaction tx;
+    begin_transaction(tx);
+    CHECK_THROWS(begin_transaction(tx));
+
+    // s usa un tipo que se define despues y w se redefine: solo cuenta la ultima definicion
+    type_definition s{STRUCT, "s"};
+    s.fields = {"w", "char"};
+    stage_definition(tx, s);
+    stage_definition(tx, type_definition{ATOMIC, "w", 2, 2});
+    stage_definition(tx, type_definition{ATOMIC, "w", 8, 8});
+    CHECK(types_arr.find("s") == types_arr.end());
+
+    CHECK(commit_transaction(tx) == 2);
+    CHECK_FALSE(tx.active);
+    CHECK(get<atomic_struct>(types_arr["s"].at).size == 16);
+
+    begin_transaction(tx);
+    stage_definition(tx, type_definition{ATOMIC, "char", 4, 4});
+    CHECK(rollback_transaction(tx) == 1);
+    CHECK(get<aatomic>(types_arr["char"].at).size == 1);
+
+    // Un ciclo o un tipo inexistente hacen fallar el COMMIT sin modificar la tabla
+    begin_transaction(tx);
+    type_definition a{STRUCT, "a"};
+    a.fields = {"b"};
+    type_definition b{STRUCT, "b"};
+    b.fields = {"a"};
+    stage_definition(tx, type_definition{ATOMIC, "int", 16, 16});
+    stage_definition(tx, a);
+    stage_definition(tx, b);
+    CHECK_THROWS(commit_transaction(tx));
+    CHECK(tx.active);
+    CHECK(get<aatomic>(types_arr["int"].at).size == 4);
+
+    // Si falla al aplicar, lo ya aplicado se deshace
+    type_definition flag{BITFIELD, "flag"};
+    flag.bits = 100;
+    flag.unit = "char";
+    tx.staged = {type_definition{ATOMIC, "int", 16, 16}, flag};
+    CHECK_THROWS(commit_transaction(tx));
+    CHECK(get<aatomic>(types_arr["int"].at).size == 4);
+    CHECK(types_arr.find("flag") == types_arr.end());
+}
+
+// Envia un comando al servidor y lee su respuesta hasta el siguiente prompt
+string server_request(int fd, const string& line) {
+    if (!line.empty()) {
+        string request = line + "\n";
+        REQUIRE(::write(fd, request.data(), request.size()) == (ssize_t) request.size());
+    }
+    string reply;
+    char buffer[4096];
+    while (reply.size() < 2 || reply.compare(reply.size() - 2, 2, "> ") != 0) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        reply.append(buffer, n);
+    }
+    return reply;
+}
+
+int connect_test_client(const string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(::connect(fd, (sockaddr*) &address, sizeof(address)) == 0);
+    return fd;
+}
+
+TEST_CASE("el servidor comparte la tabla de tipos entre clientes concurrentes") {
+    setup_basic_atomics();
+    string path = "/tmp/type-manager-test-" + to_string(getpid()) + ".sock";
+    memory_sink log_sink;
+    ostream log(&log_sink);
+    type_server server(path, log);
+    thread runner([&server]() { server.run(); });
+
+    int first = connect_test_client(path);
+    int second = connect_test_client(path);
+    CHECK(server_request(first, "") == "Enter command:\n> ");
+    CHECK(server_request(second, "") == "Enter command:\n> ");
+
+    // Lo que define un cliente lo ve el otro
+    CHECK(server_request(first, "STRUCT s char int") == "STRUCT type s created successfully!\n> ");
+    string reply = server_request(second, "DESCRIBIR s RESUMEN");
+    CHECK(reply.find("Strategy without packing: Size: 8 bytes") != string::npos);
+    CHECK(server_request(second, "DESCRIBIR t") == "Error: Type 't' not found in type table.\n> ");
+
+    // Varios clientes escriben a la vez
+    vector<thread> writers;
+    for (int k = 0; k < 4; k++) {
+        writers.emplace_back([&path, k]() {
+            int fd = connect_test_client(path);
+            server_request(fd, "");
+            string script;
+            for (int i = 0; i < 50; i++) script += "ATOMICO w" + to_string(k) + "_" + to_string(i) + " 4 4\nIMPRIMIR\n";
+            REQUIRE(::write(fd, script.data(), script.size()) == (ssize_t) script.size());
+            string reply;
+            char buffer[4096];
+            while (reply.find("w" + to_string(k) + "_49 created") == string::npos) {
+                ssize_t n = ::read(fd, buffer, sizeof(buffer));
+                if (n <= 0) break;
+                reply.append(buffer, n);
+            }
+            ::close(fd);
+        });
+    }
+    for (auto& writer : writers) writer.join();
+
+    // La transaccion es de cada cliente
+    CHECK(server_request(first, "BEGIN") == "Transaction started.\n> ");
+    CHECK(server_request(second, "ROLLBACK") == "Error: No transaction is open.\n> ");
+    CHECK(server_request(first, "SALIR") == "Saliendo del programa.\n");
+    ::close(first);
+    ::close(second);
+
+    server.stop = true;
+    runner.join();
+    CHECK(types_arr.size() == 7 + 1 + 200);
+    CHECK(log_sink.data.find("Listening on " + path) == 0);
+    CHECK(log_sink.data.find("disconnected: 3 commands") != string::npos);
+    CHECK(log_sink.data.find("disconnected: 100 commands") != string::npos);
+}
+
+// Ejecuta comandos en una sesion y devuelve su salida
+string run_commands(session& s, const vector<string>& lines) {
+    memory_sink sink;
+    ostream out(&sink);
+    for (const auto& line : lines) {
+        execute_command(parse_command(line, AVAILABLE_COMMANDS), s, out);
+    }
+    return sink.data;
+}
+
+TEST_CASE("el diario recupera la tabla de la instantanea y de los registros posteriores") {
+    string dir = "/tmp/type-manager-wal-" + to_string(getpid());
+    ::unlink((dir + "/types.log").c_str());
+    ::unlink((dir + "/types.snapshot").c_str());
+    types_arr.clear();
+
+    string expected;
+    {
+        journal wal(dir, 3);
+        CHECK_FALSE(wal.recover(types_arr).has_snapshot);
+        session s;
+        s.wal = &wal;
+        run_commands(s, {"ATOMICO w 2 2", "ATOMICO char 1 1", "STRUCT s w char", "UNION u w s", "STRUCT x nada"});
+        // Al llegar a 3 registros se compacta; la transaccion es un solo registro
+        CHECK(wal.records_since_snapshot == 1);
+        run_commands(s, {"BEGIN", "STRUCT t s u", "BITFIELD f 3 w", "COMMIT"});
+        CHECK(wal.records_since_snapshot == 2);
+        // Redefinir w no cambia el tamaño ya calculado de s, y la recuperacion debe conservarlo
+        run_commands(s, {"ATOMICO w 8 8", "VARIANTE v char w s"});
+        CHECK(get<atomic_struct>(types_arr["s"].at).size == 4);
+        expected = export_types_json();
+    }
+
+    types_arr.clear();
+    journal wal(dir, 3);
+    recovery_report report = wal.recover(types_arr);
+    CHECK(report.has_snapshot);
+    CHECK(report.snapshot_types == 6);
+    CHECK(report.replayed_records == 1);
+    CHECK(report.replayed_definitions == 1);
+    CHECK(report.discarded_bytes == 0);
+    CHECK(export_types_json() == expected);
+    CHECK(wal.sequence == 7);
+}
+
+TEST_CASE("el diario descarta un registro cortado o con checksum incorrecto") {
+    string dir = "/tmp/type-manager-wal-torn-" + to_string(getpid());
+    ::unlink((dir + "/types.log").c_str());
+    ::unlink((dir + "/types.snapshot").c_str());
+    types_arr.clear();
+
+    {
+        journal wal(dir);
+        wal.recover(types_arr);
+        session s;
+        s.wal = &wal;
+        run_commands(s, {"ATOMICO a 1 1", "ATOMICO b 2 2"});
+    }
+
+    // Se corta el ultimo registro a la mitad
+    string data;
+    REQUIRE(read_buffer(dir + "/types.log", data));
+    REQUIRE(::truncate((dir + "/types.log").c_str(), data.size() - 5) == 0);
+
+    types_arr.clear();
+    {
+        journal wal(dir);
+        recovery_report report = wal.recover(types_arr);
+        CHECK(report.replayed_records == 1);
+        CHECK(report.discarded_bytes > 0);
+        CHECK(types_arr.count("a") == 1);
+        CHECK(types_arr.count("b") == 0);
+        session s;
+        s.wal = &wal;
+        run_commands(s, {"ATOMICO c 4 4"});
+    }
+
+    // Un byte cambiado invalida el registro y todo lo que le sigue
+    REQUIRE(read_buffer(dir + "/types.log", data));
+    data[data.size() - 3] ^= 0x40;
+    write_buffer(dir + "/types.log", data);
+
+    types_arr.clear();
+    journal wal(dir);
+    recovery_report report = wal.recover(types_arr);
+    CHECK(report.replayed_records == 1);
+    CHECK(types_arr.size() == 1);
+    CHECK(types_arr.count("c") == 0);
+}
+
+TEST_CASE("el diario quita el registro a medias si falla la escritura") {
+    string dir = "/tmp/type-manager-wal-partial-" + to_string(getpid());
+    ::unlink((dir + "/types.log").c_str());
+    ::unlink((dir + "/types.snapshot").c_str());
+    types_arr.clear();
+
+    journal wal(dir);
+    wal.recover(types_arr);
+    CHECK_FALSE(wal.append({type_definition{ATOMIC, "a", 1, 1}}));
+    struct stat before;
+    REQUIRE(::stat(wal.log_path().c_str(), &before) == 0);
+
+    // Con el limite de tamano de archivo la escritura se corta a la mitad del registro
+    vector<type_definition> defs;
+    for (int i = 0; i < 100; i++) defs.push_back(type_definition{ATOMIC, "t" + to_string(i), 4, 4});
+    signal(SIGXFSZ, SIG_IGN);
+    rlimit old_limit;
+    REQUIRE(::getrlimit(RLIMIT_FSIZE, &old_limit) == 0);
+    rlimit limit = old_limit;
+    limit.rlim_cur = before.st_size + 64;
+    REQUIRE(::setrlimit(RLIMIT_FSIZE, &limit) == 0);
+    CHECK_THROWS_AS(wal.append(defs), std::runtime_error);
+    REQUIRE(::setrlimit(RLIMIT_FSIZE, &old_limit) == 0);
+    signal(SIGXFSZ, SIG_DFL);
+
+    struct stat after;
+    REQUIRE(::stat(wal.log_path().c_str(), &after) == 0);
+    CHECK(after.st_size == before.st_size);
+
+    // Lo que se escribe despues sigue al ultimo registro completo
+    wal.append({type_definition{ATOMIC, "b", 2, 2}});
+    types_arr.clear();
+    journal recovered(dir);
+    recovery_report report = recovered.recover(types_arr);
+    CHECK(report.replayed_records == 2);
+    CHECK(report.discarded_bytes == 0);
+    CHECK(types_arr.count("b") == 1);
+}
+
+TEST_CASE("IMPORTAR lee typedefs, structs anidados, arreglos y pragma pack de un header de C") {
+    types_arr.clear();
+    string path = "/tmp/type-manager-import-" + to_string(getpid()) + ".h";
+    write_buffer(path, R"(
+#ifndef POINT_H
+#define POINT_H
+#include <stdint.h>
+
+/* Tipos basicos */
+typedef unsigned int uint;
+typedef struct point { int x, y; } point_t;
+
+// Anidados, arreglos, punteros y bitfields
+struct shape {
+    point_t origin;
+    union { float radius; double side; } size;
+    struct { char tag; };
+    unsigned long long flags : 3;
+    char name[16];
+    point_t corners[2];
+    struct shape *next;
+    void (*draw)(const struct shape *self);
+};
+
+enum color { RED, GREEN };
+int area(const struct shape *s);
+static inline int twice(int x) { return 2 * x; }
+
+#pragma pack(push, 2)
+typedef struct { char c; uint32_t value; enum color hue; } packed_t;
+#pragma pack(pop)
+
+struct inner { char c; int i; };
+#pragma pack(1)
+struct outer { char x; struct inner in; };
+#pragma pack()
+#endif
+)");
+
+    session s;
+    string output = run_commands(s, {"IMPORTAR " + path});
+    CHECK(output.find("types imported from " + path) != string::npos);
+
+    CHECK(get<aatomic>(types_arr["uint"].at).size == 4);
+    CHECK(get<atomic_struct>(types_arr["point"].at).fields == vector<string>{"int", "int"});
+    CHECK(get<atomic_struct>(types_arr["point_t"].at).fields == vector<string>{"int", "int"});
+    CHECK(get<atomic_struct>(types_arr["shape"].at).fields == vector<string>{
+        "point_t", "shape.size", "shape.anon2", "long_long:3", "char[16]", "point_t", "point_t", "ptr", "ptr"});
+    CHECK(get<atomic_union>(types_arr["shape.size"].at).fields == vector<string>{"float", "double"});
+    CHECK(get<aatomic>(types_arr["char[16]"].at).size == 16);
+    CHECK(get<atomic_bitfield>(types_arr["long_long:3"].at).unit == "long_long");
+    CHECK(get<aatomic>(types_arr["color"].at).size == 4);
+    CHECK(types_arr.count("area") == 0);
+    CHECK(types_arr.count("twice") == 0);
+
+    // Con pack(2) los campos de alineacion mayor usan una copia con la alineacion limitada
+    CHECK(get<atomic_struct>(types_arr["packed_t"].at).fields == vector<string>{"char", "uint32_t@2", "color@2"});
+    CHECK(get<aatomic>(types_arr["uint32_t@2"].at).align == 2);
+
+    // Un struct anidado bajo pack(1) conserva su disposicion y su sizeof; solo se limita su alineacion
+    CHECK(get<atomic_struct>(types_arr["outer"].at).fields == vector<string>{"char", "inner@1"});
+    CHECK(get<atomic_struct>(types_arr["inner@1"].at).fields == vector<string>{"char", "int"});
+    CHECK(type_size_align("inner") == pair<long long, int>{8, 4});
+    CHECK(type_size_align("inner@1") == pair<long long, int>{8, 1});
+    CHECK(type_size_align("outer") == pair<long long, int>{9, 1});
+
+    // Un error deja la tabla como estaba
+    size_t before = types_arr.size();
+    write_buffer(path, "struct ok { int a; };\nstruct bad { missing_t a; };\n");
+    output = run_commands(s, {"IMPORTAR " + path});
+    CHECK(output.find(path + ":2: Type 'missing_t' not found.") != string::npos);
+    CHECK(types_arr.size() == before);
+    CHECK(types_arr.count("ok") == 0);
+}
+
+TEST_CASE("generate_validation_case y emit_validation_program arman los casos sin tocar la tabla") {
+    setup_basic_atomics();
+    size_t before = types_arr.size();
+
+    // Los casos son reproducibles y sus nombres no chocan entre si
+    validation_options options;
+    options.unions = false;
+    validation_case first = generate_validation_case(7, options);
+    validation_case again = generate_validation_case(7, options);
+    CHECK(first.declarations == again.declarations);
+    CHECK(types_arr.size() == before);
+    REQUIRE_FALSE(first.types.empty());
+    for (const auto& type : first.types) {
+        CHECK(type.name.rfind("v7_", 0) == 0);
+        REQUIRE(type.expected.size() == 3);
+        CHECK(type.expected[0].first == "unpacked");
+        CHECK(type.expected[1].first == "opaque");
+        CHECK(type.expected[1].second.size() == 2 + type.leaves.size());
+        CHECK(type.expected[2].first == "table");
+        // La tabla guarda la disposicion de C, la misma que la estrategia opaca
+        CHECK(type.expected[2].second[0] == type.expected[1].second[0]);
+        CHECK(type.expected[2].second[1] == type.expected[1].second[1]);
+    }
+
+    validation_case vcase;
+    vcase.declarations = {"typedef int v0_int;", "struct v0_s0 { v0_int f0; };", "struct v0_s1 { v0_s0 f0; v0_int f1; };"};
+    validation_type type{"v0_s1", STRUCT, {"f0.f0", "f1"}, {}};
+    vcase.types.push_back(type);
+    CHECK(emit_validation_program({vcase}) ==
+          "#include <cstdio>\n#include <cstddef>\n\n"
+          "typedef int v0_int;\nstruct v0_s0 { v0_int f0; };\nstruct v0_s1 { v0_s0 f0; v0_int f1; };\n"
+          "\nint main() {\n"
+          "    std::printf(\"v0_s1 %zu %zu %zu %zu\\n\", sizeof(v0_s1), alignof(v0_s1), offsetof(v0_s1, f0.f0), offsetof(v0_s1, f1));\n"
+          "    return 0;\n}\n");
+}
+
+TEST_CASE("CONSULTA responde por rango, mayores y contencion desde los indices y sigue los cambios de la tabla") {
+    setup_basic_atomics();
+    session s;
+    run_commands(s, {"STRUCT a char int char", "STRUCT b int a", "STRUCT c double char"});
+
+    CHECK(run_commands(s, {"CONSULTA DESPERDICIO > 5"}) ==
+          "a: size 12, align 4, wasted 6, saving 4\n"
+          "b: size 16, align 4, wasted 6, saving 0\n"
+          "c: size 16, align 8, wasted 7, saving 0\n"
+          "3 types match.\n");
+    CHECK(run_commands(s, {"CONSULTA AHORRO >= 4 LIMITE 1"}) == "a: size 12, align 4, wasted 6, saving 4\n1 type matches.\n");
+    CHECK(run_commands(s, {"CONSULTA DESPERDICIO MAYORES 1"}) == "c: size 16, align 8, wasted 7, saving 0\n1 type matches.\n");
+    CHECK(run_commands(s, {"CONSULTA CONTIENE char"}).find("3 types match.") != string::npos);
+    CHECK(run_commands(s, {"CONSULTA CONTIENE a"}) == "b: size 16, align 4, wasted 6, saving 0\n1 type matches.\n");
+
+    // Redefinir a tambien actualiza b, que lo contiene: su tamano pasa a ser 4 + 8 aunque la tabla guarde el de antes
+    run_commands(s, {"STRUCT a int int"});
+    CHECK(run_commands(s, {"CONSULTA AHORRO >= 4"}) == "0 types match.\n");
+    CHECK(run_commands(s, {"CONSULTA CONTIENE char"}) == "c: size 16, align 8, wasted 7, saving 0\n1 type matches.\n");
+    CHECK(run_commands(s, {"CONSULTA CONTIENE a"}) == "b: size 12, align 4, wasted 0, saving 0\n1 type matches.\n");
+    CHECK(get<atomic_struct>(types_arr["b"].at).size == 16);
+    CHECK(run_commands(s, {"CONSULTA DESPERDICIO = 0 LIMITE 2"}).find("2 types match.") != string::npos);
+
+    // Una tabla cambiada sin push_* se vuelve a indexar completa
+    setup_basic_atomics();
+    CHECK(run_commands(s, {"CONSULTA TAMANO = 8"}) ==
+          "double: size 8, align 8, wasted 0, saving 0\nlong: size 8, align 8, wasted 0, saving 0\n2 types match.\n");
+    CHECK(run_commands(s, {"CONSULTA PESO > 1"}).find("Error: Unknown metric 'PESO'.") == 0);
+    CHECK(run_commands(s, {"CONSULTA CONTIENE a"}).find("Error: Type 'a' not found in type table.") == 0);
+}
+
+TEST_CASE("el benchmark genera los esquemas sinteticos y escribe una linea JSON por operacion") {
+    setup_basic_atomics();
+    size_t before = types_arr.size();
+
+    bench_schema deep = generate_deep_schema(50);
+    CHECK(deep.root == "deep_49");
+    CHECK(generate_wide_schema(100, 1).definitions.back().fields.size() == 100);
+    CHECK(generate_diamond_schema(4, 3, 1).definitions.size() == BENCH_ATOMICS.size() + 12);
+    CHECK(definition_command(type_definition{STRUCT, "s", 0, 0, 0, "", "", {"int", "char"}}) == "STRUCT s int char");
+
+    bench_options options;
+    options.scale = 0.001;
+    options.schemas = {"deep", "union"};
+    options.label = "abc123";
+    vector<string> lines;
+    vector<bench_result> results = run_bench(options, [&lines](const string& line) { lines.push_back(line); });
+    REQUIRE(results.size() == 14);
+    CHECK(lines.size() == 14);
+    CHECK(lines[0].find("{\"label\":\"abc123\",\"schema\":\"deep\",\"types\":16,\"fields\":29,\"operation\":\"register\"") == 0);
+    CHECK(lines[13].find("\"schema\":\"union\"") != string::npos);
+    CHECK(lines[13].find("\"operation\":\"repl\"") != string::npos);
+    CHECK(types_arr.size() == before);
+}
+
+TEST_CASE("STATS registra latencias por comando con percentiles y cuenta busquedas, reservas y bytes de layout") {
+    latency_histogram histogram;
+    for (long long value = 1; value <= 1000; value++) histogram.record(value * 1000);
+    CHECK(histogram.total == 1000);
+    CHECK(histogram.value_at(50) >= 500000);
+    CHECK(histogram.value_at(50) <= 500000 * 1.02);
+    CHECK(histogram.value_at(99) >= 990000);
+    CHECK(histogram.value_at(100) == 1000000);
+    CHECK(latency_histogram::highest_in_bucket(latency_histogram::bucket_of(77)) == 77);
+
+    setup_basic_atomics();
+    session s;
+    CHECK(run_commands(s, {"STATS"}).find("Statistics are off.") == 0);
+    run_commands(s, {"STATS ON", "STRUCT a char int", "DESCRIBIR a", "DESCRIBIR a RESUMEN", "REPORTE", "IMPRIMIR a", "FOO"});
+    string stats = run_commands(s, {"STATS"});
+    run_commands(s, {"STATS OFF"});
+    command_stats_registry.by_command.clear();
+
+    CHECK(stats.find("  DESCRIBIR: 2 calls, p50 ") != string::npos);
+    CHECK(stats.find("  STRUCT: 1 call, p50 ") != string::npos);
+    CHECK(stats.find("  (unknown): 1 call") != string::npos);
+    size_t describe = stats.find("  DESCRIBIR:");
+    string line = stats.substr(describe, stats.find('\n', describe) - describe);
+    CHECK(line.find(" 0 lookups") == string::npos);
+    CHECK(line.find(" 0 allocations") == string::npos);
+    CHECK(line.find(" 0 layout bytes") == string::npos);
+
+    // Los comandos que solo leen la tabla tambien cuentan sus busquedas
+    for (const string command : {"  REPORTE:", "  IMPRIMIR:"}) {
+        size_t start = stats.find(command);
+        REQUIRE(start != string::npos);
+        CHECK(stats.substr(start, stats.find('\n', start) - start).find(" 0 lookups") == string::npos);
+    }
+
+    // Apagadas no se registra nada
+    run_commands(s, {"DESCRIBIR a"});
+    CHECK(command_stats_registry.by_command.empty());
+}
+
+TEST_CASE("OBJETIVO rechaza palabra, alineacion u override fuera del rango de int") {
+    setup_basic_atomics();
+    targets_arr.clear();
+    session s;
+    CHECK(run_commands(s, {"OBJETIVO x 99999999999 4"}) == "Error: Word size or max alignment out of range. Try again.\n");
+    CHECK(run_commands(s, {"OBJETIVO x 4 4 int:4:99999999999"}) == "Error: Alignment out of range in override 'int:4:99999999999'.\n");
+    CHECK(run_commands(s, {"OBJETIVO x 4 4 int:4:4"}) == "Target x created successfully!\n");
+    targets_arr.clear();
+}
@@ -0,0 +1,212 @@
+#ifndef TRANSACTION_HPP
+#define TRANSACTION_HPP
+
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include "Functions.hpp"
+
+/**
+ * Definition of a type as given by the user, before its size and alignment are computed.
+ *
+ * Only the members of its kind are used: size and align for atomic types, fields and align for structs and unions (where
+ * align is the cap set by #pragma pack, 0 for none), bits and unit for bitfields and tag and fields for variants.
+ */
+struct type_definition {
+    AtomicKind kind = ATOMIC;
+    string name = "";
+    long long size = 0;
+    int align = 0;
+    int bits = 0;
+    string unit = "";
+    string tag = "";
+    vector<string> fields = {};
+};
+
+/**
+ * Definitions staged between BEGIN and COMMIT.
+ */
+struct transaction {
+    bool active = false;
+    vector<type_definition> staged;
+};
+
+/**
+ * Names of the types a definition refers to.
+ *
+ * @param def Type definition.
+ * @return the field types, storage unit or tag of the definition.
+ */
+vector<string> definition_dependencies(const type_definition& def) {
+    vector<string> dependencies = def.fields;
+    if (def.kind == BITFIELD) dependencies.push_back(def.unit);
+    if (def.kind == VARIANT) dependencies.push_back(def.tag);
+    return dependencies;
+}
+
+/**
+ * Adds a definition to the type table, computing its size and alignment.
+ *
+ * @param arr Type table.
+ * @param def Type definition.
+ */
+void apply_definition(map<string, atomic_type>& arr, const type_definition& def) {
+    switch (def.kind) {
+        case ATOMIC: push_atomic(arr, def.name, def.size, def.align); break;
+        case STRUCT: push_struct(arr, def.name, def.fields, def.align); break;
+        case UNION: push_union(arr, def.name, def.fields, def.align); break;
+        case BITFIELD: push_bitfield(arr, def.name, def.bits, def.unit); break;
+        case VARIANT: push_variant(arr, def.name, def.tag, def.fields); break;
+    }
+}
+
+/**
+ * Starts a transaction. Until it's committed or rolled back, definitions are staged instead of added to the type table.
+ *
+ * @param tx Transaction.
+ */
+void begin_transaction(transaction& tx) {
+    if (tx.active) {
+        throw runtime_error("Error: A transaction is already open.");
+    }
+    tx.active = true;
+    tx.staged.clear();
+}
+
+/**
+ * Stages a definition. Nothing is validated against the type table nor computed until COMMIT.
+ *
+ * @param tx Open transaction.
+ * @param def Type definition.
+ */
+void stage_definition(transaction& tx, type_definition def) {
+    tx.staged.push_back(move(def));
+}
+
+/**
+ * Orders the staged definitions so that each type comes after the staged types it refers to.
+ *
+ * When a name is defined more than once only its last definition is kept. References to types that aren't staged must
+ * be in the type table. Takes linear time over the definitions and their references.
+ *
+ * @param staged Definitions in the order they were staged.
+ * @return the definitions to apply, in dependency order.
+ */
+vector<type_definition> order_staged_definitions(const vector<type_definition>& staged) {
+    unordered_map<string, size_t> last;
+    last.reserve(staged.size());
+    for (size_t i = 0; i < staged.size(); i++) {
+        last[staged[i].name] = i;
+    }
+
+    // Cada definicion que sobrevive, con sus dependencias ya validadas. Los indices son densos, asi que las aristas y
+    // el estado de cada definicion se guardan en vectores
+    vector<size_t> kept;
+    vector<vector<size_t>> edges(staged.size());
+    for (size_t i = 0; i < staged.size(); i++) {
+        if (last.find(staged[i].name)->second != i) continue;
+        kept.push_back(i);
+        for (const auto& dependency : definition_dependencies(staged[i])) {
+            if (dependency == staged[i].name) {
+                throw runtime_error("Error: Recursive declaration of type '" + dependency + "'");
+            }
+            auto found = last.find(dependency);
+            if (found != last.end()) {
+                edges[i].push_back(found->second);
+            } else if (find_type(types_arr, dependency) == nullptr) {
+                throw runtime_error("Error: Type '" + dependency + "' not found in type table.");
+            }
+        }
+    }
+
+    // Orden topologico con DFS iterativo: 0 sin visitar, 1 en la pila, 2 terminado
+    vector<type_definition> ordered;
+    ordered.reserve(kept.size());
+    vector<int> state(staged.size(), 0);
+    for (size_t root : kept) {
+        if (state[root] != 0) continue;
+        vector<pair<size_t, size_t>> stack = {{root, 0}};
+        state[root] = 1;
+        while (!stack.empty()) {
+            auto& [node, next] = stack.back();
+            const vector<size_t>& children = edges[node];
+            if (next < children.size()) {
+                size_t child = children[next++];
+                if (state[child] == 1) {
+                    throw runtime_error("Error: Recursive declaration of type '" + staged[child].name + "'");
+                }
+                if (state[child] == 0) {
+                    state[child] = 1;
+                    stack.push_back({child, 0});
+                }
+            } else {
+                state[node] = 2;
+                ordered.push_back(staged[node]);
+                stack.pop_back();
+            }
+        }
+    }
+
+    return ordered;
+}
+
+/**
+ * Validates the staged definitions together and adds them to the type table, computing each type once.
+ *
+ * Either every definition is applied or, if any of them fails, the type table is left as it was and the transaction stays
+ * open.
+ *
+ * @param tx Open transaction.
+ * @param on_commit Called with the definitions in the order they were applied, before the transaction is closed. If it
+ * throws the commit fails like if a definition had failed.
+ * @return number of types added or redefined.
+ */
+size_t commit_transaction(transaction& tx, const function<void(const vector<type_definition>&)>& on_commit = nullptr) {
+    if (!tx.active) {
+        throw runtime_error("Error: No transaction is open.");
+    }
+
+    vector<type_definition> ordered = order_staged_definitions(tx.staged);
+
+    vector<pair<string, optional<atomic_type>>> previous;
+    previous.reserve(ordered.size());
+    try {
+        for (const auto& def : ordered) {
+            const atomic_type* found = find_type(types_arr, def.name);
+            previous.push_back({def.name, found == nullptr ? nullopt : optional<atomic_type>(*found)});
+            apply_definition(types_arr, def);
+        }
+        if (on_commit) on_commit(ordered);
+    } catch (...) {
+        // Se deshace en orden inverso para dejar la tabla como estaba
+        for (auto it = previous.rbegin(); it != previous.rend(); ++it) {
+            if (it->second) {
+                types_arr[it->first] = *it->second;
+            } else {
+                types_arr.erase(it->first);
+            }
+        }
+        throw;
+    }
+
+    tx.active = false;
+    tx.staged.clear();
+    return ordered.size();
+}
+
+/**
+ * Discards the staged definitions without touching the type table.
+ *
+ * @param tx Open transaction.
+ * @return number of definitions discarded.
+ */
+size_t rollback_transaction(transaction& tx) {
+    if (!tx.active) {
+        throw runtime_error("Error: No transaction is open.");
+    }
+    size_t discarded = tx.staged.size();
+    tx.active = false;
+    tx.staged.clear();
+    return discarded;
+}
+#endif
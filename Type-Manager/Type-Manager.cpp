@@ -1,193 +1,102 @@
-#include <iostream>
-#include <string>
-#include <vector>
-#include <map>
-#include <tuple>
-#include <algorithm>
-#include <variant>
-#include <sstream>
-#include <cmath>
-#include <numeric>
-#include "Functions.hpp"
-
-int main() {
-    string line;
-    int word_size = 4; // Tamaño de palabra en bytes (32 bits)
-    map<string, int> cmd_available = {
-        {"ATOMICO", 1},
-        {"STRUCT", 2},
-        {"UNION", 3}, 
-        {"DESCRIBIR", 4}, 
-        {"SALIR", 5},
-        {"IMPRIMIR", 6}
-    };
-    vector<string> tokens;
-    string cmd;
-    cout << "Enter command:" << endl;
-    while (true) {
-        cout << "> ";
-        getline(cin, line);
-        tokens = split(line);
-
-        if (tokens.size() == 0) {
-            cout << "Error: Empty command. Try again." << endl;
-            continue;
-        }
-
-        cmd = tokens[0];
-
-        switch (cmd_available[cmd]){
-            case 1:{
-                try {
-                    if (tokens.size() != 4) {
-                        throw runtime_error("Error: Wrong number of arguments for ATOMIC type.\nUsage: ATOMIC <nombre> <representacion> <alineacion>.");
-                    }
-
-                    string field1 = tokens[1];
-
-                    if (!is_integer(tokens[2]) || !is_integer(tokens[3])){
-                        throw runtime_error("Error: Non-integer type for size or alignment. Try again.");
-                    }
-                    
-                    int field2 = stoi(tokens[2]);
-
-                    if (field2 <= 0) {
-                        throw runtime_error("Error: Size must be a positive integer. Try again.");
-                    }
-
-                    int field3 = stoi(tokens[3]);
-
-                    if (field3 <= 0) {
-                        throw runtime_error("Error: Alignment must be a positive integer. Try again.");
-                    }
-                    
-                    push_atomic(types_arr, field1, field2, field3);
-                    
-                    cout << "ATOMIC type " << field1 << " created successfully!"<< endl;
-                    
-                } catch (exception& e) {
-                    cout << e.what() << endl;
-                }
-                break;
-            }
-            case 2:{
-                try {
-                    if (tokens.size() < 3) {
-                        throw runtime_error("Error: Wrong number of arguments for STRUCT type.\nUsage: STRUCT <nombre> [<tipo>].");
-                    }
-                    string struct_name = tokens[1];
-                    vector<string> field_types;
-                    
-
-                    // Iteramos desde el tercer token
-                    for (size_t i = 2; i < tokens.size(); i++) {
-
-                        // Verificamos que exista en el mapa global types_arr
-                        if (types_arr.find(tokens[i]) == types_arr.end()) {
-                            throw runtime_error("Error: Type '" + tokens[i] + "' not found in type table.");
-                        }
-
-                        // Si existe, lo agregamos a la lista
-                        field_types.push_back(tokens[i]);
-                    }
-
-                    // Si todos existen, creamos el struct
-                    push_struct(types_arr, struct_name, field_types);
-
-                    cout << "STRUCT type " << struct_name << " created successfully!"<< endl;
-
-                } catch (exception& e) {
-                    cout << e.what() << endl;
-                }
-                break;
-            }
-            case 3: {
-                try {
-                    if (tokens.size() < 3) {
-                        throw runtime_error("Error: Wrong number of arguments for UNION type.\nUsage: UNION <nombre> [<tipo>].");
-                    }
-                    string struct_name = tokens[1];
-                    vector<string> field_types;
-
-                    // Iteramos desde el tercer token
-                    for (size_t i = 2; i < tokens.size(); i++) {
-
-                        // Verificamos que exista en el mapa global types_arr
-                        if (types_arr.find(tokens[i]) == types_arr.end()) {
-                            throw runtime_error("Error: Type '" + tokens[i] + "' not found in type table.");
-                        }
-
-                        // Si existe, lo agregamos a la lista
-                        field_types.push_back(tokens[i]);
-                    }
-
-                    // Si todos existen, creamos el struct
-                    push_union(types_arr, struct_name, field_types);
-
-                    cout << "UNION type " << struct_name << " created successfully!"<< endl;
-
-                } catch (exception& e) {
-                    cout << e.what() << endl;
-                }
-                break;
-            }
-            case 4: {
-                try
-                {
-                    if (tokens.size() != 2) {
-                        throw runtime_error("Error: Wrong number of arguments for DESCRIBIR command.\nUsage: DESCRIBIR <nombre>.");
-                    }
-
-                    string type_name = tokens[1];
-
-                    if (types_arr.find(type_name) == types_arr.end()) {
-                        throw runtime_error("Error: Type '" + type_name + "' not found in type table.");
-                    }
-
-                    atomic_type type = types_arr[type_name];
-
-                    switch (type.kind) {
-                        case ATOMIC: {
-                            const aatomic& a = get<aatomic>(type.at);
-                            print_atomic(a, word_size);
-                            break;
-                        }
-                        case STRUCT: {
-                            const atomic_struct& s = get<atomic_struct>(type.at);
-                            cout << "Strategy without packing: " << endl;
-                            print_struct_wt_packing(s, word_size);
-                            cout << "Strategy with packing: " << endl;
-                            print_struct_w_packing(s, word_size);
-                            cout << "Strategy with heuristics respecting alignment: " << endl;
-                            print_struct_heuristics(s, word_size);
-                            break;
-                        }
-
-                        case UNION: {
-                            const atomic_union& u = get<atomic_union>(type.at);
-                            print_union(u, word_size);
-                            break;
-                        }
-                    }
-                }
-                catch(const exception& e){
-                    cout << e.what() << '\n';
-                }
-                break;
-            }
-            case 5:
-                cout << "Saliendo del programa." << endl;
-                return 0;
-            case 6:
-                print_types();
-                break;
-            default:
-                cout << "Error: unknown command." << endl;
-                cout << "Available commands: \nATOMICO, STRUCT, UNION, DESCRIBIR, SALIR." << endl;
-                break;
-        }
-    }
-
-    return 0;
-}
-
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <variant>
+#include <sstream>
+#include <cmath>
+#include <numeric>
+#include <climits>
+#include "Functions.hpp"
+#include "Output.hpp"
+#include "Pipeline.hpp"
+#include "Interpreter.hpp"
+#include "Journal.hpp"
+#include "Server.hpp"
+
+int main(int argc, char* argv[]) {
+    session s;
+    // Sin sincronizar con stdio cin lee por bloques y se puede saber cuanto queda en su buffer
+    ios::sync_with_stdio(false);
+
+    // La salida se acumula y se escribe al pedir el siguiente comando
+    fd_sink stdout_sink(STDOUT_FILENO);
+    stream_redirect redirect(cout, &stdout_sink);
+
+    // Opciones: --secuencial, --segmentado, --servidor <socket>, --diario <directorio>, --estadisticas
+    // La lectura en paralelo no mejora a la secuencial en las mediciones, asi que solo se usa si se pide
+    bool sequential = true;
+    bool stats = false;
+    string socket_path;
+    string journal_dir;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--secuencial") {
+            sequential = true;
+        } else if (option == "--segmentado") {
+            sequential = false;
+        } else if (option == "--servidor" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (option == "--diario" && i + 1 < argc) {
+            journal_dir = argv[++i];
+        } else if (option == "--estadisticas") {
+            stats = true;
+        } else {
+            cout << "Usage: Type-Manager [--secuencial | --segmentado] [--servidor <socket>] [--diario <directorio>] [--estadisticas]" << '\n';
+            return 1;
+        }
+    }
+
+    // Con --estadisticas se registran los comandos desde el inicio y se imprimen al salir
+    set_command_stats(stats);
+
+    // Con diario, la tabla de tipos se recupera de la ultima instantanea y lo registrado despues
+    unique_ptr<journal> wal;
+    if (!journal_dir.empty()) {
+        try {
+            wal = make_unique<journal>(journal_dir);
+            print_recovery_report(wal->recover(types_arr));
+            s.wal = wal.get();
+        } catch (exception& e) {
+            cout << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    // Modo servidor: la tabla de tipos se comparte entre los clientes del socket
+    if (!socket_path.empty()) {
+        try {
+            type_server server(socket_path, cout, wal.get());
+            signal(SIGINT, interrupt_server);
+            signal(SIGTERM, interrupt_server);
+            server.run();
+        } catch (exception& e) {
+            cout << e.what() << '\n';
+            return 1;
+        }
+        if (stats) print_command_stats();
+        return 0;
+    }
+
+    // Con --segmentado, lectura y tokenizacion corren en paralelo con la ejecucion
+    command_source source(cin, cout, AVAILABLE_COMMANDS, !sequential);
+    parsed_command command;
+
+    cout << "Enter command:" << '\n';
+    while (true) {
+        cout << "> ";
+        if (!source.next(command)) {
+            break;
+        }
+        if (!execute_command(command, s, cout)) {
+            break;
+        }
+    }
+
+    if (stats) print_command_stats();
+
+    return 0;
+}
+
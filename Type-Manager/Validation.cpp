@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include "Functions.hpp"
+#include "Validation.hpp"
+
+int main(int argc, char* argv[]) {
+    // Opciones: --casos <n>, --lote <n>, --semilla <n>, --hilos <n>, --sin-uniones, --compilador <comando>
+    validation_options options;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--casos" && has_value && is_integer(argv[i + 1])) {
+            options.cases = stoll(argv[++i]);
+        } else if (option == "--lote" && has_value && is_integer(argv[i + 1])) {
+            options.batch = stoll(argv[++i]);
+        } else if (option == "--semilla" && has_value && is_integer(argv[i + 1])) {
+            options.seed = (unsigned) stoll(argv[++i]);
+        } else if (option == "--hilos" && has_value && is_integer(argv[i + 1])) {
+            options.jobs = (size_t) stoll(argv[++i]);
+        } else if (option == "--sin-uniones") {
+            options.unions = false;
+        } else if (option == "--compilador" && has_value) {
+            options.compiler = argv[++i];
+        } else {
+            cout << "Usage: Validation [--casos <n>] [--lote <n>] [--semilla <n>] [--hilos <n>] [--sin-uniones] [--compilador <comando>]" << '\n';
+            return 1;
+        }
+    }
+
+    try {
+        print_validation_report(run_validation(options));
+    } catch (exception& e) {
+        cout << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,417 @@
+#ifndef VALIDATION_HPP
+#define VALIDATION_HPP
+
+#include <random>
+#include <set>
+#include <cstdio>
+#include <cstdlib>
+#include "Functions.hpp"
+#include "Racing.hpp"
+#include "Export.hpp"
+#include "Transaction.hpp"
+#include "Journal.hpp"
+
+/**
+ * C type used as an atomic type by the validation cases, with the size and alignment it has for the compiler that built
+ * this program. They are taken from the compiler instead of written by hand so the cases only test the layout rules.
+ */
+struct validation_primitive {
+    string name;
+    string spelling;
+    long long size;
+    int align;
+};
+
+const vector<validation_primitive> VALIDATION_PRIMITIVES = {
+    {"char", "char", sizeof(char), alignof(char)},
+    {"short", "short", sizeof(short), alignof(short)},
+    {"int", "int", sizeof(int), alignof(int)},
+    {"long", "long", sizeof(long), alignof(long)},
+    {"long_long", "long long", sizeof(long long), alignof(long long)},
+    {"float", "float", sizeof(float), alignof(float)},
+    {"double", "double", sizeof(double), alignof(double)},
+    {"long_double", "long double", sizeof(long double), alignof(long double)},
+    {"bool", "bool", sizeof(bool), alignof(bool)},
+    {"ptr", "void*", sizeof(void*), alignof(void*)},
+};
+
+/**
+ * Options of a validation run.
+ *
+ * Cases are compiled in batches of batch cases per translation unit, jobs batches at a time. Each case is a random graph
+ * of up to max_types structs (and unions, if unions is set) with up to max_fields fields each, whose fields are
+ * primitives, arrays of primitives or the aggregates defined before them in the same case.
+ */
+struct validation_options {
+    long long cases = 1000;
+    long long batch = 100;
+    unsigned seed = 1;
+    size_t jobs = max(thread::hardware_concurrency(), 1u);
+    int max_types = 4;
+    int max_fields = 6;
+    bool unions = true;
+    string compiler = "g++";
+};
+
+/**
+ * Type of a validation case, with the layout the type table gives it.
+ *
+ * leaves holds the member designators of its atomic fields in flattened declaration order, as offsetof takes them.
+ * expected maps each strategy checked to its values: size (the stride, as sizeof), alignment and the offset of each leaf.
+ * Unions and "table" (the size and alignment stored in the type table) only check size and alignment.
+ */
+struct validation_type {
+    string name;
+    AtomicKind kind = STRUCT;
+    vector<string> leaves;
+    vector<pair<string, vector<long long>>> expected;
+};
+
+/**
+ * Random case: the C declarations of its types and the types to check.
+ */
+struct validation_case {
+    long long id = 0;
+    vector<string> declarations;
+    vector<validation_type> types;
+};
+
+/**
+ * Result of a validation run. mismatches counts the types whose layout differs from the compiler by strategy and examples
+ * describes the first ones found, one per case, with the declarations that reproduce them.
+ */
+struct validation_report {
+    long long cases = 0;
+    long long types = 0;
+    long long batches = 0;
+    map<string, long long> mismatches;
+    vector<string> examples;
+    double elapsed_ms = 0;
+};
+
+/**
+ * Generates a random case and computes its layouts with the type table.
+ *
+ * Its types are added to the type table to compute the layouts and removed afterwards, leaving the table as it was. Every
+ * name is prefixed with "v<id>_" so the cases of a batch don't collide.
+ *
+ * @param id Number of the case, used with the seed to make it reproducible.
+ * @param options Options of the run.
+ * @return the case.
+ */
+validation_case generate_validation_case(long long id, const validation_options& options) {
+    mt19937_64 random(options.seed * 1000003ULL + id);
+    auto pick = [&random](long long low, long long high) {
+        return uniform_int_distribution<long long>(low, high)(random);
+    };
+
+    validation_case vcase;
+    vcase.id = id;
+    string prefix = "v" + to_string(id) + "_";
+    vector<type_definition> definitions;
+    set<string> declared;
+    vector<string> aggregates;
+
+    // Los primitivos y arreglos se declaran con typedef la primera vez que se usan
+    auto atomic_field = [&]() {
+        const validation_primitive& primitive = VALIDATION_PRIMITIVES[pick(0, VALIDATION_PRIMITIVES.size() - 1)];
+        string name = prefix + primitive.name;
+        if (declared.insert(name).second) {
+            vcase.declarations.push_back("typedef " + primitive.spelling + " " + name + ";");
+            definitions.push_back(type_definition{ATOMIC, name, primitive.size, primitive.align});
+        }
+        if (pick(0, 3) != 0) return name;
+
+        long long count = pick(2, 5);
+        string array = name + "_x" + to_string(count);
+        if (declared.insert(array).second) {
+            vcase.declarations.push_back("typedef " + name + " " + array + "[" + to_string(count) + "];");
+            definitions.push_back(type_definition{ATOMIC, array, primitive.size * count, primitive.align});
+        }
+        return array;
+    };
+
+    int num_types = (int) pick(1, options.max_types);
+    for (int t = 0; t < num_types; t++) {
+        bool is_union = options.unions && pick(0, 4) == 0;
+        string name = prefix + (is_union ? "u" : "s") + to_string(t);
+        type_definition def{is_union ? UNION : STRUCT, name};
+        string declaration = string(is_union ? "union " : "struct ") + name + " {";
+        int num_fields = (int) pick(1, options.max_fields);
+        for (int f = 0; f < num_fields; f++) {
+            string field = !aggregates.empty() && pick(0, 2) == 0 ? aggregates[pick(0, aggregates.size() - 1)] : atomic_field();
+            def.fields.push_back(field);
+            declaration += " " + field + " f" + to_string(f) + ";";
+        }
+        vcase.declarations.push_back(declaration + " };");
+        definitions.push_back(def);
+        aggregates.push_back(name);
+    }
+
+    vector<pair<string, optional<atomic_type>>> previous;
+    for (const auto& def : definitions) {
+        const atomic_type* found = find_type(types_arr, def.name);
+        previous.push_back({def.name, found == nullptr ? nullopt : optional<atomic_type>(*found)});
+    }
+    try {
+        for (const auto& def : definitions) {
+            apply_definition(types_arr, def);
+        }
+
+        for (const auto& name : aggregates) {
+            validation_type type;
+            type.name = name;
+            const atomic_type& aggregate = lookup_type(types_arr, name);
+            type.kind = aggregate.kind;
+            if (type.kind == UNION) {
+                const atomic_union& at = get<atomic_union>(aggregate.at);
+                union_layout layout = compute_union_layout(at, OPAQUE);
+                type.expected.push_back({"union", {layout.size, layout.align}});
+                type.expected.push_back({"table", {at.size, at.align}});
+                vcase.types.push_back(type);
+                continue;
+            }
+
+            // Designadores de los campos atomicos en el mismo orden que collect_struct_fields
+            function<void(const string&, const string&)> flatten = [&](const string& type_name, const string& path) {
+                const atomic_struct& at = get<atomic_struct>(lookup_type(types_arr, type_name).at);
+                for (size_t f = 0; f < at.fields.size(); f++) {
+                    string member = path + "f" + to_string(f);
+                    if (lookup_type(types_arr, at.fields[f]).kind == STRUCT) {
+                        flatten(at.fields[f], member + ".");
+                    } else {
+                        type.leaves.push_back(member);
+                    }
+                }
+            };
+            flatten(name, "");
+
+            const atomic_struct& at = get<atomic_struct>(aggregate.at);
+            for (const auto& [strategy_name, strategy] : vector<pair<string, LayoutStrategy>>{{"unpacked", UNPACKED}, {"opaque", OPAQUE}}) {
+                struct_layout layout = compute_struct_layout(at, strategy);
+                vector<long long> values = {layout.stride, layout.align};
+                values.resize(2 + type.leaves.size(), -1);
+                for (const auto& slot : layout.slots) {
+                    if (slot.id >= 0 && slot.id < (long long) type.leaves.size()) values[2 + slot.id] = slot.offset;
+                }
+                type.expected.push_back({strategy_name, values});
+            }
+            type.expected.push_back({"table", {at.size, at.align}});
+            vcase.types.push_back(type);
+        }
+    } catch (...) {
+        for (auto it = previous.rbegin(); it != previous.rend(); ++it) {
+            if (it->second) types_arr[it->first] = *it->second;
+            else types_arr.erase(it->first);
+        }
+        throw;
+    }
+    for (auto it = previous.rbegin(); it != previous.rend(); ++it) {
+        if (it->second) types_arr[it->first] = *it->second;
+        else types_arr.erase(it->first);
+    }
+    return vcase;
+}
+
+/**
+ * Writes a program that prints, for each type of the cases, a line with its name, sizeof, alignof and the offsetof of each
+ * of its leaves.
+ *
+ * @param cases Cases of a batch.
+ * @return source code of the program.
+ */
+string emit_validation_program(const vector<validation_case>& cases) {
+    string source = "#include <cstdio>\n#include <cstddef>\n\n";
+    for (const auto& vcase : cases) {
+        for (const auto& declaration : vcase.declarations) {
+            source += declaration + "\n";
+        }
+    }
+
+    source += "\nint main() {\n";
+    for (const auto& vcase : cases) {
+        for (const auto& type : vcase.types) {
+            string format = type.name + " %zu %zu";
+            string arguments = "sizeof(" + type.name + "), alignof(" + type.name + ")";
+            for (const auto& leaf : type.leaves) {
+                format += " %zu";
+                arguments += ", offsetof(" + type.name + ", " + leaf + ")";
+            }
+            source += "    std::printf(\"" + format + "\\n\", " + arguments + ");\n";
+        }
+    }
+    source += "    return 0;\n}\n";
+    return source;
+}
+
+/**
+ * Compiles and runs the program of a batch and compares what it prints with the layouts of its cases.
+ *
+ * @param cases Cases of the batch.
+ * @param directory Directory where the program is written and built.
+ * @param number Number of the batch, used to name its files.
+ * @param options Options of the run.
+ * @return report of the batch.
+ */
+validation_report run_validation_batch(const vector<validation_case>& cases, const string& directory, long long number,
+                                       const validation_options& options) {
+    string base = directory + "/batch" + to_string(number);
+    write_buffer(base + ".cpp", emit_validation_program(cases));
+
+    auto remove_files = [&base]() {
+        ::unlink((base + ".cpp").c_str());
+        ::unlink((base + ".log").c_str());
+        ::unlink(base.c_str());
+    };
+
+    string command = options.compiler + " -std=c++17 -w -o " + base + " " + base + ".cpp 2> " + base + ".log";
+    if (system(command.c_str()) != 0) {
+        string log;
+        read_buffer(base + ".log", log);
+        remove_files();
+        throw runtime_error("Error: Compiler failed on validation batch " + to_string(number) + ": " + log.substr(0, log.find('\n')));
+    }
+
+    FILE* program = popen(base.c_str(), "r");
+    if (!program) {
+        remove_files();
+        throw runtime_error("Error: Can't run validation batch " + to_string(number) + ".");
+    }
+    string output;
+    char buffer[1 << 12];
+    size_t received;
+    while ((received = fread(buffer, 1, sizeof(buffer), program)) > 0) {
+        output.append(buffer, received);
+    }
+    pclose(program);
+    remove_files();
+
+    map<string, vector<long long>> actual;
+    istringstream lines(output);
+    string line;
+    while (getline(lines, line)) {
+        vector<string> tokens = split(line);
+        if (tokens.empty()) continue;
+        vector<long long>& values = actual[tokens[0]];
+        for (size_t i = 1; i < tokens.size(); i++) values.push_back(stoll(tokens[i]));
+    }
+
+    validation_report report;
+    report.cases = cases.size();
+    report.batches = 1;
+    for (const auto& vcase : cases) {
+        // Los tipos de un caso suelen fallar por la misma razon: solo se describe el primero
+        bool described = false;
+        for (const auto& type : vcase.types) {
+            report.types++;
+            auto found = actual.find(type.name);
+            for (const auto& [strategy, expected] : type.expected) {
+                if (found == actual.end() || found->second.size() < expected.size()) {
+                    report.mismatches[strategy]++;
+                    report.examples.push_back(type.name + " (" + strategy + "): missing from the compiler output");
+                    continue;
+                }
+                const vector<long long>& values = found->second;
+                string difference;
+                if (expected[0] != values[0]) {
+                    difference = "size " + to_string(expected[0]) + ", compiler " + to_string(values[0]);
+                } else if (expected[1] != values[1]) {
+                    difference = "align " + to_string(expected[1]) + ", compiler " + to_string(values[1]);
+                } else {
+                    for (size_t i = 2; i < expected.size(); i++) {
+                        if (expected[i] != values[i]) {
+                            difference = "offset of " + type.leaves[i - 2] + " " + to_string(expected[i]) + ", compiler "
+                                + to_string(values[i]);
+                            break;
+                        }
+                    }
+                }
+                if (difference.empty()) continue;
+                report.mismatches[strategy]++;
+                if (described) continue;
+                described = true;
+                string declarations;
+                for (const auto& declaration : vcase.declarations) declarations += "\n    " + declaration;
+                report.examples.push_back(type.name + " (" + strategy + "): " + difference + declarations);
+            }
+        }
+    }
+    return report;
+}
+
+/**
+ * Checks the layouts of the type table against the ones of a real compiler.
+ *
+ * Random cases are generated and laid out with the type table (sequentially, since it's shared), then emitted as C++ and
+ * compiled in batches by a pool of jobs threads, each batch reading back sizeof, alignof and offsetof of its types. The
+ * unpacked and opaque strategies of every struct and the layout of every union are compared with them.
+ *
+ * @param options Options of the run.
+ * @param max_examples Number of mismatches described in the report.
+ * @return report of the run.
+ */
+validation_report run_validation(const validation_options& options, size_t max_examples = 5) {
+    auto started = chrono::steady_clock::now();
+
+    char directory_template[] = "/tmp/type-manager-validation-XXXXXX";
+    if (!mkdtemp(directory_template)) {
+        throw runtime_error("Error: Can't create validation directory: " + string(strerror(errno)) + ".");
+    }
+    string directory = directory_template;
+
+    validation_report report;
+    mutex m;
+    string failure;
+    {
+        thread_pool pool(options.jobs);
+        long long batch_size = max(options.batch, 1LL);
+        for (long long first = 0, number = 0; first < options.cases; first += batch_size, number++) {
+            auto cases = make_shared<vector<validation_case>>();
+            for (long long id = first; id < min(options.cases, first + batch_size); id++) {
+                cases->push_back(generate_validation_case(id, options));
+            }
+            pool.submit([&, cases, number]() {
+                try {
+                    validation_report batch = run_validation_batch(*cases, directory, number, options);
+                    lock_guard<mutex> lock(m);
+                    report.cases += batch.cases;
+                    report.types += batch.types;
+                    report.batches += batch.batches;
+                    for (const auto& [strategy, count] : batch.mismatches) report.mismatches[strategy] += count;
+                    for (auto& example : batch.examples) {
+                        if (report.examples.size() < max_examples) report.examples.push_back(move(example));
+                    }
+                } catch (exception& e) {
+                    lock_guard<mutex> lock(m);
+                    if (failure.empty()) failure = e.what();
+                }
+            });
+        }
+    }
+    ::rmdir(directory.c_str());
+    if (!failure.empty()) throw runtime_error(failure);
+
+    report.elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    return report;
+}
+
+/**
+ * Prints the result of a validation run.
+ *
+ * @param report Report of the run.
+ * @param out Stream where the output is written.
+ */
+void print_validation_report(const validation_report& report, ostream& out = cout) {
+    double per_minute = report.elapsed_ms > 0 ? report.cases * 60000.0 / report.elapsed_ms : 0;
+    out << "Validated " << report.cases << " cases (" << report.types << " types, " << report.batches << " programs) in "
+        << (long long) report.elapsed_ms << " ms, " << (long long) per_minute << " cases per minute." << '\n';
+    for (const string strategy : {"unpacked", "opaque", "union", "table"}) {
+        auto found = report.mismatches.find(strategy);
+        long long count = found == report.mismatches.end() ? 0 : found->second;
+        out << "  " << strategy << ": " << count << " mismatches" << '\n';
+    }
+    for (const auto& example : report.examples) {
+        out << "Mismatch: " << example << '\n';
+    }
+}
+#endif